@@ -3,9 +3,18 @@
 #include <models/Corpus.h>
 #include <ExchangeAlgorithm/Exchange/Exchange.h>
 #include <ExchangeAlgorithm/StochasticExchange/StochasticExchange.h>
+#include <ExchangeAlgorithm/StochasticExchange/StochasticExchangeEnsemble.h>
+#include <ExchangeAlgorithm/MultilevelExchange/MultilevelExchange.h>
+#include <ExchangeAlgorithm/DistributedExchange/DistributedExchange.h>
+#include <NumaPlacement.h>
 #include <json/json.hpp>
 #include <chrono>
+#include <csignal>
 #include <omp.h>
+#include <climits>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "easylogging++/easylogging++.h"
 #include <CLI11.hpp>
 
@@ -18,6 +27,95 @@ using json = nlohmann::json;
 const string ALG_EXCHANGE = "EXCHANGE";
 const string ALG_EXCHANGE_STEPS = "EXCHANGE_STEPS";
 const string ALG_EXCHANGE_STOCHASTIC = "STOCHASTIC_EXCHANGE";
+const string ALG_EXCHANGE_STOCHASTIC_ENSEMBLE = "STOCHASTIC_EXCHANGE_ENSEMBLE";
+const string ALG_EXCHANGE_MULTILEVEL = "MULTILEVEL_EXCHANGE";
+const string ALG_EXCHANGE_DISTRIBUTED = "DISTRIBUTED_EXCHANGE";
+
+extern "C" void requestCheckpointOnSignal(int) {
+    Exchange::requestCheckpoint();
+}
+
+/**
+ * Cancelled on SIGTERM, so that a preempted run stops after the word it is processing and still writes the best
+ * clustering it found.
+ */
+CancellationToken cancellationOnSignal;
+
+extern "C" void cancelOnSignal(const int signal) {
+    cancellationOnSignal.cancel();
+//    a second signal ends the process as usual
+    std::signal(signal, SIG_DFL);
+}
+
+/**
+ * Lets the clustering stop when SIGTERM is received and, for a positive budget, once budget seconds have passed.
+ */
+void setStopConditions(Exchange &exchange, const double budget) {
+    exchange.setCancellationToken(&cancellationOnSignal);
+    if (budget > 0) {
+        exchange.setTimeBudget(duration_cast<steady_clock::duration>(duration<double>(budget)));
+    }
+}
+
+string stopReasonName(const Exchange::StopReason reason) {
+    switch (reason) {
+        case Exchange::DEADLINE:
+            return "deadline";
+        case Exchange::CANCELLED:
+            return "cancelled";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * Starts numWorkers exchange_worker processes, which are built into the same directory as this binary, and lets
+ * them connect to socketPath.
+ * @return the process IDs of the workers
+ */
+vector<pid_t> spawnWorkers(const word_type numWorkers, const string &inputFile, const string &socketPath,
+                           const int numThreads) {
+    char executable[PATH_MAX];
+    const ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length < 0) {
+        throw runtime_error("Could not determine the path of the running binary");
+    }
+    string workerBinary(executable, length);
+    workerBinary = workerBinary.substr(0, workerBinary.find_last_of('/') + 1) + "exchange_worker";
+    const string threads = to_string(numThreads);
+    vector<string> arguments = {workerBinary, "--input", inputFile, "--socket", socketPath, "--threads", threads};
+    vector<char *> argv;
+    for (string &argument : arguments) {
+        argv.push_back(&argument[0]);
+    }
+    argv.push_back(nullptr);
+    vector<pid_t> workers;
+    for (word_type worker = 0; worker < numWorkers; ++worker) {
+        pid_t pid;
+        const int error = posix_spawn(&pid, workerBinary.c_str(), nullptr, nullptr, argv.data(), environ);
+        if (error != 0) {
+            throw runtime_error("Could not start " + workerBinary + ": " + strerror(error));
+        }
+        workers.push_back(pid);
+    }
+    return workers;
+}
+
+/**
+ * Waits for the worker processes to end and returns whether all of them succeeded. With block set to false, only
+ * checks whether one of them has already failed.
+ */
+bool workersSucceeded(const vector<pid_t> &workers, const bool block) {
+    bool succeeded = true;
+    for (const pid_t worker : workers) {
+        int status;
+        const pid_t ended = waitpid(worker, &status, block ? 0 : WNOHANG);
+        if (ended == worker && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+            succeeded = false;
+        }
+    }
+    return succeeded;
+}
 
 int main(int ac, char *av[]) {
 
@@ -28,20 +126,120 @@ int main(int ac, char *av[]) {
     string algorithm;
     double minAMIThreshold = 0.0;
     double percentageRandom = 0.0;
+    bool countDomain = false;
+    bool scalarScoring = false;
+    bool boundPruning = false;
+    word_type batchSize = 1;
+    bool activeSet = false;
+    word_type fullSweepInterval = 0;
+    double activeSetThreshold = 0;
+    string checkpointFile;
+    string telemetryFile;
+    word_type checkpointInterval = 0;
+    double timeBudget = 0;
+    string resumeFile;
+    word_type initialWords = MultilevelExchange::DEFAULT_INITIAL_WORDS;
+    double growthFactor = MultilevelExchange::DEFAULT_GROWTH_FACTOR;
+    word_type stageIterations = MultilevelExchange::DEFAULT_STAGE_ITERATIONS;
+    word_type numWorkers = 2;
+    word_type workerThreads = 0;
+    word_type roundsPerIteration = DistributedExchange::DEFAULT_ROUNDS_PER_ITERATION;
+    string socketFile;
+    word_type numChains = StochasticExchangeEnsemble::DEFAULT_CHAINS;
+    uint64_t seed = 0;
+    double abandonMargin = StochasticExchangeEnsemble::DEFAULT_ABANDON_MARGIN;
+    word_type graceIterations = StochasticExchangeEnsemble::DEFAULT_GRACE_ITERATIONS;
+    double temperature = 0;
+    string cooling = "GEOMETRIC";
+    double coolingRate = StochasticExchange::DEFAULT_COOLING_RATE;
+    word_type patience = StochasticExchange::DEFAULT_PATIENCE;
+    bool pinThreads = false;
     auto numThreadsToUse = omp_get_max_threads();
     CLI::App app{"Runs the Exchange algorithm and writes out the clusters and AMI values at every iteration"};
     app.set_failure_message(CLI::FailureMessage::help);
     app.add_option("--clusters", numClusters,
                    "The number of desired clusters")->set_default_val("500");
     app.add_option("--algorithm", algorithm,
-                   "Which algorithm to run: EXCHANGE, EXCHANGE_STEPS, or STOCHASTIC_EXCHANGE")->set_default_val(
+                   "Which algorithm to run: EXCHANGE, EXCHANGE_STEPS, STOCHASTIC_EXCHANGE, STOCHASTIC_EXCHANGE_ENSEMBLE, MULTILEVEL_EXCHANGE, or DISTRIBUTED_EXCHANGE")->set_default_val(
             ALG_EXCHANGE);
     app.add_option("--iterations", noIterations, "Number of iterations")->set_default_val("10");
     app.add_option("--minAMI", minAMIThreshold, "Minimum AMI increase per iteration")->set_default_val(
             to_string(ExchangeAlgorithm::DEFAULT_MIN_AMI_CHANGE));
     app.add_option("--randomness", percentageRandom,
-                   "Percentage of times swaps should be random (only applies if algorithm is set to STOCHASTIC_EXCHANGE). Should be floating point numbers in range [0,100].")->set_default_val(
+                   "Percentage of times swaps should be random (only applies if algorithm is set to STOCHASTIC_EXCHANGE or STOCHASTIC_EXCHANGE_ENSEMBLE). Should be floating point numbers in range [0,100].")->set_default_val(
             to_string(0));
+    app.add_flag("--count_domain", countDomain,
+                 "Evaluate the occurrence terms on raw bigram counts with an n log n lookup table instead of on probabilities.");
+    app.add_flag("--scalar_scoring", scalarScoring,
+                 "Score the candidate clusters of a word one at a time instead of with the vectorized kernel.");
+    app.add_flag("--prune", boundPruning,
+                 "Only evaluate the candidate clusters of a word whose upper bound on the AMI change can beat the best candidate. Takes the same moves; has no effect with --scalar_scoring.");
+    app.add_option("--batch_size", batchSize,
+                   "Number of consecutive words scored concurrently against the same clustering. Values above 1 keep more threads busy when the number of clusters is small, but can change the result.")->set_default_val(
+            "1");
+    app.add_flag("--active_set", activeSet,
+                 "After the first iteration, only evaluate words that moved or whose neighbours moved in the previous or current iteration (EXCHANGE and EXCHANGE_STEPS).");
+    app.add_option("--full_sweep_interval", fullSweepInterval,
+                   "With --active_set, evaluate all words every N-th iteration. With 0, all words are only evaluated again once the active words stop moving.")->set_default_val(
+            "0");
+    app.add_option("--active_set_threshold", activeSetThreshold,
+                   "With --active_set, only mark a neighbour of a moved word if their bigrams are at least this fraction of the neighbour's bigrams (e.g. 0.01). With 0, all neighbours are marked.")->set_default_val(
+            "0");
+    app.add_option("--initial_words", initialWords,
+                   "With MULTILEVEL_EXCHANGE, the number of most frequent words that are clustered in the first stage.")->set_default_val(
+            to_string(MultilevelExchange::DEFAULT_INITIAL_WORDS));
+    app.add_option("--growth_factor", growthFactor,
+                   "With MULTILEVEL_EXCHANGE, the factor by which the number of clustered words grows from one stage to the next.")->set_default_val(
+            to_string(MultilevelExchange::DEFAULT_GROWTH_FACTOR));
+    app.add_option("--stage_iterations", stageIterations,
+                   "With MULTILEVEL_EXCHANGE, the maximal number of iterations of every stage but the last one, which runs for up to --iterations.")->set_default_val(
+            to_string(MultilevelExchange::DEFAULT_STAGE_ITERATIONS));
+    app.add_option("--workers", numWorkers,
+                   "With DISTRIBUTED_EXCHANGE, the number of worker processes, each of which clusters a shard of the vocabulary.")->set_default_val(
+            "2");
+    app.add_option("--worker_threads", workerThreads,
+                   "With DISTRIBUTED_EXCHANGE, the number of threads of every worker. With 0, --threads is divided among the workers.")->set_default_val(
+            "0");
+    app.add_option("--rounds", roundsPerIteration,
+                   "With DISTRIBUTED_EXCHANGE, the number of rounds per iteration. Moves of other workers are only seen after the round.")->set_default_val(
+            to_string(DistributedExchange::DEFAULT_ROUNDS_PER_ITERATION));
+    app.add_option("--socket", socketFile,
+                   "With DISTRIBUTED_EXCHANGE, the path of the Unix socket the workers connect to. Defaults to a file in /tmp.");
+    app.add_option("--chains", numChains,
+                   "With STOCHASTIC_EXCHANGE_ENSEMBLE, the number of independent chains; the best clustering of all of them is the result.")->set_default_val(
+            to_string(StochasticExchangeEnsemble::DEFAULT_CHAINS));
+    app.add_option("--seed", seed,
+                   "Seed of the random swaps of STOCHASTIC_EXCHANGE, respectively of the first chain of STOCHASTIC_EXCHANGE_ENSEMBLE (chain c uses seed + c). Taken from std::random_device if not given.");
+    app.add_option("--temperature", temperature,
+                   "With STOCHASTIC_EXCHANGE or STOCHASTIC_EXCHANGE_ENSEMBLE, the initial temperature of simulated annealing in bits of AMI: every word also gets a random proposal, taken instead of its best move with probability exp(-(best AMI change - proposal's AMI change) / temperature). 0 disables annealing.")->set_default_val(
+            "0");
+    app.add_option("--cooling", cooling,
+                   "Cooling schedule of simulated annealing: GEOMETRIC (the temperature is multiplied by --cooling_rate after every iteration) or LINEAR (it drops by --cooling_rate times the initial temperature).")->set_default_val(
+            "GEOMETRIC");
+    app.add_option("--cooling_rate", coolingRate, "See --cooling.")->set_default_val(
+            to_string(StochasticExchange::DEFAULT_COOLING_RATE));
+    app.add_option("--patience", patience,
+                   "With STOCHASTIC_EXCHANGE or STOCHASTIC_EXCHANGE_ENSEMBLE, the clustering is considered converged once its best AMI has not grown by more than --minAMI for this many iterations.")->set_default_val(
+            to_string(StochasticExchange::DEFAULT_PATIENCE));
+    app.add_option("--abandon_margin", abandonMargin,
+                   "With STOCHASTIC_EXCHANGE_ENSEMBLE, a chain whose best AMI trails the best AMI of all chains by more than this is abandoned.")->set_default_val(
+            to_string(StochasticExchangeEnsemble::DEFAULT_ABANDON_MARGIN));
+    app.add_option("--grace_iterations", graceIterations,
+                   "With STOCHASTIC_EXCHANGE_ENSEMBLE, the number of iterations before any chain can be abandoned.")->set_default_val(
+            to_string(StochasticExchangeEnsemble::DEFAULT_GRACE_ITERATIONS));
+    app.add_option("--telemetry", telemetryFile,
+                   "Path of a file to which a JSON line is appended after every iteration, with the words evaluated, candidates scored, moves made, the time spent scoring, moving and waiting for other threads, and the AMI. Not supported for DISTRIBUTED_EXCHANGE and STOCHASTIC_EXCHANGE_ENSEMBLE.");
+    app.add_option("--checkpoint", checkpointFile,
+                   "Path for checkpoints of the clustering. A checkpoint is written every --checkpoint_interval seconds and whenever the process receives SIGUSR1.");
+    app.add_option("--checkpoint_interval", checkpointInterval,
+                   "Seconds between two checkpoints. With 0, checkpoints are only written on SIGUSR1.")->set_default_val(
+            "0");
+    app.add_option("--time_budget", timeBudget,
+                   "Seconds the clustering may run. Once they have passed, or once the process receives SIGTERM, the clustering stops after the word it is processing and the clustering with the highest AMI found so far is written (plus a checkpoint, if --checkpoint is given). With 0, there is no limit. Not supported for DISTRIBUTED_EXCHANGE and STOCHASTIC_EXCHANGE_ENSEMBLE.")->set_default_val(
+            "0");
+    app.add_option("--resume", resumeFile,
+                   "Path to a checkpoint to continue from. The number of clusters is taken from the checkpoint and --iterations counts the iterations before the checkpoint.")->check(
+            CLI::ExistingFile);
     app.add_option("--input", inputFile, "Path to input file containing a corpus object")->required()->check(
             CLI::ExistingFile);
     app.add_option("--output", outputFile,
@@ -52,6 +250,8 @@ int main(int ac, char *av[]) {
     helpMsgThreads += std::to_string(numThreadsToUse);
     helpMsgThreads += ".";
     app.add_option("--threads", numThreadsToUse, helpMsgThreads)->set_default_val(to_string(numThreadsToUse));
+    app.add_flag("--pin_threads", pinThreads,
+                 "Pin every thread to one CPU, filling one NUMA node after the other, so that the threads keep working on the memory of their own node.");
     try {
         app.parse(ac, av);
     } catch (CLI::CallForHelp &e) {
@@ -62,20 +262,89 @@ int main(int ac, char *av[]) {
         return 1;
     }
 
+    if ((ALG_EXCHANGE_MULTILEVEL == algorithm || ALG_EXCHANGE_DISTRIBUTED == algorithm
+         || ALG_EXCHANGE_STOCHASTIC_ENSEMBLE == algorithm)
+        && (!checkpointFile.empty() || !resumeFile.empty())) {
+        cerr << "Checkpoints are not supported for " << algorithm << endl;
+        return 1;
+    }
+    if ((ALG_EXCHANGE_DISTRIBUTED == algorithm || ALG_EXCHANGE_STOCHASTIC_ENSEMBLE == algorithm)
+        && !telemetryFile.empty()) {
+        cerr << "Telemetry is not supported for " << algorithm << endl;
+        return 1;
+    }
+    const bool stoppable = ALG_EXCHANGE_DISTRIBUTED != algorithm && ALG_EXCHANGE_STOCHASTIC_ENSEMBLE != algorithm;
+    if (!stoppable && timeBudget > 0) {
+        cerr << "Time budgets are not supported for " << algorithm << endl;
+        return 1;
+    }
+    if (cooling != "GEOMETRIC" && cooling != "LINEAR") {
+        cerr << "Unknown cooling schedule " << cooling << endl;
+        return 1;
+    }
+    const StochasticExchange::CoolingSchedule coolingSchedule = cooling == "LINEAR" ? StochasticExchange::LINEAR
+                                                                                   : StochasticExchange::GEOMETRIC;
+    if (ALG_EXCHANGE_STOCHASTIC_ENSEMBLE == algorithm && numChains == 0) {
+        cerr << "At least one chain is needed for " << ALG_EXCHANGE_STOCHASTIC_ENSEMBLE << endl;
+        return 1;
+    }
+    if (ALG_EXCHANGE_DISTRIBUTED == algorithm && numWorkers == 0) {
+        cerr << "At least one worker is needed for " << ALG_EXCHANGE_DISTRIBUTED << endl;
+        return 1;
+    }
+
     json experiment_data;
     LOG(INFO) << "Will run with at most " << numThreadsToUse << " thread(s)";
     omp_set_num_threads(numThreadsToUse);
+    if (pinThreads) {
+        LOG(INFO) << "Pinned " << NumaPlacement::pinThreads() << " thread(s) to the CPUs of "
+                  << NumaPlacement::numberOfNodes() << " NUMA node(s)";
+    }
     LOG(INFO) << "Reading corpus from " << inputFile;
-    const Corpus fullCorpus = Corpus::deserializeFromFile(inputFile);
+    const corpus_handle corpusHandle = Corpus::deserializeSharedFromFile(inputFile);
+    const Corpus &fullCorpus = *corpusHandle;
     LOG(INFO) << "Corpus vocabulary size " << fullCorpus.vocabularySize
               << " and length "
               << fullCorpus.corpusLength;
 
+    ExchangeCheckpoint checkpoint;
+    const bool resume = !resumeFile.empty();
+    if (resume) {
+        LOG(INFO) << "Reading checkpoint from " << resumeFile;
+        checkpoint = ExchangeCheckpoint::readFromFile(resumeFile);
+        numClusters = checkpoint.numClusters;
+        LOG(INFO) << "Resuming " << checkpoint.algorithm << " with " << numClusters << " clusters after "
+                  << checkpoint.iteration << " iteration(s) at word " << checkpoint.nextWordID;
+        experiment_data["resumed_from"] = resumeFile;
+        experiment_data["resumed_iteration"] = checkpoint.iteration;
+    }
+    if (!checkpointFile.empty()) {
+        std::signal(SIGUSR1, requestCheckpointOnSignal);
+    }
+    if (stoppable) {
+        std::signal(SIGTERM, cancelOnSignal);
+    }
+
     experiment_data["num_clusters"] = numClusters;
     experiment_data["num_iterations"] = noIterations;
     experiment_data["total_words"] = fullCorpus.vocabularySize;
     experiment_data["algorithm"] = algorithm;
     experiment_data["omp_num_threads"] = numThreadsToUse;
+    experiment_data["pin_threads"] = pinThreads;
+    experiment_data["numa_nodes"] = NumaPlacement::numberOfNodes();
+    experiment_data["count_domain"] = countDomain;
+    experiment_data["scalar_scoring"] = scalarScoring;
+    experiment_data["prune"] = boundPruning;
+    experiment_data["batch_size"] = batchSize;
+    experiment_data["active_set"] = activeSet;
+    experiment_data["full_sweep_interval"] = fullSweepInterval;
+    experiment_data["active_set_threshold"] = activeSetThreshold;
+    if (!telemetryFile.empty()) {
+        experiment_data["telemetry"] = telemetryFile;
+    }
+    if (timeBudget > 0) {
+        experiment_data["time_budget"] = timeBudget;
+    }
 
     high_resolution_clock::time_point startTime, endTime;
     vector_word_type clusterAssignments;
@@ -85,29 +354,163 @@ int main(int ac, char *av[]) {
 
     if (ALG_EXCHANGE == algorithm) {
         LOG(INFO) << "Starting Exchange for single go...";
-        Exchange ea(fullCorpus);
+        Exchange ea(corpusHandle);
+        ea.setCountDomain(countDomain);
+        ea.setVectorizedScoring(!scalarScoring);
+        ea.setBoundPruning(boundPruning);
+        ea.setSpeculativeBatchSize(batchSize);
+        ea.setActiveSetScheduling(activeSet);
+        ea.setFullSweepInterval(fullSweepInterval);
+        ea.setActiveSetThreshold(activeSetThreshold);
+        if (!checkpointFile.empty()) {
+            ea.setCheckpointing(checkpointFile, seconds(checkpointInterval));
+        }
+        if (!telemetryFile.empty()) {
+            ea.enableTelemetry(telemetryFile);
+        }
+        setStopConditions(ea, timeBudget);
         startTime = high_resolution_clock::now();
-        clusterAssignments = ea.cluster(numClusters, noIterations, minAMIThreshold);
+        if (resume) {
+            clusterAssignments = ea.cluster(checkpoint, noIterations, minAMIThreshold);
+        } else {
+            clusterAssignments = ea.cluster(numClusters, noIterations, minAMIThreshold);
+        }
         endTime = high_resolution_clock::now();
         auto elapsedTimeExchange = duration_cast<milliseconds>(endTime - startTime).count();
         double amiExchange = ea.calculateAMI();
         experiment_data["ami_exchange"] = amiExchange;
         experiment_data["duration_exchange"] = elapsedTimeExchange;
-        experiment_data["iterations_exchange"] = ea.getIterations();
+        experiment_data["iterations_exchange"] = ea.getCompletedIterations();
+        experiment_data["speculative_moves_committed"] = ea.getSpeculativeMovesCommitted();
+        experiment_data["speculative_words_rescored"] = ea.getSpeculativeWordsRescored();
+        experiment_data["words_evaluated"] = ea.getWordsEvaluated();
+        experiment_data["candidates_bounded"] = ea.getCandidatesBounded();
+        experiment_data["candidates_pruned"] = ea.getCandidatesPruned();
+        experiment_data["stop_reason"] = stopReasonName(ea.getStopReason());
         LOG(INFO) << "AMI for Exchange: " << amiExchange;
+    } else if (ALG_EXCHANGE_MULTILEVEL == algorithm) {
+        LOG(INFO) << "Starting multilevel Exchange...";
+        MultilevelExchange ea(corpusHandle);
+        ea.setCountDomain(countDomain);
+        ea.setVectorizedScoring(!scalarScoring);
+        ea.setBoundPruning(boundPruning);
+        ea.setSpeculativeBatchSize(batchSize);
+        ea.setActiveSetScheduling(activeSet);
+        ea.setFullSweepInterval(fullSweepInterval);
+        ea.setActiveSetThreshold(activeSetThreshold);
+        ea.setInitialWords(initialWords);
+        ea.setGrowthFactor(growthFactor);
+        ea.setStageIterations(stageIterations);
+        if (!telemetryFile.empty()) {
+            ea.enableTelemetry(telemetryFile);
+        }
+        setStopConditions(ea, timeBudget);
+        startTime = high_resolution_clock::now();
+        clusterAssignments = ea.cluster(numClusters, noIterations, minAMIThreshold);
+        endTime = high_resolution_clock::now();
+        auto elapsedTimeExchange = duration_cast<milliseconds>(endTime - startTime).count();
+        double amiExchange = ea.calculateAMI();
+        experiment_data["ami_exchange"] = amiExchange;
+        experiment_data["duration_exchange"] = elapsedTimeExchange;
+        experiment_data["initial_words"] = initialWords;
+        experiment_data["growth_factor"] = growthFactor;
+        experiment_data["stage_iterations"] = stageIterations;
+        experiment_data["stages"] = json::array();
+        for (const MultilevelStage &stage : ea.getStages()) {
+            LOG(INFO) << "Stage with " << stage.movableWords << " words: " << stage.iterations << " iteration(s), "
+                      << stage.durationMilliseconds / 1000 << " sec., AMI " << stage.ami;
+            experiment_data["stages"].push_back({{"movable_words",   stage.movableWords},
+                                                 {"iterations",      stage.iterations},
+                                                 {"words_evaluated", stage.wordsEvaluated},
+                                                 {"ami",             stage.ami},
+                                                 {"duration",        stage.durationMilliseconds}});
+        }
+        experiment_data["stop_reason"] = stopReasonName(ea.getStopReason());
+        LOG(INFO) << "AMI for multilevel Exchange: " << amiExchange;
+    } else if (ALG_EXCHANGE_DISTRIBUTED == algorithm) {
+        const string socketPath = socketFile.empty() ? "/tmp/exchange_runner_" + to_string(getpid()) + ".sock"
+                                                     : socketFile;
+        const int threadsPerWorker = workerThreads > 0 ? workerThreads
+                                                       : std::max(1, numThreadsToUse / (int) numWorkers);
+        LOG(INFO) << "Starting " << numWorkers << " worker(s) with " << threadsPerWorker << " thread(s) each on "
+                  << socketPath;
+        MessageListener listener(socketPath);
+        const vector<pid_t> workers = spawnWorkers(numWorkers, inputFile, socketPath, threadsPerWorker);
+        vector<MessageChannel> channels;
+        while (channels.size() < numWorkers) {
+            if (listener.waitForConnection(1000)) {
+                channels.push_back(listener.accept());
+            } else if (!workersSucceeded(workers, false)) {
+                cerr << "A worker ended before connecting to " << socketPath << endl;
+                return 1;
+            }
+        }
+        LOG(INFO) << "Starting distributed Exchange...";
+        {
+            DistributedExchange ea(corpusHandle, std::move(channels));
+            ea.setCountDomain(countDomain);
+            ea.setVectorizedScoring(!scalarScoring);
+            ea.setBoundPruning(boundPruning);
+            ea.setRoundsPerIteration(roundsPerIteration);
+            startTime = high_resolution_clock::now();
+            clusterAssignments = ea.cluster(numClusters, noIterations, minAMIThreshold);
+            endTime = high_resolution_clock::now();
+            auto elapsedTimeExchange = duration_cast<milliseconds>(endTime - startTime).count();
+            double amiExchange = ea.calculateAMI();
+            experiment_data["ami_exchange"] = amiExchange;
+            experiment_data["duration_exchange"] = elapsedTimeExchange;
+            experiment_data["iterations_exchange"] = ea.getIterations();
+            experiment_data["workers"] = numWorkers;
+            experiment_data["worker_threads"] = threadsPerWorker;
+            experiment_data["rounds"] = roundsPerIteration;
+            experiment_data["words_evaluated"] = ea.getWordsEvaluated();
+            experiment_data["moves_rejected"] = ea.getMovesRejected();
+            experiment_data["bytes_transferred"] = ea.getBytesTransferred();
+            LOG(INFO) << "AMI for distributed Exchange: " << amiExchange;
+        }
+//        the workers end once their connections are closed
+        if (!workersSucceeded(workers, true)) {
+            cerr << "A worker failed" << endl;
+            return 1;
+        }
     } else if (ALG_EXCHANGE_STEPS == algorithm) {
         LOG(INFO) << "Starting Exchange for single steps...";
-        Exchange ea(fullCorpus);
-        ea.prepareClustering(numClusters);
+        Exchange ea(corpusHandle);
+        ea.setCountDomain(countDomain);
+        ea.setVectorizedScoring(!scalarScoring);
+        ea.setBoundPruning(boundPruning);
+        ea.setSpeculativeBatchSize(batchSize);
+        ea.setActiveSetScheduling(activeSet);
+        ea.setFullSweepInterval(fullSweepInterval);
+        ea.setActiveSetThreshold(activeSetThreshold);
+        if (!checkpointFile.empty()) {
+            ea.setCheckpointing(checkpointFile, seconds(checkpointInterval));
+        }
+        if (!telemetryFile.empty()) {
+            ea.enableTelemetry(telemetryFile);
+        }
+        setStopConditions(ea, timeBudget);
+        if (resume) {
+            ea.resumeClustering(checkpoint);
+        } else {
+            ea.prepareClustering(numClusters);
+        }
         experiment_data["ami_progression"] = vector_word_type();
         experiment_data["ami_progression"].push_back(ea.calculateAMI());
         experiment_data["durations"] = vector_word_type();
         experiment_data["swaps"] = vector<uint32_t>();
+        experiment_data["words_evaluated"] = vector<uint64_t>();
+        experiment_data["pruning_rate"] = vector<double>();
         clusterAssignments = ea.getClusterAssignments();
-        const string outputFileClustersFirstIteration = outputFile + "_0.txt";
-        fullCorpus.writeClustersToFile(outputFileClustersFirstIteration, clusterAssignments, numClusters);
+        if (!resume) {
+            const string outputFileClustersFirstIteration = outputFile + "_0.txt";
+            fullCorpus.writeClustersToFile(outputFileClustersFirstIteration, clusterAssignments, numClusters);
+        }
         LOG(INFO) << "Beginning clustering for " << numClusters << " clusters";
-        for (word_type i = 1; i <= noIterations; ++i) {
+        for (word_type i = ea.getCompletedIterations() + 1; i <= noIterations; ++i) {
+            const uint64_t wordsEvaluatedBefore = ea.getWordsEvaluated();
+            const uint64_t candidatesBoundedBefore = ea.getCandidatesBounded();
+            const uint64_t candidatesPrunedBefore = ea.getCandidatesPruned();
             startTime = high_resolution_clock::now();
             const bool itemsMoved = ea.clusterOneIteration(minAMIThreshold);
             endTime = high_resolution_clock::now();
@@ -116,7 +519,15 @@ int main(int ac, char *av[]) {
             experiment_data["ami_progression"].push_back(amiExchange);
             experiment_data["durations"].push_back(elapsedTime);
             experiment_data["swaps"].push_back(ea.getChangesInPreviousIteration());
+            experiment_data["words_evaluated"].push_back(ea.getWordsEvaluated() - wordsEvaluatedBefore);
+            const uint64_t candidatesBounded = ea.getCandidatesBounded() - candidatesBoundedBefore;
+            experiment_data["pruning_rate"].push_back(
+                    candidatesBounded == 0 ? 0.0
+                                           : (double) (ea.getCandidatesPruned() - candidatesPrunedBefore) /
+                                             candidatesBounded);
             experiment_data["iterations_exchange"] = i;
+            experiment_data["speculative_moves_committed"] = ea.getSpeculativeMovesCommitted();
+            experiment_data["speculative_words_rescored"] = ea.getSpeculativeWordsRescored();
             LOG(INFO) << "AMI for Exchange";
             LOG(INFO) << " (iterations " << i << ", duration "
                       << elapsedTime / 1000 << " sec. ): " << amiExchange;
@@ -131,21 +542,53 @@ int main(int ac, char *av[]) {
             const string outputFileClustersIteration = outputFile + "_" + std::to_string(i) + ".txt";
             fullCorpus.writeClustersToFile(outputFileClustersIteration, clusterAssignments, numClusters);
         }
+        if (ea.getStopReason() != Exchange::NOT_STOPPED) {
+            clusterAssignments = ea.getBestClusterAssignments();
+        }
+        experiment_data["stop_reason"] = stopReasonName(ea.getStopReason());
     } else if (ALG_EXCHANGE_STOCHASTIC == algorithm) {
         LOG(INFO) << "Starting StochasticExchange...";
-        StochasticExchange ea(fullCorpus);
+        StochasticExchange ea(corpusHandle);
+        ea.setCountDomain(countDomain);
+        ea.setVectorizedScoring(!scalarScoring);
+        ea.setBoundPruning(boundPruning);
         LOG(INFO) << "Setting randomness to " << percentageRandom;
         ea.setRandomness(percentageRandom);
-        ea.prepareClustering(numClusters);
+        if (app.count("--seed") > 0) {
+            ea.setSeed(seed);
+        }
+        ea.setAnnealing(temperature, coolingSchedule, coolingRate);
+        ea.setPatience(patience);
+        if (!checkpointFile.empty()) {
+            ea.setCheckpointing(checkpointFile, seconds(checkpointInterval));
+        }
+        if (!telemetryFile.empty()) {
+            ea.enableTelemetry(telemetryFile);
+        }
+        setStopConditions(ea, timeBudget);
+        if (resume) {
+            ea.resumeClustering(checkpoint);
+        } else {
+            ea.prepareClustering(numClusters);
+        }
         experiment_data["ami_progression"] = vector_word_type();
         experiment_data["ami_progression"].push_back(ea.calculateAMI());
         experiment_data["durations"] = vector_word_type();
         experiment_data["swaps"] = vector<uint32_t>();
+        experiment_data["temperatures"] = vector<double>();
+        experiment_data["temperature"] = temperature;
+        experiment_data["cooling"] = cooling;
+        experiment_data["cooling_rate"] = coolingRate;
+        experiment_data["patience"] = patience;
+        experiment_data["seed"] = ea.getSeed();
         clusterAssignments = ea.getClusterAssignments();
-        const string outputFileClustersFirstIteration = outputFile + "_0.txt";
-        fullCorpus.writeClustersToFile(outputFileClustersFirstIteration, clusterAssignments, numClusters);
+        if (!resume) {
+            const string outputFileClustersFirstIteration = outputFile + "_0.txt";
+            fullCorpus.writeClustersToFile(outputFileClustersFirstIteration, clusterAssignments, numClusters);
+        }
         LOG(INFO) << "Beginning clustering for " << numClusters << " clusters";
-        for (word_type i = 1; i <= noIterations; ++i) {
+        for (word_type i = ea.getCompletedIterations() + 1; i <= noIterations; ++i) {
+            experiment_data["temperatures"].push_back(ea.getTemperature());
             startTime = high_resolution_clock::now();
             const bool itemsMoved = ea.clusterOneIteration(minAMIThreshold);
             endTime = high_resolution_clock::now();
@@ -170,11 +613,62 @@ int main(int ac, char *av[]) {
             const string outputFileClustersIteration = outputFile + "_" + std::to_string(i) + ".txt";
             fullCorpus.writeClustersToFile(outputFileClustersIteration, clusterAssignments, numClusters);
         }
+//        random swaps and annealing can end on a worse clustering than one seen before, so the best one is written
+//        (kept since the cancellation token makes the clustering anytime); none is kept if no iteration was left
+        const vector_word_type bestAssignments = ea.getBestClusterAssignments();
+        if (!bestAssignments.empty()) {
+            clusterAssignments = bestAssignments;
+        }
+        experiment_data["stop_reason"] = stopReasonName(ea.getStopReason());
+    } else if (ALG_EXCHANGE_STOCHASTIC_ENSEMBLE == algorithm) {
+        LOG(INFO) << "Starting StochasticExchange ensemble of " << numChains << " chains...";
+        StochasticExchangeEnsemble ea(corpusHandle);
+        ea.setCountDomain(countDomain);
+        ea.setVectorizedScoring(!scalarScoring);
+        ea.setBoundPruning(boundPruning);
+        ea.setRandomness(percentageRandom);
+        ea.setChains(numChains);
+        if (app.count("--seed") > 0) {
+            ea.setSeed(seed);
+        }
+        ea.setAnnealing(temperature, coolingSchedule, coolingRate);
+        ea.setPatience(patience);
+        ea.setAbandonMargin(abandonMargin);
+        ea.setGraceIterations(graceIterations);
+        startTime = high_resolution_clock::now();
+        clusterAssignments = ea.cluster(numClusters, noIterations, minAMIThreshold);
+        endTime = high_resolution_clock::now();
+        auto elapsedTimeExchange = duration_cast<milliseconds>(endTime - startTime).count();
+        double amiExchange = ea.calculateAMI();
+        experiment_data["ami_exchange"] = amiExchange;
+        experiment_data["duration_exchange"] = elapsedTimeExchange;
+        experiment_data["percentage_random_swaps"] = percentageRandom;
+        experiment_data["temperature"] = temperature;
+        experiment_data["cooling"] = cooling;
+        experiment_data["cooling_rate"] = coolingRate;
+        experiment_data["abandon_margin"] = abandonMargin;
+        experiment_data["grace_iterations"] = graceIterations;
+        experiment_data["best_chain"] = ea.getBestChain();
+        experiment_data["chains"] = json::array();
+        for (const EnsembleChain &chain : ea.getChains()) {
+            LOG(INFO) << "Chain with seed " << chain.seed << ": " << chain.iterations << " iteration(s), best AMI "
+                      << chain.bestAMI << (chain.abandoned ? ", abandoned" : "");
+            experiment_data["chains"].push_back({{"seed",            chain.seed},
+                                                 {"iterations",      chain.iterations},
+                                                 {"ami_progression", chain.amiProgression},
+                                                 {"best_ami",        chain.bestAMI},
+                                                 {"abandoned",       chain.abandoned},
+                                                 {"words_evaluated", chain.wordsEvaluated}});
+        }
+        LOG(INFO) << "AMI for StochasticExchange ensemble: " << amiExchange;
     } else {
         cerr << "No recognised algorithm selected!" << endl;
         throw runtime_error("No recognised algorithm selected!");
     }
 
+    if (cancellationOnSignal.isCancelled()) {
+        LOG(INFO) << "Stopped on SIGTERM";
+    }
     LOG(INFO) << "Writing clusters to file: " << outputFileClusters;
     fullCorpus.writeClustersToFile(outputFileClusters, clusterAssignments, numClusters);
     ofstream out(outputFileData);
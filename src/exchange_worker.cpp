@@ -0,0 +1,46 @@
+#include <iostream>
+#include <Utils.h>
+#include <models/Corpus.h>
+#include <ExchangeAlgorithm/DistributedExchange/ExchangeShard.h>
+#include <omp.h>
+#include "easylogging++/easylogging++.h"
+#include <CLI11.hpp>
+
+INITIALIZE_EASYLOGGINGPP
+
+using namespace std;
+
+int main(int ac, char *av[]) {
+    string inputFile;
+    string socketPath;
+    auto numThreadsToUse = omp_get_max_threads();
+    CLI::App app{"Worker of DISTRIBUTED_EXCHANGE: clusters a shard of the vocabulary on behalf of exchange_runner, "
+                 "which normally starts the workers itself"};
+    app.set_failure_message(CLI::FailureMessage::help);
+    app.add_option("--input", inputFile, "Path to the corpus file the coordinator clusters")->required()->check(
+            CLI::ExistingFile);
+    app.add_option("--socket", socketPath, "Path of the Unix socket the coordinator listens on")->required();
+    app.add_option("--threads", numThreadsToUse, "The number of threads to use for scoring")->set_default_val(
+            to_string(numThreadsToUse));
+    try {
+        app.parse(ac, av);
+    } catch (CLI::CallForHelp &e) {
+        (app).exit(e);
+        return 1;
+    } catch (CLI::ParseError &e) {
+        (app).exit(e);
+        return 1;
+    }
+
+    omp_set_num_threads(numThreadsToUse);
+    const corpus_handle corpusHandle = Corpus::deserializeSharedFromFile(inputFile);
+    try {
+        MessageChannel channel = MessageChannel::connectTo(socketPath);
+        ExchangeShard shard(corpusHandle);
+        shard.serve(channel);
+    } catch (const runtime_error &e) {
+        cerr << "Worker failed: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
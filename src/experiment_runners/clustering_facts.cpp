@@ -53,11 +53,7 @@ int main(int ac, char *av[]) {
     const word_type numClusters =
             *std::max_element(clusterAssignments.begin(), clusterAssignments.end()) + 1;
     experiment_data["clustering"]["number_clusters"] = numClusters;
-    vector<word_type> clusterSizes(numClusters, 0);
-    for (uint32_t wordID = 0; wordID < corpus.vocabularySize; wordID++) {
-        const auto clusterID = clusterAssignments[wordID];
-        clusterSizes[clusterID] += corpus.wordCountAsNumbers.at(wordID);
-    }
+    const vector_word_type clusterSizes = CorpusUtils::calculateClusterFrequency(clusterAssignments, corpus);
     experiment_data["clustering"]["cluster_frequencies"] = clusterSizes;
     LOG(INFO) << "Writing output to file " << outputFile;
     ofstream out(outputFile);
@@ -47,7 +47,9 @@ int main(int ac, char *av[]) {
     LOG(INFO) << "Reading original corpus";
     const Corpus corpus = Corpus::deserializeFromFile(fileNameCorpus);
     LOG(INFO) << "Constructing clustered corpus";
-    const Corpus clusteredCorpus = reader.readFile(fileNameCorpus, fileNameClustering);
+    const corpus_handle clusteredCorpusHandle = make_shared<const Corpus>(reader.readFile(fileNameCorpus,
+                                                                                          fileNameClustering));
+    const Corpus &clusteredCorpus = *clusteredCorpusHandle;
     LOG(INFO) << "Reading cluster assignments";
     const vector<word_type> clusterAssignments = CorpusUtils::readClusterAssignmentsFromFile(fileNameClustering,
                                                                                              corpus);
@@ -60,7 +62,7 @@ int main(int ac, char *av[]) {
         clusterContent[clusterID].push_back(i);
     }
 
-    BrownClusteringAlgorithm brown(clusteredCorpus);
+    BrownClusteringAlgorithm brown(clusteredCorpusHandle);
     LOG(INFO) << "Clustering...";
     brown.cluster(numberOfClusters, numberOfClusters);
     LOG(INFO) << "\twriting tree to file " << fileNameOutput;
@@ -0,0 +1,121 @@
+#include "easylogging++/easylogging++.h"
+#include <iostream>
+#include <Utils.h>
+#include <models/Corpus.h>
+#include <ExchangeAlgorithm/Exchange/Exchange.h>
+#include <NumaPlacement.h>
+#include <json/json.hpp>
+#include <chrono>
+#include <omp.h>
+#include <CLI11.hpp>
+
+INITIALIZE_EASYLOGGINGPP
+
+using namespace std;
+using namespace std::chrono;
+using json = nlohmann::json;
+
+int main(int ac, char *av[]) {
+    string inputFile;
+    string outputFile;
+    word_type numClusters = 1000;
+    word_type noIterations = 2;
+    word_type repetitions = 3;
+    bool pinThreads = false;
+    auto numThreadsToUse = omp_get_max_threads();
+
+    CLI::App app{"Compares the Exchange throughput with the cluster matrices placed by the threads that work on them "
+                 "(first touch) and with them placed by the main thread"};
+    app.set_failure_message(CLI::FailureMessage::help);
+    app.add_option("--input", inputFile, "Path to input file containing a corpus object")->required()->check(
+            CLI::ExistingFile);
+    app.add_option("--output", outputFile, "Path to the json file to write the measurements to")->required();
+    app.add_option("--clusters", numClusters, "The number of clusters")->set_default_val("1000");
+    app.add_option("--iterations", noIterations, "Number of Exchange iterations per run")->set_default_val("2");
+    app.add_option("--repetitions", repetitions,
+                   "Number of runs per placement; the fastest run of each is reported")->set_default_val("3");
+    app.add_option("--threads", numThreadsToUse, "The number of threads to use")->set_default_val(
+            to_string(numThreadsToUse));
+    app.add_flag("--pin_threads", pinThreads,
+                 "Pin every thread to one CPU, filling one NUMA node after the other. Without, the first-touch placement is only kept as long as the operating system does not move the threads.");
+    try {
+        app.parse(ac, av);
+    } catch (CLI::CallForHelp &e) {
+        (app).exit(e);
+        return 1;
+    } catch (CLI::ParseError &e) {
+        (app).exit(e);
+        return 1;
+    }
+
+    omp_set_num_threads(numThreadsToUse);
+    if (pinThreads) {
+        NumaPlacement::pinThreads();
+    }
+    vector_word_type threadNodes(numThreadsToUse, 0);
+#pragma omp parallel
+    {
+        threadNodes[omp_get_thread_num()] = NumaPlacement::currentNode();
+    }
+    LOG(INFO) << "Running " << numThreadsToUse << " thread(s) on " << NumaPlacement::numberOfNodes()
+              << " NUMA node(s), nodes of the threads: " << json(threadNodes).dump();
+
+    LOG(INFO) << "Reading corpus from " << inputFile;
+    const corpus_handle corpusHandle = Corpus::deserializeSharedFromFile(inputFile);
+
+    json experiment_data;
+    experiment_data["corpus"] = inputFile;
+    experiment_data["total_words"] = corpusHandle->vocabularySize;
+    experiment_data["num_clusters"] = numClusters;
+    experiment_data["num_iterations"] = noIterations;
+    experiment_data["omp_num_threads"] = numThreadsToUse;
+    experiment_data["pin_threads"] = pinThreads;
+    experiment_data["numa_nodes"] = NumaPlacement::numberOfNodes();
+    experiment_data["thread_nodes"] = threadNodes;
+
+//    the placements alternate, so that both see the same state of the machine on average
+    const vector<pair<string, bool>> placements = {{"main_thread", false}, {"first_touch", true}};
+    map<string, double> bestWordsPerSecond;
+    vector_word_type reference;
+    for (word_type repetition = 0; repetition < repetitions; ++repetition) {
+        for (const pair<string, bool> &placement : placements) {
+            Exchange exchange(corpusHandle);
+            exchange.setParallelFirstTouch(placement.second);
+            const high_resolution_clock::time_point startTime = high_resolution_clock::now();
+//            every iteration runs, whatever the AMI does
+            const vector_word_type clustering = exchange.cluster(numClusters, noIterations,
+                                                                 -std::numeric_limits<double>::infinity());
+            const double seconds = duration<double>(high_resolution_clock::now() - startTime).count();
+            if (reference.empty()) {
+                reference = clustering;
+            } else if (clustering != reference) {
+                throw runtime_error("The placement " + placement.first + " changed the clustering");
+            }
+            const double wordsPerSecond = exchange.getWordsEvaluated() / seconds;
+            bestWordsPerSecond[placement.first] = std::max(bestWordsPerSecond[placement.first], wordsPerSecond);
+            LOG(INFO) << placement.first << " run " << repetition + 1 << ": " << seconds << " s, "
+                      << wordsPerSecond << " words/s";
+            experiment_data["runs"].push_back({{"placement",         placement.first},
+                                               {"seconds",           seconds},
+                                               {"words_evaluated",   exchange.getWordsEvaluated()},
+                                               {"words_per_second",  wordsPerSecond},
+                                               {"ami",               exchange.calculateAMI()}});
+        }
+    }
+    for (const pair<string, bool> &placement : placements) {
+        experiment_data["best_words_per_second"][placement.first] = bestWordsPerSecond[placement.first];
+    }
+    const double speedup = bestWordsPerSecond["first_touch"] / bestWordsPerSecond["main_thread"];
+    experiment_data["speedup"] = speedup;
+    LOG(INFO) << "Throughput with first-touch placement relative to placement by the main thread: " << speedup;
+
+    LOG(INFO) << "Writing output to file " << outputFile;
+    ofstream out(outputFile);
+    if (!out.is_open()) {
+        throw runtime_error("Cannot open file " + outputFile);
+    }
+    out << std::setw(4) << experiment_data;
+    out.close();
+    LOG(INFO) << "DONE";
+    return 0;
+}
@@ -25,9 +25,10 @@ int main(int ac, char *av[]) {
         app.parse(ac, av);
         LOG(INFO) << "Will read clusters from " << inputClusters;
         LOG(INFO) << "Will read corpus from " << inputCorpus;
-        const Corpus corpus = Corpus::deserializeFromFile(inputCorpus);
+        const corpus_handle corpusHandle = Corpus::deserializeSharedFromFile(inputCorpus);
+        const Corpus &corpus = *corpusHandle;
         LOG(INFO) << "Loaded corpus with " << corpus.vocabularySize << " types in vocabulary";
-        Exchange exchange(corpus);
+        Exchange exchange(corpusHandle);
         const auto clustering = CorpusUtils::readClusterAssignmentsFromFile(inputClusters, corpus);
         const word_type numClusters = *std::max_element(clustering.begin(), clustering.end()) + 1;
         LOG(INFO) << "Loaded cluster assignments for " << clustering.size() << " types into " << numClusters
@@ -1,10 +1,12 @@
 #include <iostream>
 #include "BrownClusteringAlgorithm/BrownClusteringAlgorithm.h"
 #include "models/Corpus.h"
+#include "models/MappedCorpusFile.h"
 #include "readers/ReaderNoOrder.h"
 #include <fstream>
 #include <ExchangeAlgorithm/Exchange/Exchange.h>
 #include <CorpusUtils.h>
+#include <NumaPlacement.h>
 #include <omp.h>
 #include <readers/ReaderThreshold.h>
 #include "readers/ReaderNoOrder.h"
@@ -28,7 +30,9 @@ int main(int ac, char *av[]) {
     word_type numClusters;
     word_type windowSize;
     bool filterStrict;
+    string corpusFormat = "mapped";
     int numThreadsToUse = omp_get_max_threads();
+    bool pinThreads = false;
     CLI::App app{"Main binary. Can turn text into Corpus objects, filter them and run the Brown algorithm"};
     app.set_failure_message(CLI::FailureMessage::help);
 //    we need exactly one sub-command like read, filter, etc
@@ -66,6 +70,16 @@ int main(int ac, char *av[]) {
     sub_filter_freq->add_option("--output-vocabulary", outputFileVocabulary,
                                 "Path to file to write the resulting vocabulary to");
 
+    auto sub_convert = app.add_subcommand("convert",
+                                          "Convert a corpus object between the legacy (cereal) and the memory-mapped format");
+    sub_convert->add_option("--input", inputFile,
+                            "Path to input file containing a corpus object in either format")->required()->check(
+            CLI::ExistingFile);
+    sub_convert->add_option("--output", outputFile,
+                            "Path to file to write the converted corpus object to")->required();
+    sub_convert->add_set("--format", corpusFormat, {"mapped", "legacy"},
+                         "Format of the output file", true);
+
     auto sub_learn_brown = app.add_subcommand("induce_brown",
                                               "Induce a clustering using the Brown algorithm");
     sub_learn_brown->add_option("--input", inputFile,
@@ -81,6 +95,8 @@ int main(int ac, char *av[]) {
     helpMsgThreads += std::to_string(numThreadsToUse);
     helpMsgThreads += ".";
     sub_learn_brown->add_option("--threads", numThreadsToUse, helpMsgThreads)->set_default_val(to_string(numThreadsToUse));
+    sub_learn_brown->add_flag("--pin_threads", pinThreads,
+                              "Pin every thread to one CPU, filling one NUMA node after the other, so that the threads keep working on the memory of their own node.");
 
     try {
         app.parse(ac, av);
@@ -93,6 +109,10 @@ int main(int ac, char *av[]) {
     }
     LOG(INFO) << "Will run with at most " << numThreadsToUse << " thread(s)";
     omp_set_num_threads(numThreadsToUse);
+    if (pinThreads) {
+        LOG(INFO) << "Pinned " << NumaPlacement::pinThreads() << " thread(s) to the CPUs of "
+                  << NumaPlacement::numberOfNodes() << " NUMA node(s)";
+    }
 
     if (app.got_subcommand(sub_read_skip)) {
         LOG(INFO) << "Size of input vocabulary " << inputFileVocabulary.size();
@@ -134,14 +154,24 @@ int main(int ac, char *av[]) {
         Corpus::serializeToFile(filteredCorpus, outputFile);
         LOG (INFO) << "Writing vocabulary to file " << outputFileVocabulary;
         CorpusUtils::writeCorpusVocabularyToFile(filteredCorpus, outputFileVocabulary);
+    } else if (app.got_subcommand(sub_convert)) {
+        LOG(INFO) << "Reading corpus from file " << inputFile;
+        const Corpus corpus = Corpus::deserializeFromFile(inputFile);
+        LOG(INFO) << "Writing corpus in " << corpusFormat << " format to file " << outputFile;
+        if (corpusFormat == "mapped") {
+            MappedCorpusFile::write(corpus, outputFile);
+        } else {
+            Corpus::serializeToFile(corpus, outputFile);
+        }
     } else if (app.got_subcommand(sub_learn_brown)) {
         LOG(INFO) << "Inducing Brown clustering";
         LOG(INFO) << "Reading corpus from file " << inputFile;
-        const Corpus corpus = Corpus::deserializeFromFile(inputFile);
+        const corpus_handle corpusHandle = Corpus::deserializeSharedFromFile(inputFile);
+        const Corpus &corpus = *corpusHandle;
         vector_word_type clusterAssignments;
         LOG(INFO) << "Initializing and running BROWN for " << numClusters
                   << " clusters with a window of " << windowSize;
-        unique_ptr<BrownClusteringAlgorithm> brown = make_unique<BrownClusteringAlgorithm>(corpus);
+        unique_ptr<BrownClusteringAlgorithm> brown = make_unique<BrownClusteringAlgorithm>(corpusHandle);
         try {
             clusterAssignments = brown->cluster(numClusters, windowSize);
         } catch( const std::exception & ex ) {
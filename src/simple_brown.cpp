@@ -63,7 +63,7 @@ int main(int ac, char *av[]) {
     LOG(INFO) << "Will run with at most " << numThreadsToUse << " thread(s)";
     omp_set_num_threads(numThreadsToUse);
 
-    Corpus finalCorpus;
+    corpus_handle finalCorpusHandle;
     ReaderNoOrder readerNoOrder;
     LOG(INFO) << "Reading corpusNoOrder from text file " << inputFile;
     const Corpus corpusNoOrder = readerNoOrder.readFile(inputFile);
@@ -73,26 +73,27 @@ int main(int ac, char *av[]) {
 
     LOG(INFO) << "Will reorder corpus from using order FREQUENCY";
     ReaderFrequency readerOrder;
-    const Corpus corpusFrequency = readerOrder.reorderCorpus(corpusNoOrder);
+    Corpus corpusFrequency = readerOrder.reorderCorpus(corpusNoOrder);
 
     LOG(INFO) << "Will filter corpus from file " << inputFile << " using threshold " << threshold;
 
     if (threshold > 1) {
         ReaderThreshold readerThreshold;
-        const Corpus corpusReorderedFiltered = readerThreshold.reorderCorpus(corpusFrequency, threshold, filterStrict);
-        LOG(INFO) << "Corpus size: " << corpusReorderedFiltered.corpusLength
-                  << " vocabulary size: " << corpusReorderedFiltered.vocabularySize;
-        finalCorpus = corpusReorderedFiltered;
+        finalCorpusHandle = make_shared<const Corpus>(readerThreshold.reorderCorpus(corpusFrequency, threshold,
+                                                                                     filterStrict));
+        LOG(INFO) << "Corpus size: " << finalCorpusHandle->corpusLength
+                  << " vocabulary size: " << finalCorpusHandle->vocabularySize;
     } else {
-        finalCorpus = corpusFrequency;
+        finalCorpusHandle = make_shared<const Corpus>(std::move(corpusFrequency));
     }
+    const Corpus &finalCorpus = *finalCorpusHandle;
     LOG(INFO) << "Inducing Brown clustering";
     LOG(INFO) << "Reading corpus from file " << inputFile;
 
     vector_word_type clusterAssignments;
     LOG(INFO) << "Initializing and running BROWN for " << numClusters
               << " clusters with a window of " << windowSize;
-    unique_ptr<BrownClusteringAlgorithm> brown(new BrownClusteringAlgorithm(finalCorpus));
+    unique_ptr<BrownClusteringAlgorithm> brown(new BrownClusteringAlgorithm(finalCorpusHandle));
     clusterAssignments = brown->cluster(numClusters, windowSize);
     LOG(INFO) << "Clustering finished. Writing clusters to file " << outputFile;
     finalCorpus.writeClustersToFile(outputFile, clusterAssignments, numClusters);
@@ -4,11 +4,8 @@
 #include "easylogging++/easylogging++.h"
 
 
-BrownClusteringAlgorithm::BrownClusteringAlgorithm(const Corpus &corpus) : clustering(1, 2) {
-    this->corpus = corpus;
-    const pair<matrix_occurrences, matrix_occurrences> leftiesAndRighties = Corpus::computeLeftiesAndRighties(corpus);
-    this->toTheLeftOf = leftiesAndRighties.first;
-    this->toTheRightOf = leftiesAndRighties.second;
+BrownClusteringAlgorithm::BrownClusteringAlgorithm(corpus_handle corpus)
+        : corpusHandle(std::move(corpus)), corpus(*corpusHandle), clustering(1, 2) {
 }
 
 vector_word_type BrownClusteringAlgorithm::cluster(const word_type noClusters, const word_type windowSize) {
@@ -93,21 +90,20 @@ vector_word_type BrownClusteringAlgorithm::cluster(const word_type noClusters, c
                 occurrencesC[mergeData.from][m] = 0;
             }
 
-            for (const auto i : this->toTheLeftOf[idOfNext]) {
-                if (i <= idOfNext) {
-                    const word_type clusterOfI = clustering.getWordsToClusters()[i];
-                    occurrencesC[clusterOfI][mergeData.from] += Utils::getOccurrence(this->corpus.occurrences, i,
-                                                                                     idOfNext);
+            const vector_word_type &wordsToClusters = clustering.getWordsToClusters();
+            for (const BigramEntry &left : this->corpus.getOccurrencesTransposed().row(idOfNext)) {
+                if (left.neighbour <= idOfNext) {
+                    const word_type clusterOfI = wordsToClusters[left.neighbour];
+                    occurrencesC[clusterOfI][mergeData.from] += left.count;
                 } else {
                     break;
                 }
             }
 
-            for (const auto i : this->toTheRightOf[idOfNext]) {
-                if (i <= idOfNext) {
-                    const word_type clusterOfI = clustering.getWordsToClusters()[i];
-                    occurrencesC[mergeData.from][clusterOfI] += Utils::getOccurrence(this->corpus.occurrences, idOfNext,
-                                                                                     i);
+            for (const BigramEntry &right : this->corpus.occurrences.row(idOfNext)) {
+                if (right.neighbour <= idOfNext) {
+                    const word_type clusterOfI = wordsToClusters[right.neighbour];
+                    occurrencesC[mergeData.from][clusterOfI] += right.count;
                 } else { //outside window
                     break;
                 }
@@ -164,7 +160,7 @@ vector_word_type BrownClusteringAlgorithm::cluster(const word_type noClusters, c
 void
 BrownClusteringAlgorithm::updateSkAfterRemovalOf(const word_type intoID, const word_type fromID,
                                                  const word_type currentWindowSize) {
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (word_type m = 0; m < currentWindowSize; ++m) {
         sk[m] -= q[intoID][m];
         sk[m] -= q[m][intoID];
@@ -189,7 +185,7 @@ double BrownClusteringAlgorithm::computeQInitial(matrix_double &q, const matrix_
                                                  const word_type currentWindowSize, vector<double> &plC,
                                                  vector<double> &prC, const word_type corpusLength) {
     double I = 0;
-#pragma omp parallel for reduction (+:I)
+#pragma omp parallel for schedule(static) reduction (+:I)
     for (word_type i = 0; i < currentWindowSize; ++i) {
         for (word_type j = 0; j < currentWindowSize; ++j) {
             q[i][j] = Utils::computeMI((double) occurrencesC[i][j] / corpusLength, plC[i], prC[j]);
@@ -203,12 +199,16 @@ void BrownClusteringAlgorithm::updateQMergedCluster(const word_type intoID, cons
                                                     const word_type corpusLength) {
     sk[intoID] = 0;
     double sk_i = 0;
-#pragma omp parallel for reduction (+:sk_i)
+#pragma omp parallel for schedule(static) reduction (+:sk_i)
     for (word_type m = 0; m < currentWindowSize; ++m) {
         const double joint1 = (double) this->occurrencesC[m][intoID] / corpusLength;
-        const double joint2 = (double) this->occurrencesC[intoID][m] / corpusLength;
         this->q[m][intoID] = Utils::computeMI(joint1, plC[m], prC[intoID]);
-        this->q[intoID][m] = Utils::computeMI(joint2, plC[intoID], prC[m]);
+        if (corpus.symmetric) {
+            this->q[intoID][m] = this->q[m][intoID];
+        } else {
+            const double joint2 = (double) this->occurrencesC[intoID][m] / corpusLength;
+            this->q[intoID][m] = Utils::computeMI(joint2, plC[intoID], prC[m]);
+        }
         sk_i += this->q[m][intoID];
         if (m != intoID) {
             sk_i += this->q[intoID][m];
@@ -227,16 +227,24 @@ void BrownClusteringAlgorithm::initializeDataStructures(const word_type windowSi
     this->plC = vector<double>(corpus.pl.begin(), corpus.pl.end());
     this->prC = vector<double>(corpus.pr.begin(), corpus.pr.end());
 
-//  initialize q and occurrencesC
-    this->q = matrix_double(windowSize, vector<double>(windowSize));
-    this->occurrencesC = matrix_occurrences(windowSize, vector_word_type(windowSize, 0));
+//  initialize q and occurrencesC. Their rows are allocated and zeroed by the threads that get them in the static
+//  schedule of the loops over m, so that on a machine with several NUMA nodes they end up on the node that updates them
+    this->q = matrix_double(windowSize);
+    this->occurrencesC = matrix_occurrences(windowSize);
+#pragma omp parallel for schedule(static)
+    for (word_type i = 0; i < windowSize; ++i) {
+        q[i] = vector<double>(windowSize, 0);
+        occurrencesC[i] = vector_word_type(windowSize, 0);
+    }
 
     //    copy over the initial occurrences
 #pragma omp parallel for schedule(dynamic)
     for (word_type i = 0; i < windowSize; ++i) {
-        for (word_type j : toTheRightOf[i]) {
-            if (j < windowSize) {
-                occurrencesC[i][j] = Utils::getOccurrence(this->corpus.occurrences, i, j);
+        for (const BigramEntry &right : this->corpus.occurrences.row(i)) {
+            if (right.neighbour < windowSize) {
+                occurrencesC[i][right.neighbour] = right.count;
+            } else {
+                break;
             }
         }
     }
@@ -254,11 +262,16 @@ BrownClusteringAlgorithm::computeQMergeContribution(const word_type i, const wor
         if (m != i && m != j) {
             const double pkMerge_i_m = (double) (this->occurrencesC[i][m] +
                                                  this->occurrencesC[j][m]) / corpusLength;
-            const double pkMerge_m_i = (double) (this->occurrencesC[m][i] +
-                                                 this->occurrencesC[m][j]) / corpusLength;
-
-            valueToReturn += Utils::computeMI(pkMerge_i_m, plMergeI, prC[m]);
-            valueToReturn += Utils::computeMI(pkMerge_m_i, plC[m], prMergeI);
+            const double miMerge_i_m = Utils::computeMI(pkMerge_i_m, plMergeI, prC[m]);
+            valueToReturn += miMerge_i_m;
+            if (corpus.symmetric) {
+//                occurrencesC is symmetric and plC equals prC, so both directions contribute the same
+                valueToReturn += miMerge_i_m;
+            } else {
+                const double pkMerge_m_i = (double) (this->occurrencesC[m][i] +
+                                                     this->occurrencesC[m][j]) / corpusLength;
+                valueToReturn += Utils::computeMI(pkMerge_m_i, plC[m], prMergeI);
+            }
         } else if (m == i) {
             double pkMerge_ij_ij = (double) (this->occurrencesC[i][i] +
                                              this->occurrencesC[i][j] +
@@ -324,12 +337,16 @@ BrownClusteringAlgorithm::updateQNewCluster(const word_type fromID, const word_t
     sk[fromID] = 0;
     double sk_i = 0;
     double parallelOldI = 0;
-#pragma omp parallel for reduction (+:sk_i, parallelOldI)
+#pragma omp parallel for schedule(static) reduction (+:sk_i, parallelOldI)
     for (word_type m = 0; m < currentWindowSize; ++m) {
         const double joint1 = (double) occurrencesC[m][fromID] / corpusLength;
-        const double joint2 = (double) occurrencesC[fromID][m] / corpusLength;
         this->q[m][fromID] = Utils::computeMI(joint1, plC[m], prC[fromID]);
-        this->q[fromID][m] = Utils::computeMI(joint2, plC[fromID], prC[m]);
+        if (corpus.symmetric) {
+            this->q[fromID][m] = this->q[m][fromID];
+        } else {
+            const double joint2 = (double) occurrencesC[fromID][m] / corpusLength;
+            this->q[fromID][m] = Utils::computeMI(joint2, plC[fromID], prC[m]);
+        }
         sk_i += this->q[m][fromID];
         parallelOldI += this->q[m][fromID];
         parallelOldI += this->q[fromID][m];
@@ -10,7 +10,12 @@
 
 class BrownClusteringAlgorithm {
 public:
-    BrownClusteringAlgorithm(const Corpus &corpus);
+    /**
+     * Creates a Brown clustering over a corpus. The corpus is shared, not copied. For a symmetric corpus (see
+     * Corpus::symmetric) occurrencesC and q are symmetric, and every entry of q and every merge contribution is
+     * computed for one direction only.
+     */
+    BrownClusteringAlgorithm(corpus_handle corpus);
 
     virtual ~BrownClusteringAlgorithm() = default;
 
@@ -83,6 +88,13 @@ public:
     static void computeSk(vector<double> &sk, const matrix_double &q, word_type currentWindowSize);
 
 private:
+    /**
+     * Keeps the corpus alive for as long as the algorithm exists. Declared first, since the initializers of the
+     * members below may read the corpus.
+     */
+    const corpus_handle corpusHandle;
+    const Corpus &corpus;
+
     struct MergeData {
         word_type from;
         word_type to;
@@ -143,7 +155,7 @@ private:
          */
         void setAllCurrentNodesAsFinal();
 
-        const auto getWordsToClusters() const {
+        const vector_word_type &getWordsToClusters() const {
             return this->wordsToClusters;
         }
 
@@ -206,10 +218,7 @@ private:
                                   word_type currentWindowSize, vector<double> &plC, vector<double> &prC,
                                   word_type corpusLength);
 
-    Corpus corpus;
     double oldI = 0;
-    matrix_occurrences toTheLeftOf;
-    matrix_occurrences toTheRightOf;
     vector<double> plC;
     vector<double> prC;
     vector<double> sk;
@@ -6,12 +6,11 @@
 using json = nlohmann::json;
 
 vector_word_type CorpusUtils::readClusterAssignmentsFromFile(const string &fileName, const Corpus &corpus) {
-    unordered_map<string, word_type> wordsToIds;
+    unordered_map<string_view, word_type> wordsToIds;
     for (word_type i = 0; i < corpus.vocabularySize; i++) {
         const auto wordOptional = corpus.getWord(i);
         if (wordOptional) {
-            const string word = wordOptional.value();
-            wordsToIds.insert({word, i});
+            wordsToIds.insert({wordOptional.value(), i});
         }
     }
     vector_word_type valueToReturn(corpus.vocabularySize, 0);
@@ -46,10 +45,9 @@ vector_word_type CorpusUtils::calculateClusterFrequency(const vector_word_type &
                                                         const Corpus &corpus) {
     const word_type numClusters = *std::max_element(clusterAssignments.begin(), clusterAssignments.end()) + 1;
     vector_word_type valueToReturn(numClusters, 0);
+    const word_type *wordCounts = corpus.getWordCounts();
     for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
-        const word_type wordFrequency = corpus.wordCountAsNumbers.at(wordID);
-        const word_type clusterID = clusterAssignments[wordID];
-        valueToReturn[clusterID] += wordFrequency;
+        valueToReturn[clusterAssignments[wordID]] += wordCounts[wordID];
     }
     return valueToReturn;
 }
@@ -57,6 +55,7 @@ vector_word_type CorpusUtils::calculateClusterFrequency(const vector_word_type &
 void CorpusUtils::writeTreeToLiangFile(const string &outputFileName,
                                        const vector<pair<string, word_type>> &treeContents,
                                        const Corpus &corpus) {
+    const word_type *wordCounts = corpus.getWordCounts();
     ofstream output(outputFileName);
     if (!output.is_open()) {
         throw runtime_error("File " + outputFileName + " could not be opened!");
@@ -66,8 +65,8 @@ void CorpusUtils::writeTreeToLiangFile(const string &outputFileName,
         const word_type &wordID = item.second;
         const auto wordOptional = corpus.getWord(wordID);
         if (wordOptional) {
-            const string &wordString = wordOptional.value();
-            const word_type &wordCount = corpus.wordCountAsNumbers.at(wordID);
+            const string_view wordString = wordOptional.value();
+            const word_type wordCount = wordCounts[wordID];
             output << address << "\t" << wordString << "\t" << wordCount << endl;
         }
     }
@@ -78,14 +77,11 @@ void CorpusUtils::writeClusterInteractionToJSON(const Corpus &corpus,
                                               const vector_word_type clusterAssignments, const string outputFile){
     const word_type numClusters = *std::max_element(clusterAssignments.begin(), clusterAssignments.end()) + 1;
     matrix_occurrences cluster2cluster(numClusters, vector_word_type(numClusters, 0));
-    for (auto bigram : corpus.occurrences) {
-        const word_type w1 = bigram.first.first;
-        const word_type w2 = bigram.first.second;
-        const word_type occ = bigram.second;
+    corpus.occurrences.forEach([&](const word_type w1, const word_type w2, const word_type occ) {
         const word_type cluster1 = clusterAssignments[w1];
         const word_type cluster2 = clusterAssignments[w2];
         cluster2cluster[cluster1][cluster2] += occ;
-    }
+    });
     json json_object;
     json_object["num_clusters"] = numClusters;
     json_object["corpus_length"] = corpus.corpusLength;
@@ -100,6 +96,7 @@ void CorpusUtils::writeClusterInteractionToJSON(const Corpus &corpus,
 void
 CorpusUtils::writeTreeToLiangFile(const string &outputFileName, const vector<pair<string, word_type>> &treeContents,
                                   const Corpus &corpus, const vector<vector<word_type>> &clusterContent) {
+    const word_type *wordCounts = corpus.getWordCounts();
     ofstream output(outputFileName);
     if (!output.is_open()) {
         throw runtime_error("File " + outputFileName + " could not be opened!");
@@ -112,9 +109,9 @@ CorpusUtils::writeTreeToLiangFile(const string &outputFileName, const vector<pai
         for (const word_type &wordID : clusterContent[clusterID]) {
             const auto wordOptional = corpus.getWord(wordID);
             if (wordOptional) {
-                const string &wordString = wordOptional.value();
+                const string_view wordString = wordOptional.value();
                 ss << wordString << " ";
-                clusterCount += corpus.wordCountAsNumbers.at(wordID);
+                clusterCount += wordCounts[wordID];
             }
         }
         output << address << "\t" << ss.str() << "\t" << clusterCount << endl;
@@ -130,7 +127,7 @@ void CorpusUtils::writeCorpusVocabularyToFile(const Corpus &corpus, const string
     for (word_type wordID = 0; wordID < corpus.vocabularySize; wordID++) {
         const auto wordOptional = corpus.getWord(wordID);
         if (wordOptional) {
-            const string &wordString = wordOptional.value();
+            const string_view wordString = wordOptional.value();
             const auto frequency = corpus.pl[wordID];
             output << wordString << " " << frequency << endl;
         }
@@ -0,0 +1,31 @@
+#ifndef BROWN_CANCELLATIONTOKEN_H
+#define BROWN_CANCELLATIONTOKEN_H
+
+#include <atomic>
+
+/**
+ * Asks a running clustering to stop, see Exchange::setCancellationToken. The clustering polls the token between two
+ * words, so cancelling it only sets a lock-free flag and can be done from another thread or a signal handler.
+ */
+class CancellationToken {
+private:
+    std::atomic<bool> cancelled{false};
+
+public:
+    void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    bool isCancelled() const {
+        return cancelled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Withdraws the cancellation, so that the token can be used for another clustering.
+     */
+    void reset() {
+        cancelled.store(false, std::memory_order_relaxed);
+    }
+};
+
+#endif //BROWN_CANCELLATIONTOKEN_H
@@ -0,0 +1,154 @@
+#include "DistributedExchange.h"
+#include <algorithm>
+
+DistributedExchange::DistributedExchange(corpus_handle corpus, vector<MessageChannel> workers)
+        : ExchangeAlgorithm(std::move(corpus)), workers(std::move(workers)) {
+    if (this->workers.empty()) {
+        throw runtime_error("DistributedExchange needs at least one worker");
+    }
+}
+
+vector<word_type> DistributedExchange::cluster(const word_type numClusters, const word_type noIterations,
+                                               const double minAMIChange) {
+//    the same initial clustering as Exchange
+    vector<word_type> clusterAssignments = vector_word_type(corpus.vocabularySize, numClusters - 1);
+    for (word_type i = 0; i < numClusters - 1; ++i) {
+        clusterAssignments[i] = i;
+    }
+    return cluster(numClusters, noIterations, clusterAssignments, minAMIChange);
+}
+
+vector<word_type> DistributedExchange::cluster(const word_type numClusters, const word_type noIterations,
+                                               const vector<word_type> clusterAssignments,
+                                               const double minAMIChange) {
+    this->numClusters = numClusters;
+    this->iterations = 0;
+    this->wordsEvaluated = 0;
+    this->movesRejected = 0;
+    wordsToClusters = clusterAssignments;
+    plC = vector<double>(numClusters, 0);
+    prC = vector<double>(numClusters, 0);
+    clusterSizes = vector_word_type(numClusters, 0);
+    for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+        plC[wordsToClusters[wordID]] += corpus.pl[wordID];
+        prC[wordsToClusters[wordID]] += corpus.pr[wordID];
+        ++clusterSizes[wordsToClusters[wordID]];
+    }
+    occurrences = vector_word_type((uint64_t) numClusters * numClusters, 0);
+    mergedDeltas.reset(occurrences.size());
+
+    ShardRequest setup;
+    setup.type = ShardRequest::SETUP;
+    setup.numClusters = numClusters;
+    setup.countDomain = countDomain;
+    setup.vectorizedScoring = vectorizedScoring;
+    setup.boundPruning = boundPruning;
+    setup.clusters = wordsToClusters;
+    broadcast(setup);
+    receiveAndMergeCounts();
+
+    double ami = calculateAMI();
+    for (word_type iteration = 0; iteration < noIterations; ++iteration) {
+        const double iterationStartAMI = ami;
+        uint64_t changes = 0;
+        for (word_type round = 0; round < roundsPerIteration; ++round) {
+            ShardRequest moves;
+            moves.type = ShardRequest::MOVES;
+            std::tie(moves.words, moves.clusters) = runRound(round);
+            if (moves.words.empty()) {
+                continue;
+            }
+            changes += moves.words.size();
+            broadcast(moves);
+            receiveAndMergeCounts();
+        }
+        ++iterations;
+        ami = calculateAMI();
+        if (changes == 0 || ami - iterationStartAMI < minAMIChange) {
+            break;
+        }
+    }
+    return ExchangeAlgorithm::sortClusterAssignments(wordsToClusters, numClusters);
+}
+
+std::pair<vector_word_type, vector_word_type> DistributedExchange::runRound(const word_type round) {
+    ShardRequest request;
+    request.type = ShardRequest::SCORE;
+    request.round = round;
+    request.roundsPerIteration = roundsPerIteration;
+    broadcast(request);
+    vector<pair_of_word_type> proposals;
+    for (MessageChannel &worker : workers) {
+        const ShardReply reply = worker.receive<ShardReply>();
+        wordsEvaluated += reply.wordsEvaluated;
+        for (size_t i = 0; i < reply.words.size(); ++i) {
+            proposals.emplace_back(reply.words[i], reply.clusters[i]);
+        }
+    }
+    std::sort(proposals.begin(), proposals.end());
+    std::pair<vector_word_type, vector_word_type> moves;
+    for (const pair_of_word_type &proposal : proposals) {
+        const word_type wordID = proposal.first;
+        const word_type clusterToMoveFrom = wordsToClusters[wordID];
+        const word_type clusterToMoveTo = proposal.second;
+        if (clusterSizes[clusterToMoveFrom] <= 1) {
+            ++movesRejected;
+            continue;
+        }
+        plC[clusterToMoveFrom] -= corpus.pl[wordID];
+        prC[clusterToMoveFrom] -= corpus.pr[wordID];
+        plC[clusterToMoveTo] += corpus.pl[wordID];
+        prC[clusterToMoveTo] += corpus.pr[wordID];
+        --clusterSizes[clusterToMoveFrom];
+        ++clusterSizes[clusterToMoveTo];
+        wordsToClusters[wordID] = clusterToMoveTo;
+        moves.first.push_back(wordID);
+        moves.second.push_back(clusterToMoveTo);
+    }
+    return moves;
+}
+
+void DistributedExchange::broadcast(ShardRequest &request) {
+    request.numShards = workers.size();
+    for (word_type shard = 0; shard < workers.size(); ++shard) {
+        request.shard = shard;
+        workers[shard].send(request);
+    }
+}
+
+void DistributedExchange::receiveAndMergeCounts() {
+    for (MessageChannel &worker : workers) {
+        const ShardReply reply = worker.receive<ShardReply>();
+        for (size_t i = 0; i < reply.entries.size(); ++i) {
+            mergedDeltas.add(reply.entries[i], reply.deltas[i]);
+        }
+    }
+    ShardRequest merged;
+    merged.type = ShardRequest::MERGED_COUNTS;
+    mergedDeltas.drain(merged.entries, merged.deltas);
+    for (size_t i = 0; i < merged.entries.size(); ++i) {
+        occurrences[merged.entries[i]] += merged.deltas[i];
+    }
+    broadcast(merged);
+}
+
+double DistributedExchange::calculateAMI() {
+    const double transitions = corpus.getNumberOfTransitions();
+    double AMI = 0;
+    for (const word_type count : occurrences) {
+        AMI += entropyTerm(count / transitions);
+    }
+    for (word_type clusterID = 0; clusterID < numClusters; ++clusterID) {
+        AMI -= entropyTerm(plC[clusterID]);
+        AMI -= entropyTerm(prC[clusterID]);
+    }
+    return AMI;
+}
+
+uint64_t DistributedExchange::getBytesTransferred() const {
+    uint64_t bytes = 0;
+    for (const MessageChannel &worker : workers) {
+        bytes += worker.getBytesTransferred();
+    }
+    return bytes;
+}
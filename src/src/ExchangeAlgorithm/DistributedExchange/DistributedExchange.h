@@ -0,0 +1,135 @@
+#ifndef DISTRIBUTEDEXCHANGE_H
+#define DISTRIBUTEDEXCHANGE_H
+
+
+#include "../../models/Corpus.h"
+#include "../ExchangeAlgorithm.h"
+#include "MessageChannel.h"
+#include "ShardMessages.h"
+
+/**
+ * Exchange spread over several worker processes (ExchangeShard) in the style of Uszkoreit and Brants (2008), with
+ * this class as the coordinator. Every worker owns a shard of the vocabulary. An iteration is split into rounds; in
+ * every round the workers process the words of their shard that belong to the round, in parallel, starting from the
+ * same clustering. Within a shard the words are processed one after the other like in Exchange, but the moves of
+ * the other shards are not seen until the round is over. The coordinator then applies the moves of all shards in
+ * word order (except moves out of clusters that have become singletons) and sends them to every worker; the workers
+ * answer with the changes of their part of occurrencesClusters, which are merged and sent back to all of them as the
+ * clustering the next round starts from. Since the moves of different shards are not scored against each other, a
+ * round can lower the AMI; more rounds per iteration make this rarer at the cost of more synchronization.
+ *
+ * The coordinator only keeps the cluster of every word, the marginals of the clusters and occurrencesClusters. With
+ * one worker and one round per iteration the result is the one of Exchange.
+ */
+class DistributedExchange : public ExchangeAlgorithm {
+private:
+    vector<MessageChannel> workers;
+    word_type roundsPerIteration = DEFAULT_ROUNDS_PER_ITERATION;
+    bool countDomain = false;
+    bool vectorizedScoring = true;
+    bool boundPruning = false;
+    /**
+     * occurrencesClusters merged over all shards, row-major K x K.
+     */
+    vector_word_type occurrences;
+    vector<double> plC;
+    vector<double> prC;
+    vector_word_type clusterSizes;
+    OccurrenceDeltas mergedDeltas;
+    word_type iterations = 0;
+    uint64_t wordsEvaluated = 0;
+    uint64_t movesRejected = 0;
+
+    /**
+     * Sends the same request to every worker, setting the shard fields for each of them.
+     */
+    void broadcast(ShardRequest &request);
+
+    /**
+     * Receives one reply from every worker and merges the changes of occurrencesClusters they contain. The merged
+     * changes are applied here and sent to all workers.
+     */
+    void receiveAndMergeCounts();
+
+    /**
+     * Has the words of one round scored and applies the proposed moves in word order, skipping moves out of
+     * clusters that have become singletons.
+     * @return the moves applied, as words and their new clusters
+     */
+    std::pair<vector_word_type, vector_word_type> runRound(word_type round);
+
+public:
+    constexpr static word_type DEFAULT_ROUNDS_PER_ITERATION = 64;
+
+    /**
+     * @param workers connections to workers that serve requests with ExchangeShard::serve on the same corpus
+     * @throws runtime_error if there are no workers
+     */
+    DistributedExchange(corpus_handle corpus, vector<MessageChannel> workers);
+
+    ~DistributedExchange() override = default;
+
+    vector<word_type> cluster(word_type numClusters, word_type noIterations, double minAMIChange) override;
+
+    /**
+     * Runs until noIterations iterations have been made, or an iteration makes no move or raises the AMI by less
+     * than minAMIChange.
+     * @throws runtime_error if a worker fails or closes its connection
+     */
+    vector<word_type> cluster(word_type numClusters, word_type noIterations, vector<word_type> clusterAssignments,
+                              double minAMIChange) override;
+
+    double calculateAMI() override;
+
+    string getName() override { return "DistributedExchange"; };
+
+    /**
+     * Sets the number of rounds per iteration, see the class description.
+     */
+    void setRoundsPerIteration(const word_type rounds) {
+        roundsPerIteration = std::max<word_type>(1, rounds);
+    }
+
+    /**
+     * Settings of the scoring in the workers, see the corresponding methods of Exchange. Take effect with the next
+     * call to cluster.
+     */
+    void setCountDomain(const bool enabled) {
+        countDomain = enabled;
+    }
+
+    void setVectorizedScoring(const bool enabled) {
+        vectorizedScoring = enabled;
+    }
+
+    void setBoundPruning(const bool enabled) {
+        boundPruning = enabled;
+    }
+
+    word_type getIterations() const {
+        return iterations;
+    }
+
+    /**
+     * Number of words scored by all workers together during the last call to cluster.
+     */
+    uint64_t getWordsEvaluated() const {
+        return wordsEvaluated;
+    }
+
+    /**
+     * Number of proposed moves that were not applied because their cluster had become a singleton earlier in the
+     * same round, during the last call to cluster.
+     */
+    uint64_t getMovesRejected() const {
+        return movesRejected;
+    }
+
+    /**
+     * Number of bytes sent to and received from the workers since they were connected.
+     */
+    uint64_t getBytesTransferred() const;
+};
+
+
+#endif //DISTRIBUTEDEXCHANGE_H
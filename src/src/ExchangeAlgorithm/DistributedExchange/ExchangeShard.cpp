@@ -0,0 +1,201 @@
+#include "ExchangeShard.h"
+#include <omp.h>
+
+template<typename F>
+void ExchangeShard::forEachMovedBigram(const vector_word_type &words, F f) const {
+    for (const word_type wordID : words) {
+        if (ownsWord(wordID)) {
+            for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+                f(wordID, right.neighbour, right.count);
+            }
+        }
+//        bigrams whose preceding word moved as well were visited with that word
+        for (const BigramEntry &left : corpus.getOccurrencesTransposed().row(wordID)) {
+            if (ownsWord(left.neighbour) && !moved[left.neighbour]) {
+                f(left.neighbour, wordID, left.count);
+            }
+        }
+    }
+}
+
+void ExchangeShard::serve(MessageChannel &channel) {
+    while (!channel.atEnd()) {
+        const ShardRequest request = channel.receive<ShardRequest>();
+        switch (request.type) {
+            case ShardRequest::SETUP:
+                channel.send(setUp(request));
+                break;
+            case ShardRequest::MOVES:
+                channel.send(applyMoves(request.words, request.clusters));
+                break;
+            case ShardRequest::MERGED_COUNTS:
+                applyMergedCounts(request.entries, request.deltas);
+                break;
+            case ShardRequest::SCORE:
+                channel.send(score(request.round, request.roundsPerIteration));
+                break;
+            default:
+                throw runtime_error("Unknown request " + std::to_string(request.type));
+        }
+    }
+}
+
+ShardReply ExchangeShard::setUp(const ShardRequest &request) {
+    if (request.clusters.size() != corpus.vocabularySize) {
+        throw runtime_error("Received " + std::to_string(request.clusters.size()) + " cluster assignments for a "
+                            + "vocabulary of " + std::to_string(corpus.vocabularySize) + " words");
+    }
+    if (request.numShards == 0 || request.shard >= request.numShards) {
+        throw runtime_error("Invalid shard " + std::to_string(request.shard) + " of "
+                            + std::to_string(request.numShards));
+    }
+    this->shard = request.shard;
+    this->numShards = request.numShards;
+    this->numClusters = request.numClusters;
+    this->wordsEvaluated = 0;
+    this->candidatesBounded = 0;
+    this->candidatesPruned = 0;
+    setCountDomain(request.countDomain);
+    setVectorizedScoring(request.vectorizedScoring);
+    setBoundPruning(request.boundPruning);
+    applyScoringSettings();
+    placeWordScalars();
+    wordsToClusters = request.clusters;
+    moved = vector<bool>(corpus.vocabularySize, false);
+    wordToCluster = WordClusterCounts(corpus.occurrences, wordsToClusters, numClusters, WordClusterCounts::SPARSE,
+                                      shard, numShards);
+    clusterToWord = corpus.symmetric ? WordClusterCounts()
+                                     : WordClusterCounts(corpus.occurrencesTransposed, wordsToClusters, numClusters,
+                                                         WordClusterCounts::SPARSE, shard, numShards);
+    plC = vector<double>(numClusters, 0);
+    prC = vector<double>(numClusters, 0);
+    clusterContent = vector<set<word_type>>(numClusters, set<word_type>());
+    for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+        plC[wordsToClusters[wordID]] += corpus.pl[wordID];
+        prC[wordsToClusters[wordID]] += corpus.pr[wordID];
+        clusterContent[wordsToClusters[wordID]].insert(clusterContent[wordsToClusters[wordID]].end(), wordID);
+    }
+    NumaPlacement::fillByColumnBlocks(occurrencesClusters, numClusters, numClusters, 0u, parallelFirstTouch);
+    deltas.reset((uint64_t) numClusters * numClusters);
+    for (word_type wordID = shard; wordID < corpus.vocabularySize; wordID += numShards) {
+        const uint64_t rowStart = (uint64_t) wordsToClusters[wordID] * numClusters;
+        for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+            deltas.add(rowStart + wordsToClusters[right.neighbour], right.count);
+        }
+    }
+    entropiesStale = true;
+    ShardReply reply;
+    deltas.drain(reply.entries, reply.deltas);
+    return reply;
+}
+
+ShardReply ExchangeShard::applyMoves(const vector_word_type &words, const vector_word_type &clusters) {
+    for (const word_type wordID : words) {
+        moved[wordID] = true;
+    }
+//    take the bigrams of the moved words out under the old clusters and add them back under the new ones, so that
+//    bigrams between two moved words are counted correctly
+    const auto countBigram = [&](const int64_t sign) {
+        return [&, sign](const word_type precedingWord, const word_type followingWord, const word_type count) {
+            const uint64_t entry = (uint64_t) wordsToClusters[precedingWord] * numClusters
+                                   + wordsToClusters[followingWord];
+            deltas.add(entry, sign * (int64_t) count);
+        };
+    };
+    forEachMovedBigram(words, countBigram(-1));
+    for (size_t i = 0; i < words.size(); ++i) {
+        const word_type wordID = words[i];
+        const word_type clusterToMoveFrom = wordsToClusters[wordID];
+        const word_type clusterToMoveTo = clusters[i];
+        plC[clusterToMoveFrom] -= corpus.pl[wordID];
+        prC[clusterToMoveFrom] -= corpus.pr[wordID];
+        plC[clusterToMoveTo] += corpus.pl[wordID];
+        prC[clusterToMoveTo] += corpus.pr[wordID];
+        clusterContent[clusterToMoveFrom].erase(wordID);
+        clusterContent[clusterToMoveTo].insert(wordID);
+        for (const BigramEntry &left : corpus.getOccurrencesTransposed().row(wordID)) {
+            if (ownsWord(left.neighbour)) {
+                wordToCluster.subtract(left.neighbour, clusterToMoveFrom, left.count);
+                wordToCluster.add(left.neighbour, clusterToMoveTo, left.count);
+            }
+        }
+//        a symmetric corpus keeps no clusterToWord, see Exchange::wordToCluster
+        if (!corpus.symmetric) {
+            for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+                if (ownsWord(right.neighbour)) {
+                    clusterToWord.subtract(right.neighbour, clusterToMoveFrom, right.count);
+                    clusterToWord.add(right.neighbour, clusterToMoveTo, right.count);
+                }
+            }
+        }
+        wordsToClusters[wordID] = clusterToMoveTo;
+    }
+    forEachMovedBigram(words, countBigram(1));
+    entropiesStale = true;
+    for (const word_type wordID : words) {
+        moved[wordID] = false;
+    }
+    ShardReply reply;
+    deltas.drain(reply.entries, reply.deltas);
+    return reply;
+}
+
+void ExchangeShard::applyMergedCounts(const vector<uint64_t> &entries, const vector<int64_t> &changes) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+        occurrencesClusters[entries[i] / numClusters][entries[i] % numClusters] += changes[i];
+    }
+    entropiesStale = true;
+}
+
+ShardReply ExchangeShard::score(const word_type round, const word_type roundsPerIteration) {
+    if (entropiesStale) {
+        computeEntropies();
+        entropiesStale = false;
+    }
+    vector_word_type words;
+    for (word_type wordID = shard; wordID < corpus.vocabularySize; wordID += numShards) {
+        if (roundOfWord(wordID, roundsPerIteration) == round) {
+            words.push_back(wordID);
+        }
+    }
+    const vector<double> plAtStart = plC;
+    const vector<double> prAtStart = prC;
+    ShardReply reply;
+    vector_word_type previousClusters;
+    vector<double> amiChange(numClusters, 0);
+#pragma omp parallel
+    {
+        WordEvaluation evaluation;
+        for (const word_type wordID : words) {
+//            the clustering only changes in the single section, after which all threads wait
+            if (clusterContent[wordsToClusters[wordID]].size() <= 1) {
+                continue;
+            }
+            prepareWordEvaluation(wordID, evaluation);
+            scoreAllCandidates(evaluation, amiChange);
+#pragma omp single
+            {
+                ++reply.wordsEvaluated;
+                const word_type clusterToMoveTo = selectCandidate(amiChange, evaluation.source);
+                if (clusterToMoveTo != evaluation.source) {
+                    reply.words.push_back(wordID);
+                    reply.clusters.push_back(clusterToMoveTo);
+                    previousClusters.push_back(evaluation.source);
+                    performMoveAndReturnAMIChange(wordID, clusterToMoveTo);
+                }
+            }
+        }
+    }
+    wordsEvaluated += reply.wordsEvaluated;
+//    undo the moves in reverse order, which restores the counts exactly; the moves the coordinator accepts are
+//    applied again by applyMoves
+    for (size_t i = reply.words.size(); i > 0; --i) {
+        performMoveAndReturnAMIChange(reply.words[i - 1], previousClusters[i - 1]);
+    }
+    plC = plAtStart;
+    prC = prAtStart;
+    if (!reply.words.empty()) {
+        entropiesStale = true;
+    }
+    return reply;
+}
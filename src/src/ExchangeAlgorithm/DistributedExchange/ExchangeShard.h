@@ -0,0 +1,83 @@
+#ifndef EXCHANGESHARD_H
+#define EXCHANGESHARD_H
+
+
+#include "../../models/Corpus.h"
+#include "../Exchange/Exchange.h"
+#include "MessageChannel.h"
+#include "ShardMessages.h"
+
+/**
+ * Worker of DistributedExchange. Owns the words w with w % numShards == shard: only their rows of wordToCluster and
+ * clusterToWord are stored, and only their bigrams are counted into its part of occurrencesClusters. Besides that
+ * it keeps the cluster of every word and a copy of occurrencesClusters, plC and prC merged over all shards.
+ *
+ * The words of a round are processed one after the other like in Exchange, with every move applied to the local
+ * copy so that the following words of the shard see it. Moves of other shards are only seen after the round. The
+ * local moves are then undone again, and the moves the coordinator decided on are applied to the state of the start
+ * of the round. All requests are answered in the order they arrive, see ShardRequest.
+ */
+class ExchangeShard : public Exchange {
+private:
+    word_type shard = 0;
+    word_type numShards = 1;
+    /**
+     * Changes of this shard's part of occurrencesClusters that have not been sent yet.
+     */
+    OccurrenceDeltas deltas;
+    /**
+     * Whether the entropies have to be recomputed before the next round, i.e. occurrencesClusters or the marginals
+     * changed other than by a local move.
+     */
+    bool entropiesStale = true;
+    vector<bool> moved;
+
+    bool ownsWord(const word_type wordID) const {
+        return wordID % numShards == shard;
+    }
+
+    /**
+     * Calls f(precedingWord, followingWord, count) for every bigram of the shard's words in which at least one of
+     * the moved words takes part, each bigram once. Requires moved to be set for the moved words.
+     */
+    template<typename F>
+    void forEachMovedBigram(const vector_word_type &words, F f) const;
+
+    ShardReply setUp(const ShardRequest &request);
+
+    /**
+     * Applies moves decided by the coordinator and returns the changes of the shard's part of occurrencesClusters.
+     */
+    ShardReply applyMoves(const vector_word_type &words, const vector_word_type &clusters);
+
+    void applyMergedCounts(const vector<uint64_t> &entries, const vector<int64_t> &changes);
+
+    /**
+     * Processes the words of the shard in a round and returns the moves made, which are undone before returning.
+     */
+    ShardReply score(word_type round, word_type roundsPerIteration);
+
+public:
+    ExchangeShard(corpus_handle corpus) : Exchange(std::move(corpus)) {};
+
+    ~ExchangeShard() override = default;
+
+    string getName() override { return "ExchangeShard"; };
+
+    /**
+     * Answers the requests arriving through the channel until the other end closes it.
+     * @throws runtime_error if the connection fails or a request does not fit the corpus
+     */
+    void serve(MessageChannel &channel);
+
+    /**
+     * The round of an iteration in which a word is processed. Spreads words of similar frequency evenly over the
+     * rounds and, independently of that, over the shards.
+     */
+    static word_type roundOfWord(const word_type wordID, const word_type roundsPerIteration) {
+        return (word_type) ((((uint64_t) wordID * 0x9E3779B97F4A7C15ull) >> 32u) % roundsPerIteration);
+    }
+};
+
+
+#endif //EXCHANGESHARD_H
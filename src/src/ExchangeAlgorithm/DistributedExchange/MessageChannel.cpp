@@ -0,0 +1,178 @@
+#include "MessageChannel.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    runtime_error socketError(const string &what) {
+        return runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    sockaddr_un socketAddress(const string &socketPath) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw runtime_error("Socket path " + socketPath + " is too long");
+        }
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        return address;
+    }
+}
+
+MessageChannel &MessageChannel::operator=(MessageChannel &&other) noexcept {
+    if (this != &other) {
+        if (fileDescriptor >= 0) {
+            close(fileDescriptor);
+        }
+        fileDescriptor = other.fileDescriptor;
+        bytesTransferred = other.bytesTransferred;
+        other.fileDescriptor = -1;
+    }
+    return *this;
+}
+
+MessageChannel::~MessageChannel() {
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+}
+
+std::pair<MessageChannel, MessageChannel> MessageChannel::createPair() {
+    int fileDescriptors[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fileDescriptors) != 0) {
+        throw socketError("Socket pair could not be created");
+    }
+    return {MessageChannel(fileDescriptors[0]), MessageChannel(fileDescriptors[1])};
+}
+
+MessageChannel MessageChannel::connectTo(const string &socketPath) {
+    const int socketDescriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socketDescriptor < 0) {
+        throw socketError("Socket could not be created");
+    }
+    MessageChannel channel(socketDescriptor);
+    const sockaddr_un address = socketAddress(socketPath);
+    if (connect(socketDescriptor, (const sockaddr *) &address, sizeof(address)) != 0) {
+        throw socketError("Could not connect to " + socketPath);
+    }
+    return channel;
+}
+
+void MessageChannel::sendBytes(const string &message) {
+    const uint64_t size = message.size();
+    writeFully((const char *) &size, sizeof(size));
+    writeFully(message.data(), message.size());
+}
+
+string MessageChannel::receiveBytes() {
+    uint64_t size;
+    if (!readFully((char *) &size, sizeof(size))) {
+        throw runtime_error("Connection closed by the other end");
+    }
+    string message(size, '\0');
+    if (size > 0 && !readFully(&message[0], size)) {
+        throw runtime_error("Connection closed in the middle of a message");
+    }
+    return message;
+}
+
+bool MessageChannel::atEnd() {
+    char byte;
+    while (true) {
+        const ssize_t received = recv(fileDescriptor, &byte, 1, MSG_PEEK);
+        if (received >= 0) {
+            return received == 0;
+        }
+        if (errno != EINTR) {
+            throw socketError("Receiving failed");
+        }
+    }
+}
+
+void MessageChannel::writeFully(const char *data, size_t size) {
+    while (size > 0) {
+//        MSG_NOSIGNAL turns a closed other end into an error instead of SIGPIPE
+        const ssize_t sent = ::send(fileDescriptor, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Sending failed");
+        }
+        data += sent;
+        size -= sent;
+        bytesTransferred += sent;
+    }
+}
+
+bool MessageChannel::readFully(char *data, size_t size) {
+    bool first = true;
+    while (size > 0) {
+        const ssize_t received = recv(fileDescriptor, data, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Receiving failed");
+        }
+        if (received == 0) {
+            if (first) {
+                return false;
+            }
+            throw runtime_error("Connection closed in the middle of a message");
+        }
+        first = false;
+        data += received;
+        size -= received;
+        bytesTransferred += received;
+    }
+    return true;
+}
+
+MessageListener::MessageListener(const string &socketPath) : socketPath(socketPath) {
+    fileDescriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fileDescriptor < 0) {
+        throw socketError("Socket could not be created");
+    }
+    const sockaddr_un address = socketAddress(socketPath);
+    if (bind(fileDescriptor, (const sockaddr *) &address, sizeof(address)) != 0) {
+        const runtime_error error = socketError("Could not bind to " + socketPath);
+        close(fileDescriptor);
+        throw error;
+    }
+    if (listen(fileDescriptor, SOMAXCONN) != 0) {
+        const runtime_error error = socketError("Could not listen on " + socketPath);
+        close(fileDescriptor);
+        unlink(socketPath.c_str());
+        throw error;
+    }
+}
+
+MessageListener::~MessageListener() {
+    close(fileDescriptor);
+    unlink(socketPath.c_str());
+}
+
+MessageChannel MessageListener::accept() {
+    while (true) {
+        const int connection = ::accept4(fileDescriptor, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection >= 0) {
+            return MessageChannel(connection);
+        }
+        if (errno != EINTR) {
+            throw socketError("Accepting a connection on " + socketPath + " failed");
+        }
+    }
+}
+
+bool MessageListener::waitForConnection(const int timeoutMilliseconds) {
+    pollfd request{fileDescriptor, POLLIN, 0};
+    const int ready = poll(&request, 1, timeoutMilliseconds);
+    if (ready < 0 && errno != EINTR) {
+        throw socketError("Waiting for a connection on " + socketPath + " failed");
+    }
+    return ready > 0;
+}
@@ -0,0 +1,139 @@
+#ifndef MESSAGECHANNEL_H
+#define MESSAGECHANNEL_H
+
+
+#include "../../Utils.h"
+#include <sstream>
+#include <utility>
+#include <cereal/archives/binary.hpp>
+
+/**
+ * One end of a connected Unix domain stream socket that carries length-prefixed messages. Messages are structs
+ * serialized with cereal; both ends run on the same machine, so the native binary archive is used. Closes the socket
+ * when destroyed.
+ */
+class MessageChannel {
+public:
+    /**
+     * Takes over a connected socket.
+     */
+    explicit MessageChannel(int fileDescriptor) : fileDescriptor(fileDescriptor) {};
+
+    MessageChannel(MessageChannel &&other) noexcept : fileDescriptor(other.fileDescriptor) {
+        other.fileDescriptor = -1;
+    };
+
+    MessageChannel &operator=(MessageChannel &&other) noexcept;
+
+    MessageChannel(const MessageChannel &) = delete;
+
+    MessageChannel &operator=(const MessageChannel &) = delete;
+
+    ~MessageChannel();
+
+    /**
+     * Creates two channels connected to each other.
+     * @throws runtime_error if the socket pair cannot be created
+     */
+    static std::pair<MessageChannel, MessageChannel> createPair();
+
+    /**
+     * Connects to a MessageListener.
+     * @throws runtime_error if the connection fails
+     */
+    static MessageChannel connectTo(const string &socketPath);
+
+    /**
+     * Sends one message. Blocks until all of it has been written to the socket.
+     * @throws runtime_error if the socket fails or the other end has been closed
+     */
+    void sendBytes(const string &message);
+
+    /**
+     * Receives one message. Blocks until all of it has arrived.
+     * @throws runtime_error if the socket fails or the other end has been closed
+     */
+    string receiveBytes();
+
+    /**
+     * Whether the other end has been closed. Blocks until either a message or the end of the stream arrives.
+     */
+    bool atEnd();
+
+    /**
+     * Number of bytes sent and received through the channel, including the length prefixes.
+     */
+    uint64_t getBytesTransferred() const {
+        return bytesTransferred;
+    }
+
+    template<class T>
+    void send(const T &message) {
+        std::ostringstream stream(std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(stream);
+            archive(message);
+        }
+        sendBytes(stream.str());
+    }
+
+    template<class T>
+    T receive() {
+        std::istringstream stream(receiveBytes(), std::ios::binary);
+        T message;
+        cereal::BinaryInputArchive archive(stream);
+        archive(message);
+        return message;
+    }
+
+private:
+    int fileDescriptor;
+    uint64_t bytesTransferred = 0;
+
+    void writeFully(const char *data, size_t size);
+
+    /**
+     * Reads exactly size bytes. Returns false if the stream ends before the first byte.
+     */
+    bool readFully(char *data, size_t size);
+};
+
+/**
+ * Unix domain socket bound to a path on which MessageChannels are accepted. The path is removed again when the
+ * listener is destroyed.
+ */
+class MessageListener {
+public:
+    /**
+     * @throws runtime_error if the socket cannot be bound to the path, e.g. because the path exists
+     */
+    explicit MessageListener(const string &socketPath);
+
+    MessageListener(const MessageListener &) = delete;
+
+    MessageListener &operator=(const MessageListener &) = delete;
+
+    ~MessageListener();
+
+    /**
+     * Waits for the next connection.
+     * @throws runtime_error if accepting fails
+     */
+    MessageChannel accept();
+
+    /**
+     * Waits at most timeoutMilliseconds for a connection and returns whether one can be accepted without blocking.
+     */
+    bool waitForConnection(int timeoutMilliseconds);
+
+    const string &getSocketPath() const {
+        return socketPath;
+    }
+
+private:
+    int fileDescriptor;
+    string socketPath;
+};
+
+
+#endif //MESSAGECHANNEL_H
@@ -0,0 +1,112 @@
+#ifndef SHARDMESSAGES_H
+#define SHARDMESSAGES_H
+
+
+#include "../../Utils.h"
+#include <cereal/types/vector.hpp>
+
+/**
+ * Request from DistributedExchange to one of its ExchangeShard workers.
+ */
+struct ShardRequest {
+    enum Type : uint8_t {
+        /**
+         * Starts a clustering: the worker takes over shard, numShards, numClusters, the scoring settings and the
+         * cluster of every word (in clusters) and answers with the counts of its shard as changes from zero.
+         */
+        SETUP,
+        /**
+         * Moves the words to the given clusters. Answered with the changes of the shard's part of
+         * occurrencesClusters.
+         */
+        MOVES,
+        /**
+         * Changes of occurrencesClusters merged over all shards (entries and deltas). Not answered.
+         */
+        MERGED_COUNTS,
+        /**
+         * Scores the words of the shard that belong to round out of roundsPerIteration against the clustering.
+         * Answered with the moves the worker proposes.
+         */
+        SCORE
+    };
+    Type type = SETUP;
+    word_type shard = 0;
+    word_type numShards = 1;
+    word_type numClusters = 0;
+    bool countDomain = false;
+    bool vectorizedScoring = true;
+    bool boundPruning = false;
+    word_type round = 0;
+    word_type roundsPerIteration = 1;
+    vector_word_type words;
+    vector_word_type clusters;
+    /**
+     * Changed entries of occurrencesClusters (i * K + j) and by how much they changed.
+     */
+    vector<uint64_t> entries;
+    vector<int64_t> deltas;
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(type, shard, numShards, numClusters, countDomain, vectorizedScoring, boundPruning, round,
+           roundsPerIteration, words, clusters, entries, deltas);
+    }
+};
+
+/**
+ * Answer of an ExchangeShard to a ShardRequest: changes of its part of occurrencesClusters (for SETUP and MOVES) or
+ * the proposed moves in increasing order of word IDs (for SCORE).
+ */
+struct ShardReply {
+    vector<uint64_t> entries;
+    vector<int64_t> deltas;
+    vector_word_type words;
+    vector_word_type clusters;
+    uint64_t wordsEvaluated = 0;
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(entries, deltas, words, clusters, wordsEvaluated);
+    }
+};
+
+/**
+ * Changes of the entries of a K x K count matrix, collected so that only the changed entries have to be sent.
+ */
+class OccurrenceDeltas {
+public:
+    void reset(const uint64_t numEntries) {
+        values = vector<int64_t>(numEntries, 0);
+        touched.clear();
+    }
+
+    void add(const uint64_t entry, const int64_t delta) {
+        if (values[entry] == 0) {
+            touched.push_back(entry);
+        }
+        values[entry] += delta;
+    }
+
+    /**
+     * Appends the nonzero changes to entries and deltas in the order they were first made, and starts over.
+     */
+    void drain(vector<uint64_t> &entries, vector<int64_t> &deltas) {
+        for (const uint64_t entry : touched) {
+//            an entry that went back to 0 and changed again is listed twice, but only nonzero once
+            if (values[entry] != 0) {
+                entries.push_back(entry);
+                deltas.push_back(values[entry]);
+                values[entry] = 0;
+            }
+        }
+        touched.clear();
+    }
+
+private:
+    vector<int64_t> values;
+    vector<uint64_t> touched;
+};
+
+
+#endif //SHARDMESSAGES_H
@@ -1,10 +1,128 @@
 #include <fstream>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <omp.h>
 #include "Exchange.h"
 
+std::atomic<bool> Exchange::checkpointRequested(false);
+
+namespace {
+    /**
+     * Counts below this value have their n * log2(n) looked up instead of computed.
+     */
+    const word_type N_LOG_N_TABLE_SIZE = 1u << 16u;
+
+    const vector<double> &nLogNTable() {
+        static const vector<double> table = [] {
+            vector<double> values(N_LOG_N_TABLE_SIZE, 0);
+            for (word_type n = 2; n < N_LOG_N_TABLE_SIZE; ++n) {
+                values[n] = n * std::log2((double) n);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    /**
+     * log2 for non-negative, finite arguments written without calls or branches so that loops using it can be
+     * vectorized. The argument is split into 2^e * m with m in [sqrt(0.5), sqrt(2)) using integer arithmetic only
+     * and log(m) is evaluated with the series 2 * atanh((m - 1) / (m + 1)), which is accurate to a few ulp on that
+     * interval. Returns -1023 for 0.
+     */
+    inline double vectorizableLog2(const double x) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+//        shifting by the bits of sqrt(0.5) moves mantissas above sqrt(2) into the next exponent
+        const uint64_t biasedExponent = (bits - 0x3FE6A09E667F3BCDull + 0x3FF0000000000000ull) >> 52u;
+//        the exponent as a double, without an integer to floating point conversion
+        const uint64_t exponentBits = 0x4330000000000000ull | biasedExponent;
+        double exponent;
+        std::memcpy(&exponent, &exponentBits, sizeof(exponent));
+        exponent -= 4503599627370496.0 + 1023.0;
+        const uint64_t mantissaBits = bits - (biasedExponent << 52u) + 0x3FF0000000000000ull;
+        double mantissa;
+        std::memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+        const double f = (mantissa - 1) / (mantissa + 1);
+        const double f2 = f * f;
+        double series = 1.0 / 23;
+        series = series * f2 + 1.0 / 21;
+        series = series * f2 + 1.0 / 19;
+        series = series * f2 + 1.0 / 17;
+        series = series * f2 + 1.0 / 15;
+        series = series * f2 + 1.0 / 13;
+        series = series * f2 + 1.0 / 11;
+        series = series * f2 + 1.0 / 9;
+        series = series * f2 + 1.0 / 7;
+        series = series * f2 + 1.0 / 5;
+        series = series * f2 + 1.0 / 3;
+        series = series * f2 + 1.0;
+        return exponent + 2.8853900817779268 * f * series;
+    }
+
+    /**
+     * Busy-waits until done() holds. Waits between words are short, so spinning is cheaper than sleeping, but after a
+     * while the thread yields in case there are more threads than cores.
+     */
+    template<typename Condition>
+    void spinUntil(Condition done) {
+        for (uint32_t spins = 0; !done(); ++spins) {
+            if (spins >= 1024) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * x * log2(x). For x = 0 the logarithm is finite, so the product is 0 without a select.
+     */
+    inline double vectorizableEntropyTerm(const double x) {
+        return x * vectorizableLog2(x);
+    }
+
+    /**
+     * The part of the occurrence terms of moving the word to candidate c that involves the source cluster and the
+     * entries [c][c], [c][source] and [source][c], see Exchange::scoreCandidates.
+     */
+    inline double ownEntriesChange(const CandidateScoring &scoring, const word_type c) {
+        const double divisor = scoring.divisor;
+        const word_type fromCandidate = scoring.clusterToWord[c];
+        const word_type toCandidate = scoring.wordToCluster[c];
+        double occurrenceDiff = scoring.sourceConstant - scoring.diagonalEntropies[c];
+        occurrenceDiff -= scoring.sourceRowEntropies[c] + scoring.sourceColumnEntropies[c];
+        occurrenceDiff += vectorizableEntropyTerm(
+                (scoring.sourceColumn[c] - fromCandidate + scoring.fromWordToSource - scoring.occurrencesToItself)
+                / divisor);
+        occurrenceDiff += vectorizableEntropyTerm(
+                (scoring.sourceRow[c] - toCandidate + scoring.fromSourceToWord - scoring.occurrencesToItself)
+                / divisor);
+        occurrenceDiff += vectorizableEntropyTerm(
+                (scoring.diagonalCounts[c] + fromCandidate + toCandidate + scoring.occurrencesToItself) / divisor);
+        return occurrenceDiff;
+    }
+
+    /**
+     * The AMI change of moving the word to candidate c, given the change of the occurrence terms: normalized and
+     * with the change of the marginal terms added.
+     */
+    inline double withMarginals(const CandidateScoring &scoring, const word_type c, const double occurrenceDiff) {
+        return occurrenceDiff * scoring.normalization + scoring.marginalConstant
+               + scoring.entropyLeft[c] + scoring.entropyRight[c]
+               - vectorizableEntropyTerm(scoring.plC[c] + scoring.pl)
+               - vectorizableEntropyTerm(scoring.prC[c] + scoring.pr);
+    }
+}
+
 double Exchange::calculateAMI() {
     double AMI = 0;
     for (word_type clusterID1 = 0; clusterID1 < this->numClusters; ++clusterID1) {
         AMI += sumRowsEntropyOccurrences[clusterID1];
+    }
+    if (countDomain) {
+//        sum over all entries of (n * log2(n) - n * log2(T)) / T
+        AMI = (AMI - occurrenceTotal * std::log2((double) corpus.getNumberOfTransitions())) * occurrenceNormalization;
+    }
+    for (word_type clusterID1 = 0; clusterID1 < this->numClusters; ++clusterID1) {
         AMI -= entropyLeft[clusterID1];
         AMI -= entropyRight[clusterID1];
     }
@@ -19,7 +137,7 @@ Exchange::cluster(const word_type noClusters, const word_type noIterations, cons
     for (word_type i = 0; i < noClusters - 1; ++i) {
         clusterAssignments[i] = i;
     }
-    return this->cluster(noClusters, noIterations, clusterAssignments);
+    return this->cluster(noClusters, noIterations, clusterAssignments, minAMIChange);
 }
 
 vector<word_type> Exchange::cluster(const word_type noClusters, const word_type noIterations,
@@ -28,65 +146,291 @@ vector<word_type> Exchange::cluster(const word_type noClusters, const word_type
     return ExchangeAlgorithm::sortClusterAssignments(this->clusterInternal(noIterations, minAMIChange), numClusters);
 }
 
-vector<word_type> Exchange::clusterInternal(const word_type noIterations, const double minAMIChange) {
+vector<word_type> Exchange::runIterations(const word_type noIterations, const double minAMIChange,
+                                          const std::function<WordSweep()> &makeSweep) {
+    startClustering();
     if (noIterations > 0) {
-        double AMI = calculateAMI();
+        iterationStartAMI = resuming ? resumeIterationStartAMI : calculateAMI();
+        const word_type firstWordID = resuming ? resumeWordID : 0;
+        const uint32_t firstChanges = resuming ? resumeChanges : 0;
+        const bool resumingIteration = resuming;
+        resuming = false;
         changesInPreviousIteration = 1;
-        vector<double> amiChange;
+        iteration = 0;
 #pragma omp parallel
-        for (iteration = 0; iteration < noIterations; ++iteration) {
-            if (changesInPreviousIteration == 0 && !AMIIncreasingOverThreshold) {
-                break;
-            }
+        {
+            const WordSweep sweep = makeSweep();
+            for (word_type currentIteration = 0; currentIteration < noIterations; ++currentIteration) {
+//                stopping is also set between iterations, when the telemetry cannot be written
+                if (hasConverged() || stopping) {
+                    break;
+                }
 #pragma omp barrier
 #pragma omp single
-            {
-                changesInPreviousIteration = 0;
-            }
-            for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
-                const word_type clusterToMoveFrom = wordsToClusters[wordID];
-                if (clusterContent[clusterToMoveFrom].size() > 1) {
+                {
+                    beginIteration(currentIteration == 0 && resumingIteration);
+                    changesInPreviousIteration = currentIteration == 0 ? firstChanges : 0;
+                    if (telemetry.isEnabled()) {
+                        startIterationTelemetry();
+                    }
+                }
+                PhaseClock clock(telemetry.isEnabled());
+                clock.start();
+                sweep(currentIteration == 0 ? firstWordID : 0, clock);
+//                set between two words by the thread that applies the moves, seen by all threads once they are done
+                if (stopping) {
+                    break;
+                }
+                if (telemetry.isEnabled()) {
+                    telemetry.store(omp_get_thread_num(), clock);
 #pragma omp barrier
+                }
 #pragma omp single
-                    {
-                        amiChange = vector<double>(numClusters, 0);
+                {
+                    const std::chrono::steady_clock::time_point amiStart = std::chrono::steady_clock::now();
+                    const double newAMI = calculateAMI();
+                    endIteration(newAMI, minAMIChange);
+                    iterationStartAMI = newAMI;
+                    iteration = currentIteration + 1;
+                    ++completedIterations;
+                    keepIfBest(newAMI);
+                    if (telemetry.isEnabled()) {
+                        finishIterationTelemetry(newAMI, std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - amiStart).count());
                     }
-#pragma omp for
-                    for (word_type clusterCandidate = 0; clusterCandidate < numClusters; ++clusterCandidate) {
-                        if (clusterCandidate == clusterToMoveFrom) {
-                            amiChange[clusterCandidate] = 0;
+                }
+            }
+        }
+//        exceptions cannot leave the parallel region, so a failure is thrown once the threads are done
+        if (!writeFailure.empty()) {
+            throw runtime_error(writeFailure);
+        }
+    }
+    return clusteringResult();
+}
+
+bool Exchange::hasConverged() const {
+    return changesInPreviousIteration == 0 && !AMIIncreasingOverThreshold && fullSweep;
+}
+
+void Exchange::beginIteration(const bool resumedIteration) {
+    if (resumedIteration) {
+        fullSweep = resumeFullSweep;
+    } else {
+        startSweep();
+    }
+}
+
+void Exchange::endIteration(const double ami, const double minAMIChange) {
+    AMIIncreasingOverThreshold = ami - iterationStartAMI > minAMIChange;
+    pendingFullSweep = !fullSweep && changesInPreviousIteration == 0;
+}
+
+void Exchange::finishWord(const word_type nextWordID) {
+    if (stopDue()) {
+        stopBetweenWords(nextWordID);
+    } else if (checkpointDue()) {
+        writeCheckpoint(nextWordID);
+    }
+}
+
+vector<word_type> Exchange::clusterInternal(const word_type noIterations, const double minAMIChange) {
+    if (speculativeBatchSize > 1) {
+        return clusterSpeculatively(noIterations, minAMIChange);
+    }
+    const word_type numMovableWords = getNumberOfMovableWords();
+    vector<double> amiChange(numClusters, 0);
+    vector<BlockBest> blockBests(omp_get_max_threads());
+//    Per word, every thread prepares its own evaluation and scores a fixed block of candidates, then the master
+//    thread combines the block bests and applies the move. Instead of barriers the threads count words: a thread
+//    publishes its block best by increasing blocksScored, the master publishes the move by setting wordsMoved.
+//    If the clusters are shared among the threads for the entropy refresh of a move, the master publishes the
+//    counts of the move by setting wordsDecided, every thread refreshes its block of clusters and reports by
+//    increasing blocksRefreshed, and then the master combines the diffs and sets wordsMoved.
+    std::atomic<uint64_t> blocksScored(0);
+    std::atomic<uint64_t> wordsDecided(0);
+    std::atomic<uint64_t> blocksRefreshed(0);
+    std::atomic<uint64_t> wordsMoved(0);
+    vector<MoveDiffs> moveDiffs(omp_get_max_threads());
+    word_type sharedMoveTarget = 0;
+    return runIterations(noIterations, minAMIChange, [&]() -> WordSweep {
+        const word_type threadID = omp_get_thread_num();
+        const word_type numThreads = omp_get_num_threads();
+        const pair<uint64_t, uint64_t> block = NumaPlacement::columnBlock(numClusters, threadID, numThreads);
+        const word_type first = block.first;
+        const word_type last = block.second;
+        const bool shareMoves = numThreads > 1 && numClusters >= MIN_CLUSTERS_PER_THREAD_FOR_SHARED_MOVES * numThreads;
+//        words evaluated by the team so far, the same on all threads, and the moves whose refresh was shared, only
+//        counted by the master; both carry over from one iteration to the next
+        return [&, threadID, numThreads, first, last, shareMoves, evaluation = WordEvaluation(),
+                wordsEvaluatedByTeam = (uint64_t) 0, sharedMoves = (uint64_t) 0](
+                const word_type firstWordID, PhaseClock &clock) mutable {
+            for (word_type wordID = firstWordID; wordID < numMovableWords; ++wordID) {
+                if (clusterContent[wordsToClusters[wordID]].size() <= 1 || !isActive(wordID)) {
+                    continue;
+                }
+                const uint64_t wordNumber = ++wordsEvaluatedByTeam;
+                prepareWordEvaluation(wordID, evaluation);
+                scoreBlock(evaluation, first, last, amiChange.data());
+                blockBests[threadID] = bestInBlock(amiChange.data(), first, last);
+                blocksScored.fetch_add(1, std::memory_order_release);
+                clock.candidates += last - first;
+                clock.lap(clock.scoring);
+                const word_type clusterToMoveFrom = evaluation.source;
+                if (threadID == 0) {
+                    spinUntil([&] {
+                        return blocksScored.load(std::memory_order_acquire) == wordNumber * numThreads;
+                    });
+                    clock.lap(clock.waiting);
+                    const word_type clusterToMoveTo = combineBlocks(amiChange.data(), blockBests.data(), numThreads,
+                                                                    clusterToMoveFrom);
+                    ++wordsEvaluated;
+                    if (clusterToMoveTo != clusterToMoveFrom) {
+                        changesInPreviousIteration++;
+                        markNeighbours(wordID);
+                        if (shareMoves) {
+                            applyMoveCounts(wordID, clusterToMoveTo);
+                            sharedMoveTarget = clusterToMoveTo;
+                            ++sharedMoves;
+                            wordsDecided.store(wordNumber, std::memory_order_release);
+                            moveDiffs[0] = MoveDiffs();
+                            refreshMovedEntries(clusterToMoveFrom, clusterToMoveTo, first, last, moveDiffs[0]);
+                            clock.lap(clock.moves);
+                            spinUntil([&] {
+                                return blocksRefreshed.load(std::memory_order_acquire)
+                                       == sharedMoves * (numThreads - 1);
+                            });
+                            clock.lap(clock.waiting);
+                            for (word_type thread = 0; thread < numThreads; ++thread) {
+                                applyMoveDiffs(clusterToMoveFrom, clusterToMoveTo, moveDiffs[thread]);
+                            }
                         } else {
-                            const double amiDiff = calculateAMIDiff(wordID, clusterCandidate);
-                            amiChange[clusterCandidate] = amiDiff;
+                            performMoveAndReturnAMIChange(wordID, clusterToMoveTo);
                         }
                     }
-#pragma omp single
-                    {
-                        const auto clusterToMoveTo = (word_type) distance(amiChange.begin(),
-                                                                          max_element(amiChange.begin(),
-                                                                                      amiChange.end()));
-                        if (clusterToMoveTo != wordsToClusters[wordID]) {
+                    finishWord(wordID + 1);
+                    clock.lap(clock.moves);
+                    wordsMoved.store(wordNumber, std::memory_order_release);
+                } else {
+                    spinUntil([&] {
+                        return wordsMoved.load(std::memory_order_acquire) == wordNumber
+                               || wordsDecided.load(std::memory_order_acquire) == wordNumber;
+                    });
+                    clock.lap(clock.waiting);
+                    if (wordsMoved.load(std::memory_order_acquire) != wordNumber) {
+                        moveDiffs[threadID] = MoveDiffs();
+                        refreshMovedEntries(clusterToMoveFrom, sharedMoveTarget, first, last, moveDiffs[threadID]);
+                        blocksRefreshed.fetch_add(1, std::memory_order_release);
+                        clock.lap(clock.moves);
+                        spinUntil([&] {
+                            return wordsMoved.load(std::memory_order_acquire) == wordNumber;
+                        });
+                        clock.lap(clock.waiting);
+                    }
+                }
+//                set by the master before it published the move of the word
+                if (stopping) {
+                    break;
+                }
+            }
+        };
+    });
+}
+
+vector<word_type> Exchange::clusterSpeculatively(const word_type noIterations, const double minAMIChange) {
+    const word_type numMovableWords = getNumberOfMovableWords();
+    const word_type batchSize = speculativeBatchSize;
+//    cluster chosen for every word of the current batch, against the clustering at the start of the batch
+    vector_word_type decisions(batchSize, 0);
+//    number of the last batch in which a word was moved out of or into a cluster
+    vector<uint64_t> touchedInBatch(numClusters, 0);
+    uint64_t batchNumber = 0;
+    return runIterations(noIterations, minAMIChange, [&]() -> WordSweep {
+        return [&, evaluation = WordEvaluation(), amiChange = vector<double>(numClusters, 0)](
+                const word_type firstWordID, PhaseClock &clock) mutable {
+            for (word_type batchStart = firstWordID; batchStart < numMovableWords; batchStart += batchSize) {
+                const word_type batchEnd = std::min<word_type>(numMovableWords, batchStart + batchSize);
+#pragma omp for schedule(dynamic, 1) nowait
+                for (word_type wordID = batchStart; wordID < batchEnd; ++wordID) {
+                    decisions[wordID - batchStart] = isActive(wordID) ? bestMove(wordID, evaluation, amiChange)
+                                                                      : numClusters;
+                    clock.candidates += isActive(wordID) ? numClusters : 0;
+                }
+                clock.lap(clock.scoring);
+#pragma omp barrier
+                clock.lap(clock.waiting);
+#pragma omp single nowait
+                {
+                    ++batchNumber;
+                    for (word_type wordID = batchStart; wordID < batchEnd; ++wordID) {
+                        if (!isActive(wordID)) {
+                            continue;
+                        }
+                        if (clusterContent[wordsToClusters[wordID]].size() > 1) {
+                            ++wordsEvaluated;
+                        }
+                        const word_type clusterToMoveFrom = wordsToClusters[wordID];
+                        word_type clusterToMoveTo = decisions[wordID - batchStart];
+//                        a word marked by an earlier move of the batch has not been scored yet
+                        if (clusterToMoveTo == numClusters ||
+                            touchedInBatch[clusterToMoveFrom] == batchNumber ||
+                            touchedInBatch[clusterToMoveTo] == batchNumber) {
+                            clusterToMoveTo = bestMove(wordID, evaluation, amiChange);
+                            speculativeWordsRescored++;
+                            clock.candidates += numClusters;
+                        } else if (clusterToMoveTo != clusterToMoveFrom) {
+//                            moves elsewhere in the batch can still have changed the gain slightly
+                            prepareWordEvaluation(wordID, evaluation);
+                            if (calculateAMIDiff(evaluation, clusterToMoveTo) > CANDIDATE_TIE_TOLERANCE) {
+                                speculativeMovesCommitted++;
+                            } else {
+                                clusterToMoveTo = bestMove(wordID, evaluation, amiChange);
+                                speculativeWordsRescored++;
+                                clock.candidates += numClusters;
+                            }
+                        }
+                        if (clusterToMoveTo != clusterToMoveFrom) {
                             performMoveAndReturnAMIChange(wordID, clusterToMoveTo);
                             changesInPreviousIteration++;
+                            markNeighbours(wordID);
+                            touchedInBatch[clusterToMoveFrom] = batchNumber;
+                            touchedInBatch[clusterToMoveTo] = batchNumber;
                         }
                     }
+                    finishWord(batchEnd);
+                    clock.lap(clock.moves);
+                }
+#pragma omp barrier
+                clock.lap(clock.waiting);
+                if (stopping) {
+                    break;
                 }
             }
-#pragma omp single
-            {
-                const double newAMI = calculateAMI();
-                const double AMIChangeInIteration = newAMI - AMI;
-                AMI = newAMI;
-                AMIIncreasingOverThreshold = AMIChangeInIteration > minAMIChange;
-            }
-        }
+        };
+    });
+}
+
+word_type Exchange::bestMove(const word_type wordID, WordEvaluation &evaluation, vector<double> &amiChange) {
+    const word_type clusterToMoveFrom = wordsToClusters[wordID];
+    if (clusterContent[clusterToMoveFrom].size() <= 1) {
+        return clusterToMoveFrom;
     }
-    return wordsToClusters;
+    prepareWordEvaluation(wordID, evaluation);
+    scoreBlock(evaluation, 0, numClusters, amiChange.data());
+    return selectCandidate(amiChange, clusterToMoveFrom);
 }
 
 void Exchange::performMoveAndReturnAMIChange(const word_type wordID,
                                              const word_type clusterToMoveTo) {
     const word_type clusterToMoveFrom = this->wordsToClusters[wordID];
+    applyMoveCounts(wordID, clusterToMoveTo);
+    MoveDiffs diffs;
+    refreshMovedEntries(clusterToMoveFrom, clusterToMoveTo, 0, numClusters, diffs);
+    applyMoveDiffs(clusterToMoveFrom, clusterToMoveTo, diffs);
+}
+
+void Exchange::applyMoveCounts(const word_type wordID, const word_type clusterToMoveTo) {
+    const word_type clusterToMoveFrom = this->wordsToClusters[wordID];
 
     plC[clusterToMoveFrom] -= corpus.pl[wordID];
     prC[clusterToMoveFrom] -= corpus.pr[wordID];
@@ -104,239 +448,906 @@ void Exchange::performMoveAndReturnAMIChange(const word_type wordID,
     wordsToClusters[wordID] = clusterToMoveTo;
 
 //            update occurrences
-    for (word_type const &rightWord : toTheRightOf[wordID]) {
+    if (corpus.symmetric) {
+        applySymmetricMoveCounts(wordID, clusterToMoveFrom, clusterToMoveTo);
+        return;
+    }
+    for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+        const word_type rightWord = right.neighbour;
         if (rightWord != wordID) {
-            const word_type noOfOccurrencesToTransfer = Utils::getOccurrence(corpus.occurrences, wordID, rightWord);
+            const word_type noOfOccurrencesToTransfer = right.count;
             const word_type rightCluster = wordsToClusters[rightWord];
             occurrencesClusters[clusterToMoveFrom][rightCluster] -= noOfOccurrencesToTransfer;
             occurrencesClusters[clusterToMoveTo][rightCluster] += noOfOccurrencesToTransfer;
 
-            clusterToWord[clusterToMoveFrom][rightWord] -= noOfOccurrencesToTransfer;
-            clusterToWord[clusterToMoveTo][rightWord] += noOfOccurrencesToTransfer;
+            clusterToWord.subtract(rightWord, clusterToMoveFrom, noOfOccurrencesToTransfer);
+            clusterToWord.add(rightWord, clusterToMoveTo, noOfOccurrencesToTransfer);
         }
     }
-    for (word_type const &leftWord : toTheLeftOf[wordID]) {
+    for (const BigramEntry &left : corpus.occurrencesTransposed.row(wordID)) {
+        const word_type leftWord = left.neighbour;
         if (leftWord != wordID) {
-            const word_type noOfOccurrencesToTransfer = Utils::getOccurrence(corpus.occurrences, leftWord, wordID);
+            const word_type noOfOccurrencesToTransfer = left.count;
             const word_type leftCluster = wordsToClusters[leftWord];
             occurrencesClusters[leftCluster][clusterToMoveFrom] -= noOfOccurrencesToTransfer;
             occurrencesClusters[leftCluster][clusterToMoveTo] += noOfOccurrencesToTransfer;
 
-            wordToCluster[leftWord][clusterToMoveFrom] -= noOfOccurrencesToTransfer;
-            wordToCluster[leftWord][clusterToMoveTo] += noOfOccurrencesToTransfer;
+            wordToCluster.subtract(leftWord, clusterToMoveFrom, noOfOccurrencesToTransfer);
+            wordToCluster.add(leftWord, clusterToMoveTo, noOfOccurrencesToTransfer);
         }
     }
-    const word_type noOfOccurrencesToItself = Utils::getOccurrence(corpus.occurrences, wordID, wordID);
+    const word_type noOfOccurrencesToItself = corpus.getOccurrence(wordID, wordID);
     if (noOfOccurrencesToItself > 0) {
         occurrencesClusters[clusterToMoveFrom][clusterToMoveFrom] -= noOfOccurrencesToItself;
         occurrencesClusters[clusterToMoveTo][clusterToMoveTo] += noOfOccurrencesToItself;
 
-        clusterToWord[clusterToMoveFrom][wordID] -= noOfOccurrencesToItself;
-        clusterToWord[clusterToMoveTo][wordID] += noOfOccurrencesToItself;
+        clusterToWord.subtract(wordID, clusterToMoveFrom, noOfOccurrencesToItself);
+        clusterToWord.add(wordID, clusterToMoveTo, noOfOccurrencesToItself);
+
+        wordToCluster.subtract(wordID, clusterToMoveFrom, noOfOccurrencesToItself);
+        wordToCluster.add(wordID, clusterToMoveTo, noOfOccurrencesToItself);
+    }
+}
+
+void Exchange::applySymmetricMoveCounts(const word_type wordID, const word_type clusterToMoveFrom,
+                                        const word_type clusterToMoveTo) {
+//    the words preceding the word are the words following it, and clusterToWord is wordToCluster
+    for (const BigramEntry &neighbour : corpus.occurrences.row(wordID)) {
+        const word_type neighbourWord = neighbour.neighbour;
+        if (neighbourWord != wordID) {
+            const word_type noOfOccurrencesToTransfer = neighbour.count;
+            const word_type neighbourCluster = wordsToClusters[neighbourWord];
+            occurrencesClusters[clusterToMoveFrom][neighbourCluster] -= noOfOccurrencesToTransfer;
+            occurrencesClusters[clusterToMoveTo][neighbourCluster] += noOfOccurrencesToTransfer;
+            occurrencesClusters[neighbourCluster][clusterToMoveFrom] -= noOfOccurrencesToTransfer;
+            occurrencesClusters[neighbourCluster][clusterToMoveTo] += noOfOccurrencesToTransfer;
+
+            wordToCluster.subtract(neighbourWord, clusterToMoveFrom, noOfOccurrencesToTransfer);
+            wordToCluster.add(neighbourWord, clusterToMoveTo, noOfOccurrencesToTransfer);
+        }
+    }
+    const word_type noOfOccurrencesToItself = corpus.getOccurrence(wordID, wordID);
+    if (noOfOccurrencesToItself > 0) {
+        occurrencesClusters[clusterToMoveFrom][clusterToMoveFrom] -= noOfOccurrencesToItself;
+        occurrencesClusters[clusterToMoveTo][clusterToMoveTo] += noOfOccurrencesToItself;
 
-        wordToCluster[wordID][clusterToMoveFrom] -= noOfOccurrencesToItself;
-        wordToCluster[wordID][clusterToMoveTo] += noOfOccurrencesToItself;
+        wordToCluster.subtract(wordID, clusterToMoveFrom, noOfOccurrencesToItself);
+        wordToCluster.add(wordID, clusterToMoveTo, noOfOccurrencesToItself);
     }
+}
 
-    const vector<word_type> cl = {clusterToMoveFrom, clusterToMoveTo};
-    for (word_type const &i : cl) {
-        double entropyChange = 0;
-#pragma omp parallel for reduction(+:entropyChange)
-        for (word_type j = 0; j < numClusters; ++j) {
-            double diff1 = 0;
-            diff1 -= entropyOccurrences[i][j];
-            entropyOccurrences[i][j] = entropyTerm(
-                    (double) occurrencesClusters[i][j] / corpus.getNumberOfTransitions());
-            diff1 += entropyOccurrences[i][j];
+void Exchange::placeWordScalars() {
+    wordScalars = NumaPlacement::replicatePerNode<aligned_vector<WordScalars>>([this] {
+        aligned_vector<WordScalars> scalars(corpus.vocabularySize);
+        for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+            scalars[wordID] = {corpus.pl[wordID], corpus.pr[wordID], corpus.getOccurrence(wordID, wordID)};
+        }
+        return scalars;
+    }, parallelFirstTouch);
+}
 
-            entropyChange += diff1;
-            this->sumColumnsEntropyOccurrences[j] += diff1;
+const WordScalars *Exchange::localWordScalars() const {
+    const word_type node = NumaPlacement::currentNode();
+    if (node < wordScalars.size() && !wordScalars[node].empty()) {
+        return wordScalars[node].data();
+    }
+    for (const aligned_vector<WordScalars> &copy : wordScalars) {
+        if (!copy.empty()) {
+            return copy.data();
         }
-        this->sumRowsEntropyOccurrences[i] += entropyChange;
     }
-    for (word_type const &i : cl) {
-        double entropyChange = 0;
-#pragma omp parallel for reduction(+:entropyChange)
-        for (word_type j = 0; j < numClusters; ++j) {
-            double diff2 = 0;
-            diff2 -= entropyOccurrences[j][i];
-            entropyOccurrences[j][i] = entropyTerm(
-                    (double) occurrencesClusters[j][i] / corpus.getNumberOfTransitions());
-            diff2 += entropyOccurrences[j][i];
-            entropyChange += diff2;
-            this->sumRowsEntropyOccurrences[j] += diff2;
+    return nullptr;
+}
+
+double Exchange::refreshEntry(const word_type clusterID1, const word_type clusterID2) {
+    const word_type count = occurrencesClusters[clusterID1][clusterID2];
+    const double term = occurrenceTerm(count);
+    const double diff = term - entropyOccurrences[clusterID1][clusterID2];
+    entropyOccurrences[clusterID1][clusterID2] = term;
+    if (vectorizedScoring) {
+        if (!corpus.symmetric) {
+            occurrencesClustersTransposed[clusterID2][clusterID1] = count;
+            entropyOccurrencesTransposed[clusterID2][clusterID1] = term;
+        }
+        if (clusterID1 == clusterID2) {
+            diagonalCounts[clusterID1] = count;
+            diagonalEntropies[clusterID1] = term;
         }
-        this->sumColumnsEntropyOccurrences[i] += entropyChange;
     }
+    return diff;
 }
 
-double Exchange::calculateAMIDiff(const word_type wordID,
-                                  const word_type clusterCandidate) {
-    const word_type clusterToMoveFrom = wordsToClusters[wordID];
-    double amiDiff = 0;
-//    this is what we used to have
-    amiDiff += entropyLeft[clusterToMoveFrom];
-    amiDiff += entropyRight[clusterToMoveFrom];
-    amiDiff += entropyLeft[clusterCandidate];
-    amiDiff += entropyRight[clusterCandidate];
-    amiDiff -= sumRowsEntropyOccurrences[clusterCandidate];
-    amiDiff -= sumColumnsEntropyOccurrences[clusterCandidate];
-    amiDiff += entropyTerm(
-            (double) occurrencesClusters[clusterCandidate][clusterCandidate] / corpus.getNumberOfTransitions());
-    amiDiff -= sumRowsEntropyOccurrences[clusterToMoveFrom];
-    amiDiff -= sumColumnsEntropyOccurrences[clusterToMoveFrom];
-    amiDiff += entropyTerm(
-            (double) occurrencesClusters[clusterToMoveFrom][clusterToMoveFrom] / corpus.getNumberOfTransitions());
-    amiDiff += entropyTerm(
-            (double) occurrencesClusters[clusterToMoveFrom][clusterCandidate] / corpus.getNumberOfTransitions());
-    amiDiff += entropyTerm(
-            (double) occurrencesClusters[clusterCandidate][clusterToMoveFrom] / corpus.getNumberOfTransitions());
+double Exchange::mirrorEntry(const word_type clusterID1, const word_type clusterID2) {
+    const double term = entropyOccurrences[clusterID2][clusterID1];
+    const double diff = term - entropyOccurrences[clusterID1][clusterID2];
+    entropyOccurrences[clusterID1][clusterID2] = term;
+    return diff;
+}
 
-//    this is what we're getting
-    for (word_type clusterID1 = 0; clusterID1 < numClusters; ++clusterID1) {
-        if (clusterID1 != clusterCandidate && clusterID1 != clusterToMoveFrom) {
-            const auto newEntropy = (double) (occurrencesClusters[clusterCandidate][clusterID1]
-                                              + wordToCluster[wordID][clusterID1]) / corpus.getNumberOfTransitions();
-            const auto contribution = entropyTerm(newEntropy);
-            amiDiff += contribution;
+void Exchange::refreshMovedEntries(const word_type clusterToMoveFrom, const word_type clusterToMoveTo,
+                                   const word_type first, const word_type last, MoveDiffs &diffs) {
+    for (word_type clusterID = first; clusterID < last; ++clusterID) {
+//        the rows of both clusters; their diffs also go to the column sums
+        const double diffFrom = refreshEntry(clusterToMoveFrom, clusterID);
+        const double diffTo = refreshEntry(clusterToMoveTo, clusterID);
+        diffs.rowFrom += diffFrom;
+        diffs.rowTo += diffTo;
+        sumColumnsEntropyOccurrences[clusterID] += diffFrom + diffTo;
+//        the columns of both clusters, without the four entries that are in the rows as well
+        if (clusterID != clusterToMoveFrom && clusterID != clusterToMoveTo) {
+            const double diffColumnFrom = corpus.symmetric ? mirrorEntry(clusterID, clusterToMoveFrom)
+                                                           : refreshEntry(clusterID, clusterToMoveFrom);
+            const double diffColumnTo = corpus.symmetric ? mirrorEntry(clusterID, clusterToMoveTo)
+                                                         : refreshEntry(clusterID, clusterToMoveTo);
+            diffs.columnFrom += diffColumnFrom;
+            diffs.columnTo += diffColumnTo;
+            sumRowsEntropyOccurrences[clusterID] += diffColumnFrom + diffColumnTo;
         }
     }
+}
 
-    for (word_type clusterID1 = 0; clusterID1 < numClusters; ++clusterID1) {
+void Exchange::applyMoveDiffs(const word_type clusterToMoveFrom, const word_type clusterToMoveTo,
+                              const MoveDiffs &diffs) {
+    sumRowsEntropyOccurrences[clusterToMoveFrom] += diffs.rowFrom;
+    sumRowsEntropyOccurrences[clusterToMoveTo] += diffs.rowTo;
+    sumColumnsEntropyOccurrences[clusterToMoveFrom] += diffs.columnFrom;
+    sumColumnsEntropyOccurrences[clusterToMoveTo] += diffs.columnTo;
+}
+
+double Exchange::calculateAMIDiff(const WordEvaluation &evaluation, const word_type clusterCandidate) {
+    const word_type wordID = evaluation.wordID;
+    const word_type clusterToMoveFrom = evaluation.source;
+    const word_type *currentWordToCluster = evaluation.wordToCluster.data();
+    const word_type *currentClusterToWord = evaluation.clusterToWord.data();
+    const WordScalars &scalars = evaluation.wordScalars[wordID];
+    const word_type occurrencesToItself = scalars.occurrencesToItself;
+//    change of the occurrence terms, normalized once at the end (see occurrenceNormalization)
+    double occurrenceDiff = 0;
+//    this is what we used to have
+    occurrenceDiff -= sumRowsEntropyOccurrences[clusterCandidate];
+    occurrenceDiff -= sumColumnsEntropyOccurrences[clusterCandidate];
+    occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterCandidate][clusterCandidate]);
+    occurrenceDiff -= sumRowsEntropyOccurrences[clusterToMoveFrom];
+    occurrenceDiff -= sumColumnsEntropyOccurrences[clusterToMoveFrom];
+    occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterToMoveFrom][clusterToMoveFrom]);
+    occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterToMoveFrom][clusterCandidate]);
+    occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterCandidate][clusterToMoveFrom]);
+
+//    this is what we're getting
+//    the candidate's row and column with the word: outside of the word's context clusters the entries do not change,
+//    so start from the cached sums and only correct the entries the word contributes to
+    occurrenceDiff += sumRowsEntropyOccurrences[clusterCandidate];
+    occurrenceDiff -= entropyOccurrences[clusterCandidate][clusterCandidate];
+    occurrenceDiff -= entropyOccurrences[clusterCandidate][clusterToMoveFrom];
+    for (const word_type clusterID1 : evaluation.rightContextClusters) {
         if (clusterID1 != clusterCandidate && clusterID1 != clusterToMoveFrom) {
-            const auto newOcc = (double) (occurrencesClusters[clusterID1][clusterCandidate]
-                                          + clusterToWord[clusterID1][wordID]) / corpus.getNumberOfTransitions();
-            const auto contribution = entropyTerm(newOcc);
-            amiDiff += contribution;
+            occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterCandidate][clusterID1]
+                                             + currentWordToCluster[clusterID1])
+                              - entropyOccurrences[clusterCandidate][clusterID1];
         }
     }
 
-    for (word_type clusterID1 = 0; clusterID1 < numClusters; ++clusterID1) {
+    occurrenceDiff += sumColumnsEntropyOccurrences[clusterCandidate];
+    occurrenceDiff -= entropyOccurrences[clusterCandidate][clusterCandidate];
+    occurrenceDiff -= entropyOccurrences[clusterToMoveFrom][clusterCandidate];
+    for (const word_type clusterID1 : evaluation.leftContextClusters) {
         if (clusterID1 != clusterCandidate && clusterID1 != clusterToMoveFrom) {
-            const auto newOcc = (double) (occurrencesClusters[clusterToMoveFrom][clusterID1]
-                                          - wordToCluster[wordID][clusterID1]) / corpus.getNumberOfTransitions();
-            const auto contribution = entropyTerm(newOcc);
-            amiDiff += contribution;
+            occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterID1][clusterCandidate]
+                                             + currentClusterToWord[clusterID1])
+                              - entropyOccurrences[clusterID1][clusterCandidate];
         }
     }
 
-    for (word_type clusterID1 = 0; clusterID1 < numClusters; ++clusterID1) {
-        if (clusterID1 != clusterCandidate && clusterID1 != clusterToMoveFrom) {
-            const auto newOcc = (double) (occurrencesClusters[clusterID1][clusterToMoveFrom]
-                                          - clusterToWord[clusterID1][wordID]) / corpus.getNumberOfTransitions();
-            const auto contribution = entropyTerm(newOcc);
-            amiDiff += contribution;
-        }
-    }
-
-    const double newOccCandSource = (double) (occurrencesClusters[clusterCandidate][clusterToMoveFrom] -
-                                              clusterToWord[clusterCandidate][wordID] +
-                                              wordToCluster[wordID][clusterToMoveFrom] -
-                                              Utils::getOccurrence(corpus.occurrences, wordID, wordID)) /
-                                    corpus.getNumberOfTransitions();
-    const double contributionCandSource = entropyTerm(newOccCandSource);
-    amiDiff += contributionCandSource;
-
-    const double newOccSourceCand = (double) (occurrencesClusters[clusterToMoveFrom][clusterCandidate] -
-                                              wordToCluster[wordID][clusterCandidate] +
-                                              clusterToWord[clusterToMoveFrom][wordID] -
-                                              Utils::getOccurrence(corpus.occurrences, wordID, wordID)) /
-                                    corpus.getNumberOfTransitions();
-    const double contributionSourceCand = entropyTerm(newOccSourceCand);
-    amiDiff += contributionSourceCand;
-
-    const double newOccCandCand = (double) (occurrencesClusters[clusterCandidate][clusterCandidate] +
-                                            clusterToWord[clusterCandidate][wordID] +
-                                            wordToCluster[wordID][clusterCandidate] +
-                                            Utils::getOccurrence(corpus.occurrences, wordID, wordID)) /
-                                  corpus.getNumberOfTransitions();
-    const double contributionCandCand = entropyTerm(newOccCandCand);
-    amiDiff += contributionCandCand;
-
-    const word_type lossSourceSource = clusterToWord[clusterToMoveFrom][wordID] +
-                                       wordToCluster[wordID][clusterToMoveFrom] -
-                                       Utils::getOccurrence(corpus.occurrences, wordID, wordID);
-    const double newOccSourceSource =
-            (double) (occurrencesClusters[clusterToMoveFrom][clusterToMoveFrom] - lossSourceSource) /
-            corpus.getNumberOfTransitions();
-    const double contributionSourceSource = entropyTerm(newOccSourceSource);
-    amiDiff += contributionSourceSource;
-
-    const double newPlCandidate = plC[clusterCandidate] + corpus.pl[wordID];
+//    the source cluster's row and column without the word, except for the candidate entries handled below
+    occurrenceDiff += evaluation.sourceRowTermsSum;
+    occurrenceDiff -= currentWordToCluster[clusterCandidate] == 0
+                      ? entropyOccurrences[clusterToMoveFrom][clusterCandidate]
+                      : occurrenceTerm(occurrencesClusters[clusterToMoveFrom][clusterCandidate]
+                                       - currentWordToCluster[clusterCandidate]);
+    occurrenceDiff += evaluation.sourceColumnTermsSum;
+    occurrenceDiff -= currentClusterToWord[clusterCandidate] == 0
+                      ? entropyOccurrences[clusterCandidate][clusterToMoveFrom]
+                      : occurrenceTerm(occurrencesClusters[clusterCandidate][clusterToMoveFrom]
+                                       - currentClusterToWord[clusterCandidate]);
+
+    const word_type newOccCandSource = occurrencesClusters[clusterCandidate][clusterToMoveFrom] -
+                                       currentClusterToWord[clusterCandidate] +
+                                       currentWordToCluster[clusterToMoveFrom] -
+                                       occurrencesToItself;
+    occurrenceDiff += occurrenceTerm(newOccCandSource);
+
+    const word_type newOccSourceCand = occurrencesClusters[clusterToMoveFrom][clusterCandidate] -
+                                       currentWordToCluster[clusterCandidate] +
+                                       currentClusterToWord[clusterToMoveFrom] -
+                                       occurrencesToItself;
+    occurrenceDiff += occurrenceTerm(newOccSourceCand);
+
+    const word_type newOccCandCand = occurrencesClusters[clusterCandidate][clusterCandidate] +
+                                     currentClusterToWord[clusterCandidate] +
+                                     currentWordToCluster[clusterCandidate] +
+                                     occurrencesToItself;
+    occurrenceDiff += occurrenceTerm(newOccCandCand);
+
+    const word_type lossSourceSource = currentClusterToWord[clusterToMoveFrom] +
+                                       currentWordToCluster[clusterToMoveFrom] -
+                                       occurrencesToItself;
+    occurrenceDiff += occurrenceTerm(occurrencesClusters[clusterToMoveFrom][clusterToMoveFrom] - lossSourceSource);
+
+    double amiDiff = occurrenceDiff * occurrenceNormalization;
+    amiDiff += entropyLeft[clusterToMoveFrom];
+    amiDiff += entropyRight[clusterToMoveFrom];
+    amiDiff += entropyLeft[clusterCandidate];
+    amiDiff += entropyRight[clusterCandidate];
+
+    const double newPlCandidate = plC[clusterCandidate] + scalars.pl;
     amiDiff -= entropyTerm(newPlCandidate);
 
-    const double newPrCandidate = prC[clusterCandidate] + corpus.pr[wordID];
+    const double newPrCandidate = prC[clusterCandidate] + scalars.pr;
     amiDiff -= entropyTerm(newPrCandidate);
 
-    const double newPlSource = plC[clusterToMoveFrom] - corpus.pl[wordID];
+    const double newPlSource = plC[clusterToMoveFrom] - scalars.pl;
     amiDiff -= entropyTerm(newPlSource);
 
-    const double newPrSource = prC[clusterToMoveFrom] - corpus.pr[wordID];
+    const double newPrSource = prC[clusterToMoveFrom] - scalars.pr;
     amiDiff -= entropyTerm(newPrSource);
 
     return amiDiff;
 }
 
+void Exchange::scoreAllCandidates(WordEvaluation &evaluation, vector<double> &amiChange) {
+//    one block of candidates per thread, but not so small that the per-block overhead dominates
+    const word_type numThreads = omp_get_num_threads();
+    const word_type blockSize = std::max<word_type>(64, (numClusters + numThreads - 1) / numThreads);
+    const word_type numBlocks = (numClusters + blockSize - 1) / blockSize;
+#pragma omp for
+    for (word_type block = 0; block < numBlocks; ++block) {
+        const word_type first = block * blockSize;
+        const word_type last = std::min<word_type>(numClusters, first + blockSize);
+        scoreBlock(evaluation, first, last, amiChange.data());
+    }
+}
+
+void Exchange::scoreBlock(WordEvaluation &evaluation, const word_type first, const word_type last, double *amiChange) {
+    if (vectorizedScoring && boundPruning) {
+        scoreCandidatesWithBounds(evaluation, first, last, amiChange);
+        return;
+    }
+    if (vectorizedScoring) {
+        scoreCandidates(evaluation, first, last, amiChange);
+        return;
+    }
+    for (word_type clusterCandidate = first; clusterCandidate < last; ++clusterCandidate) {
+        if (clusterCandidate == evaluation.source) {
+            amiChange[clusterCandidate] = 0;
+        } else {
+            amiChange[clusterCandidate] = calculateAMIDiff(evaluation, clusterCandidate);
+        }
+    }
+}
+
+CandidateScoring Exchange::prepareCandidateScoring(const WordEvaluation &evaluation) {
+    CandidateScoring scoring;
+    const word_type wordID = evaluation.wordID;
+    const word_type source = evaluation.source;
+    scoring.wordID = wordID;
+    scoring.source = source;
+    const WordScalars &scalars = evaluation.wordScalars[wordID];
+    scoring.occurrencesToItself = scalars.occurrencesToItself;
+    scoring.divisor = countDomain ? 1.0 : (double) corpus.getNumberOfTransitions();
+    scoring.diagonalCounts = diagonalCounts.data();
+    scoring.diagonalEntropies = diagonalEntropies.data();
+    scoring.sourceRow = occurrencesClusters[source];
+    scoring.sourceColumn = columnCounts(source);
+    scoring.sourceRowEntropies = entropyOccurrences[source];
+    scoring.sourceColumnEntropies = columnEntropies(source);
+    scoring.wordToCluster = evaluation.wordToCluster.data();
+    scoring.clusterToWord = evaluation.clusterToWord.data();
+    scoring.fromWordToSource = scoring.wordToCluster[source];
+    scoring.fromSourceToWord = scoring.clusterToWord[source];
+    const word_type lossSourceSource = scoring.fromSourceToWord + scoring.fromWordToSource
+                                       - scoring.occurrencesToItself;
+    scoring.sourceConstant = -sumRowsEntropyOccurrences[source] - sumColumnsEntropyOccurrences[source]
+                             + entropyOccurrences[source][source]
+                             + evaluation.sourceRowTermsSum + evaluation.sourceColumnTermsSum
+                             + occurrenceTerm(occurrencesClusters[source][source] - lossSourceSource);
+    scoring.sides = corpus.symmetric ? 2 : 1;
+    scoring.leftContextCount = corpus.symmetric ? 0 : evaluation.leftContextClusters.size();
+    scoring.pl = scalars.pl;
+    scoring.pr = scalars.pr;
+    scoring.marginalConstant = entropyLeft[source] + entropyRight[source]
+                               - entropyTerm(plC[source] - scoring.pl) - entropyTerm(prC[source] - scoring.pr);
+    scoring.plC = plC.data();
+    scoring.prC = prC.data();
+    scoring.entropyLeft = entropyLeft.data();
+    scoring.entropyRight = entropyRight.data();
+    scoring.normalization = occurrenceNormalization;
+    return scoring;
+}
+
+void Exchange::scoreCandidates(const WordEvaluation &evaluation, const word_type first, const word_type last,
+                               double *amiChange) {
+//    Same quantity as calculateAMIDiff, rearranged so that every pass runs over contiguous memory indexed by the
+//    candidate c. Written out for a candidate c (old terms of the candidate's row and column cancel against the
+//    cached sums):
+//      - sumRows[source] - sumColumns[source] + E[source][source] + sourceRowTermsSum + sourceColumnTermsSum
+//      + t(new [source][source]) - E[c][c] - E[source][c] - E[c][source]
+//      + t(new [c][source]) + t(new [source][c]) + t(new [c][c])
+//      + sum over right context clusters j of t(occ[c][j] + wordToCluster[j]) - E[c][j]
+//      + sum over left context clusters j of t(occ[j][c] + clusterToWord[j]) - E[j][c]
+//    where the context sums skip j = source and j = c. For candidates that are context clusters themselves the
+//    entries E[source][c] and E[c][source] are replaced by the terms without the word.
+    const CandidateScoring scoring = prepareCandidateScoring(evaluation);
+    const word_type source = scoring.source;
+    const double divisor = scoring.divisor;
+    const double sides = scoring.sides;
+
+#pragma omp simd
+    for (word_type c = first; c < last; ++c) {
+        amiChange[c] = ownEntriesChange(scoring, c);
+    }
+
+    for (size_t position = 0; position < evaluation.rightContextClusters.size(); ++position) {
+        const word_type j = evaluation.rightContextClusters[position];
+        if (j == source) {
+            continue;
+        }
+//        column j of occurrencesClusters, i.e. occ[c][j] for all candidates c
+        const word_type *counts = columnCounts(j);
+        const double *entropies = columnEntropies(j);
+        const word_type added = scoring.wordToCluster[j];
+#pragma omp simd
+        for (word_type c = first; c < last; ++c) {
+            amiChange[c] += sides * (vectorizableEntropyTerm((counts[c] + added) / divisor) - entropies[c]);
+        }
+        if (j >= first && j < last) {
+            amiChange[j] -= sides * (vectorizableEntropyTerm((counts[j] + added) / divisor) - entropies[j]);
+            amiChange[j] -= sides * (evaluation.rightSourceTerms[position] - scoring.sourceRowEntropies[j]);
+        }
+    }
+    for (size_t position = 0; position < scoring.leftContextCount; ++position) {
+        const word_type j = evaluation.leftContextClusters[position];
+        if (j == source) {
+            continue;
+        }
+//        row j of occurrencesClusters, i.e. occ[j][c] for all candidates c
+        const word_type *counts = occurrencesClusters[j];
+        const double *entropies = entropyOccurrences[j];
+        const word_type added = scoring.clusterToWord[j];
+#pragma omp simd
+        for (word_type c = first; c < last; ++c) {
+            amiChange[c] += vectorizableEntropyTerm((counts[c] + added) / divisor) - entropies[c];
+        }
+        if (j >= first && j < last) {
+            amiChange[j] -= vectorizableEntropyTerm((counts[j] + added) / divisor) - entropies[j];
+            amiChange[j] -= evaluation.leftSourceTerms[position] - scoring.sourceColumnEntropies[j];
+        }
+    }
+
+#pragma omp simd
+    for (word_type c = first; c < last; ++c) {
+        amiChange[c] = withMarginals(scoring, c, amiChange[c]);
+    }
+    if (source >= first && source < last) {
+        amiChange[source] = 0;
+    }
+}
+
+void Exchange::scoreCandidatesWithBounds(WordEvaluation &evaluation, const word_type first, const word_type last,
+                                         double *amiChange) {
+//    context clusters are rarely pruned, so if they make up most of the block the bounds do not pay off
+    word_type contextClustersInBlock = 0;
+    for (word_type c = first; c < last; ++c) {
+        contextClustersInBlock += evaluation.wordToCluster[c] != 0 || evaluation.clusterToWord[c] != 0;
+    }
+    if (2 * contextClustersInBlock > last - first) {
+        scoreCandidates(evaluation, first, last, amiChange);
+        return;
+    }
+    const CandidateScoring scoring = prepareCandidateScoring(evaluation);
+    const word_type source = scoring.source;
+    const double divisor = scoring.divisor;
+    const double contextMass = (double) evaluation.contextMass;
+    const double contextSquares = evaluation.contextSquares;
+    const double log2e = 1.4426950408889634;
+
+//    sum over the context clusters j of added_j * occ[c][j] (respectively added_j * occ[j][c]) for all candidates c,
+//    accumulated in amiChange; the products are integers, so the sums are exact. For a symmetric corpus both sums are
+//    the same and the right one is counted twice.
+    for (word_type c = first; c < last; ++c) {
+        amiChange[c] = 0;
+    }
+    for (const word_type j : evaluation.rightContextClusters) {
+        if (j == source) {
+            continue;
+        }
+        const word_type *counts = columnCounts(j);
+        const double added = scoring.sides * scoring.wordToCluster[j];
+#pragma omp simd
+        for (word_type c = first; c < last; ++c) {
+            amiChange[c] += added * counts[c];
+        }
+    }
+    for (size_t position = 0; position < scoring.leftContextCount; ++position) {
+        const word_type j = evaluation.leftContextClusters[position];
+        if (j == source) {
+            continue;
+        }
+        const word_type *counts = occurrencesClusters[j];
+        const double added = scoring.clusterToWord[j];
+#pragma omp simd
+        for (word_type c = first; c < last; ++c) {
+            amiChange[c] += added * counts[c];
+        }
+    }
+
+//    the bounds: the candidate's own entries are exact as in scoreCandidates, while the context part, the sum over
+//    j != c of t(x_j + a_j) - t(x_j), is at most sum a_j * t'(x_j + a_j), with t'(y) = (log2(y / D) + log2(e)) / D,
+//    which by Jensen's inequality is at most A * (log2(sum a_j * (x_j + a_j) / A / D) + log2(e)) / D
+#pragma omp simd
+    for (word_type c = first; c < last; ++c) {
+        const word_type diagonal = scoring.diagonalCounts[c];
+        const word_type fromCandidate = scoring.clusterToWord[c];
+        const word_type toCandidate = scoring.wordToCluster[c];
+        double occurrenceDiff = ownEntriesChange(scoring, c);
+//        the source cluster's entries of a context cluster are part of the terms above, not of the source's sums
+        occurrenceDiff -= toCandidate == 0 ? 0 : vectorizableEntropyTerm((scoring.sourceRow[c] - toCandidate) / divisor)
+                                                 - scoring.sourceRowEntropies[c];
+        occurrenceDiff -= fromCandidate == 0
+                          ? 0 : vectorizableEntropyTerm((scoring.sourceColumn[c] - fromCandidate) / divisor)
+                                - scoring.sourceColumnEntropies[c];
+        const double mass = contextMass - toCandidate - fromCandidate;
+        const double squares = contextSquares - (double) toCandidate * toCandidate
+                               - (double) fromCandidate * fromCandidate;
+        const double products = amiChange[c] - (double) (toCandidate + fromCandidate) * diagonal;
+//        without context clusters besides the candidate the mass and the sum are 0, and so is the bound
+        occurrenceDiff += mass * (vectorizableLog2((products + squares) / std::max(mass, 1.0) / divisor) + log2e)
+                          / divisor;
+        amiChange[c] = withMarginals(scoring, c, occurrenceDiff);
+    }
+
+//    the change to beat is that of staying or of the candidate with the largest bound, whichever is larger
+    word_type top = source;
+    for (word_type c = first; c < last; ++c) {
+        if (c != source && (top == source || amiChange[c] > amiChange[top])) {
+            top = c;
+        }
+    }
+    if (top == source) {
+        amiChange[source] = 0;
+        return;
+    }
+    scoreCandidateList(evaluation, &top, 1, amiChange);
+    const double best = std::max(0.0, amiChange[top]);
+//    the bound and the exact change differ by rounding only where the bound is tight
+    const double pruningMargin = 2 * CANDIDATE_TIE_TOLERANCE;
+    word_type *survivors = evaluation.survivors.data();
+    size_t numSurvivors = 0;
+    uint64_t pruned = 0;
+    for (word_type c = first; c < last; ++c) {
+        if (c == source || c == top) {
+            continue;
+        }
+        if (amiChange[c] < best - pruningMargin) {
+            amiChange[c] = -std::numeric_limits<double>::infinity();
+            ++pruned;
+        } else {
+            survivors[numSurvivors++] = c;
+        }
+    }
+    candidatesBounded.fetch_add(numSurvivors + pruned + 1, std::memory_order_relaxed);
+//    loading the candidates indirectly only pays off for a minority of the block
+    if (2 * numSurvivors > last - first) {
+        scoreCandidates(evaluation, first, last, amiChange);
+        return;
+    }
+    scoreCandidateList(evaluation, survivors, numSurvivors, amiChange);
+    if (source >= first && source < last) {
+        amiChange[source] = 0;
+    }
+    candidatesPruned.fetch_add(pruned, std::memory_order_relaxed);
+}
+
+void Exchange::scoreCandidateList(const WordEvaluation &evaluation, const word_type *candidates, const size_t count,
+                                  double *amiChange) {
+//    for a symmetric corpus the right context is counted twice instead of scoring the left one, see scoreCandidates
+    const CandidateScoring scoring = prepareCandidateScoring(evaluation);
+    const word_type source = scoring.source;
+    const double divisor = scoring.divisor;
+    const double sides = scoring.sides;
+
+#pragma omp simd
+    for (size_t i = 0; i < count; ++i) {
+        const word_type c = candidates[i];
+        amiChange[c] = ownEntriesChange(scoring, c);
+    }
+
+    for (const word_type j : evaluation.rightContextClusters) {
+        if (j == source) {
+            continue;
+        }
+        const word_type *counts = columnCounts(j);
+        const double *entropies = columnEntropies(j);
+        const word_type added = scoring.wordToCluster[j];
+#pragma omp simd
+        for (size_t i = 0; i < count; ++i) {
+            const word_type c = candidates[i];
+            amiChange[c] += sides * (vectorizableEntropyTerm((counts[c] + added) / divisor) - entropies[c]);
+        }
+    }
+    for (size_t position = 0; position < scoring.leftContextCount; ++position) {
+        const word_type j = evaluation.leftContextClusters[position];
+        if (j == source) {
+            continue;
+        }
+        const word_type *counts = occurrencesClusters[j];
+        const double *entropies = entropyOccurrences[j];
+        const word_type added = scoring.clusterToWord[j];
+#pragma omp simd
+        for (size_t i = 0; i < count; ++i) {
+            const word_type c = candidates[i];
+            amiChange[c] += vectorizableEntropyTerm((counts[c] + added) / divisor) - entropies[c];
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const word_type c = candidates[i];
+//        a candidate that is a context cluster itself was counted above as j = c, see scoreCandidates
+        const word_type diagonal = scoring.diagonalCounts[c];
+        const word_type toCandidate = scoring.wordToCluster[c];
+        const word_type fromCandidate = scoring.clusterToWord[c];
+        if (toCandidate != 0) {
+            amiChange[c] -= sides * (vectorizableEntropyTerm((diagonal + toCandidate) / divisor)
+                                     - scoring.diagonalEntropies[c]);
+            amiChange[c] -= sides * (occurrenceTerm(scoring.sourceRow[c] - toCandidate)
+                                     - scoring.sourceRowEntropies[c]);
+        }
+        if (!corpus.symmetric && fromCandidate != 0) {
+            amiChange[c] -= vectorizableEntropyTerm((diagonal + fromCandidate) / divisor)
+                            - scoring.diagonalEntropies[c];
+            amiChange[c] -= occurrenceTerm(scoring.sourceColumn[c] - fromCandidate) - scoring.sourceColumnEntropies[c];
+        }
+    }
+#pragma omp simd
+    for (size_t i = 0; i < count; ++i) {
+        const word_type c = candidates[i];
+        amiChange[c] = withMarginals(scoring, c, amiChange[c]);
+    }
+}
+
+word_type Exchange::selectCandidate(const vector<double> &amiChange, const word_type clusterToMoveFrom) {
+    const double best = *max_element(amiChange.begin(), amiChange.end());
+    if (amiChange[clusterToMoveFrom] >= best - CANDIDATE_TIE_TOLERANCE) {
+        return clusterToMoveFrom;
+    }
+    word_type clusterID = 0;
+    while (amiChange[clusterID] < best - CANDIDATE_TIE_TOLERANCE) {
+        ++clusterID;
+    }
+    return clusterID;
+}
+
+BlockBest Exchange::bestInBlock(const double *amiChange, const word_type first, const word_type last) {
+    BlockBest best = {-std::numeric_limits<double>::infinity(), first};
+    for (word_type clusterID = first; clusterID < last; ++clusterID) {
+        best.amiChange = std::max(best.amiChange, amiChange[clusterID]);
+    }
+    while (best.cluster < last && amiChange[best.cluster] < best.amiChange - CANDIDATE_TIE_TOLERANCE) {
+        ++best.cluster;
+    }
+    return best;
+}
+
+word_type Exchange::combineBlocks(const double *amiChange, const BlockBest *blockBests, const word_type numBlocks,
+                                  const word_type clusterToMoveFrom) {
+    double best = -std::numeric_limits<double>::infinity();
+    for (word_type block = 0; block < numBlocks; ++block) {
+        best = std::max(best, blockBests[block].amiChange);
+    }
+    if (amiChange[clusterToMoveFrom] >= best - CANDIDATE_TIE_TOLERANCE) {
+        return clusterToMoveFrom;
+    }
+//    the first block reaching the tolerance contains the answer; its reported cluster can only be too early, when the
+//    block's own maximum is below the overall one
+    word_type block = 0;
+    while (blockBests[block].amiChange < best - CANDIDATE_TIE_TOLERANCE) {
+        ++block;
+    }
+    word_type clusterID = blockBests[block].cluster;
+    while (amiChange[clusterID] < best - CANDIDATE_TIE_TOLERANCE) {
+        ++clusterID;
+    }
+    return clusterID;
+}
+
+void Exchange::prepareWordEvaluation(const word_type wordID, WordEvaluation &evaluation) {
+    const word_type source = wordsToClusters[wordID];
+    if (evaluation.wordToCluster.size() != numClusters) {
+        evaluation = WordEvaluation();
+        evaluation.wordToCluster = vector_word_type(numClusters, 0);
+        evaluation.clusterToWord = vector_word_type(numClusters, 0);
+        evaluation.survivors = vector_word_type(numClusters, 0);
+    }
+//    the copies are made anew with the data structures, then the thread looks its copy up again
+    if (std::none_of(wordScalars.begin(), wordScalars.end(), [&evaluation](const aligned_vector<WordScalars> &copy) {
+        return !copy.empty() && copy.data() == evaluation.wordScalars;
+    })) {
+        evaluation.wordScalars = localWordScalars();
+    }
+    evaluation.wordID = wordID;
+    evaluation.source = source;
+//    clear what is left from the previous word, then copy the counts of this word
+    for (const word_type clusterID : evaluation.rightContextClusters) {
+        evaluation.wordToCluster[clusterID] = 0;
+    }
+    for (const word_type clusterID : evaluation.leftContextClusters) {
+        evaluation.clusterToWord[clusterID] = 0;
+    }
+    evaluation.rightContextClusters.clear();
+    wordToCluster.forEachCluster(wordID, [&](const word_type clusterID, const word_type count) {
+        evaluation.rightContextClusters.push_back(clusterID);
+        evaluation.wordToCluster[clusterID] = count;
+    });
+    evaluation.leftContextClusters.clear();
+    if (corpus.symmetric) {
+        evaluation.leftContextClusters = evaluation.rightContextClusters;
+        for (const word_type clusterID : evaluation.leftContextClusters) {
+            evaluation.clusterToWord[clusterID] = evaluation.wordToCluster[clusterID];
+        }
+    } else {
+        clusterToWord.forEachCluster(wordID, [&](const word_type clusterID, const word_type count) {
+            evaluation.leftContextClusters.push_back(clusterID);
+            evaluation.clusterToWord[clusterID] = count;
+        });
+    }
+
+//    the source cluster's row and column only change in the context clusters of the word, so their sums follow from
+//    the cached ones
+    evaluation.rightSourceTerms.clear();
+    evaluation.sourceRowTermsSum = sumRowsEntropyOccurrences[source] - entropyOccurrences[source][source];
+    for (const word_type clusterID : evaluation.rightContextClusters) {
+        const double term = occurrenceTerm(occurrencesClusters[source][clusterID]
+                                           - evaluation.wordToCluster[clusterID]);
+        evaluation.rightSourceTerms.push_back(term);
+        if (clusterID != source) {
+            evaluation.sourceRowTermsSum += term - entropyOccurrences[source][clusterID];
+        }
+    }
+    evaluation.contextMass = 0;
+    evaluation.contextSquares = 0;
+    for (const word_type clusterID : evaluation.rightContextClusters) {
+        if (clusterID != source) {
+            const word_type count = evaluation.wordToCluster[clusterID];
+            evaluation.contextMass += count;
+            evaluation.contextSquares += (double) count * count;
+        }
+    }
+    for (const word_type clusterID : evaluation.leftContextClusters) {
+        if (clusterID != source) {
+            const word_type count = evaluation.clusterToWord[clusterID];
+            evaluation.contextMass += count;
+            evaluation.contextSquares += (double) count * count;
+        }
+    }
+    evaluation.leftSourceTerms.clear();
+    evaluation.sourceColumnTermsSum = sumColumnsEntropyOccurrences[source] - entropyOccurrences[source][source];
+    for (size_t position = 0; position < evaluation.leftContextClusters.size(); ++position) {
+        const word_type clusterID = evaluation.leftContextClusters[position];
+//        the column of the source cluster is its row for a symmetric corpus
+        const double term = corpus.symmetric ? evaluation.rightSourceTerms[position]
+                                             : occurrenceTerm(occurrencesClusters[clusterID][source]
+                                                              - evaluation.clusterToWord[clusterID]);
+        evaluation.leftSourceTerms.push_back(term);
+        if (clusterID != source) {
+            evaluation.sourceColumnTermsSum += term - entropyOccurrences[clusterID][source];
+        }
+    }
+}
+
 void Exchange::initializeDataStructures(const word_type numClusters, const vector<word_type> &clusterAssignments) {
     this->numClusters = numClusters;
-    occurrencesClusters = matrix_occurrences(numClusters, vector_word_type(numClusters, 0));
-    entropyOccurrences = matrix_double(numClusters, vector<double>(numClusters, 0));
+    this->completedIterations = 0;
+    this->resuming = false;
+    this->wordsEvaluated = 0;
+    this->candidatesBounded = 0;
+    this->candidatesPruned = 0;
+    this->fullSweep = true;
+    this->pendingFullSweep = false;
+    this->markedInIteration = vector_word_type(corpus.vocabularySize, 0);
+    this->speculativeMovesCommitted = 0;
+    this->speculativeWordsRescored = 0;
+    this->stopReason = NOT_STOPPED;
+    this->bestAssignments.clear();
+    this->bestAMI = -std::numeric_limits<double>::infinity();
+    applyScoringSettings();
+    placeWordScalars();
+    uint64_t totalOccurrences = 0;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(+:totalOccurrences)
+    for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+        for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+            totalOccurrences += right.count;
+        }
+    }
+    this->occurrenceTotal = (double) totalOccurrences;
+    NumaPlacement::fillByColumnBlocks(occurrencesClusters, numClusters, numClusters, 0u, parallelFirstTouch);
     wordsToClusters = vector_word_type(clusterAssignments.begin(), clusterAssignments.end());
     clusterContent = vector<set<word_type>>(numClusters, set<word_type>());
     this->plC = vector<double>(numClusters, 0);
     this->prC = vector<double>(numClusters, 0);
-    sumColumnsEntropyOccurrences = vector<double>(numClusters, 0);
-    sumRowsEntropyOccurrences = vector<double>(numClusters, 0);
-    this->entropyLeft = vector<double>(numClusters, 0);
-    this->entropyRight = vector<double>(numClusters, 0);
-    this->wordToCluster = vector<vector_word_type>(corpus.vocabularySize, vector_word_type(numClusters, 0));
-    this->clusterToWord = vector<vector_word_type>(numClusters, vector_word_type(corpus.vocabularySize, 0));
+    this->wordToCluster = WordClusterCounts(corpus.occurrences, wordsToClusters, numClusters,
+                                            wordClusterCountsRepresentation);
+    this->clusterToWord = corpus.symmetric ? WordClusterCounts()
+                                           : WordClusterCounts(corpus.occurrencesTransposed, wordsToClusters,
+                                                               numClusters, wordClusterCountsRepresentation);
+
+//    words grouped by cluster in increasing word order (a counting sort), so that every cluster can be filled by one
+//    thread while summing in the same order as a loop over all words
+    vector<uint64_t> clusterStart(numClusters + 1, 0);
     for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
-        const word_type destinationCluster = wordsToClusters[wordID];
-        clusterContent[destinationCluster].insert(wordID);
-        plC[destinationCluster] += corpus.pl[wordID];
-        prC[destinationCluster] += corpus.pr[wordID];
+        ++clusterStart[wordsToClusters[wordID] + 1];
+    }
+    for (word_type clusterID = 0; clusterID < numClusters; ++clusterID) {
+        clusterStart[clusterID + 1] += clusterStart[clusterID];
+    }
+    vector_word_type wordsByCluster(corpus.vocabularySize);
+    {
+        vector<uint64_t> position(clusterStart.begin(), clusterStart.end() - 1);
+        for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+            wordsByCluster[position[wordsToClusters[wordID]]++] = wordID;
+        }
     }
 
-    auto leftiesAndRighties = Corpus::computeLeftiesAndRighties(corpus);
-    this->toTheLeftOf = leftiesAndRighties.first;
-    this->toTheRightOf = leftiesAndRighties.second;
+#pragma omp parallel for schedule(dynamic, 16)
+    for (word_type clusterID = 0; clusterID < numClusters; ++clusterID) {
+        const word_type *first = wordsByCluster.data() + clusterStart[clusterID];
+        const word_type *last = wordsByCluster.data() + clusterStart[clusterID + 1];
+        clusterContent[clusterID] = set<word_type>(first, last);
+        for (const word_type *word = first; word != last; ++word) {
+            plC[clusterID] += corpus.pl[*word];
+            prC[clusterID] += corpus.pr[*word];
+        }
+    }
 
-    for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
-        const word_type destinationCluster = wordsToClusters[wordID];
-        for (word_type const &rightWord : toTheRightOf[wordID]) {
-            const word_type rightCluster = wordsToClusters[rightWord];
-            const word_type occurrence = Utils::getOccurrence(corpus.occurrences, wordID, rightWord);
-            occurrencesClusters[destinationCluster][rightCluster] += occurrence;
-            wordToCluster[wordID][rightCluster] += occurrence;
-            clusterToWord[destinationCluster][rightWord] += occurrence;
+//    Row c of occurrencesClusters only depends on the bigrams of the words in cluster c, so the rows are filled in
+//    parallel without synchronization. Clusters with more than their share of the bigrams (e.g. the large last cluster
+//    of the default initial clustering) are split into chunks that are counted into a private row first.
+    const uint64_t numBigrams = corpus.occurrences.getNumberOfEntries();
+    const uint64_t chunkBigrams = std::max<uint64_t>(1024, numBigrams / (8 * (uint64_t) omp_get_max_threads()));
+    struct Chunk {
+        word_type clusterID;
+        uint64_t first;
+        uint64_t last;
+        bool wholeCluster;
+    };
+    vector<Chunk> chunks;
+    chunks.reserve(numClusters);
+    for (word_type clusterID = 0; clusterID < numClusters; ++clusterID) {
+        const size_t firstChunk = chunks.size();
+        uint64_t chunkStart = clusterStart[clusterID];
+        uint64_t bigramsInChunk = 0;
+        for (uint64_t position = clusterStart[clusterID]; position < clusterStart[clusterID + 1]; ++position) {
+            bigramsInChunk += corpus.occurrences.row(wordsByCluster[position]).size();
+            if (bigramsInChunk >= chunkBigrams) {
+                chunks.push_back({clusterID, chunkStart, position + 1, false});
+                chunkStart = position + 1;
+                bigramsInChunk = 0;
+            }
+        }
+        if (chunkStart < clusterStart[clusterID + 1]) {
+            chunks.push_back({clusterID, chunkStart, clusterStart[clusterID + 1], false});
+        }
+        if (chunks.size() == firstChunk + 1) {
+            chunks.back().wholeCluster = true;
         }
     }
+#pragma omp parallel
+    {
+        vector_word_type partialRow;
+#pragma omp for schedule(dynamic, 1)
+        for (size_t chunkID = 0; chunkID < chunks.size(); ++chunkID) {
+            const Chunk &chunk = chunks[chunkID];
+            word_type *clusterRow = occurrencesClusters[chunk.clusterID];
+            if (!chunk.wholeCluster && partialRow.empty()) {
+                partialRow = vector_word_type(numClusters, 0);
+            }
+            word_type *row = chunk.wholeCluster ? clusterRow : partialRow.data();
+            for (uint64_t position = chunk.first; position < chunk.last; ++position) {
+                for (const BigramEntry &right : corpus.occurrences.row(wordsByCluster[position])) {
+                    row[wordsToClusters[right.neighbour]] += right.count;
+                }
+            }
+            if (!chunk.wholeCluster) {
+                for (word_type clusterID2 = 0; clusterID2 < numClusters; ++clusterID2) {
+                    if (partialRow[clusterID2] != 0) {
+#pragma omp atomic
+                        clusterRow[clusterID2] += partialRow[clusterID2];
+                        partialRow[clusterID2] = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    computeEntropies();
+    this->initialized = true;
+}
+
+void Exchange::applyScoringSettings() {
+    this->countDomain = useCountDomain;
+    this->vectorizedScoring = useVectorizedScoring;
+    this->occurrenceNormalization = countDomain ? 1.0 / corpus.getNumberOfTransitions() : 1.0;
+    this->nLogN = nLogNTable().data();
+}
 
-#pragma omp parallel for
+void Exchange::computeEntropies() {
+    entropyLeft = vector<double>(numClusters, 0);
+    entropyRight = vector<double>(numClusters, 0);
     for (word_type clusterID = 0; clusterID < numClusters; ++clusterID) {
         entropyLeft[clusterID] = entropyTerm(plC[clusterID]);
         entropyRight[clusterID] = entropyTerm(prC[clusterID]);
     }
-
+    NumaPlacement::fillByColumnBlocks(entropyOccurrences, numClusters, numClusters, 0.0, parallelFirstTouch);
+    sumColumnsEntropyOccurrences = vector<double>(numClusters, 0);
+    sumRowsEntropyOccurrences = vector<double>(numClusters, 0);
+//    rows and columns are summed in the same order as by a serial pass over the matrix, so the sums do not depend on
+//    the number of threads
+#pragma omp parallel for schedule(dynamic, 16)
     for (word_type clusterID1 = 0; clusterID1 < numClusters; ++clusterID1) {
+        double rowSum = 0;
         for (word_type clusterID2 = 0; clusterID2 < numClusters; ++clusterID2) {
-            double clusterProbability =
-                    (double) occurrencesClusters[clusterID1][clusterID2] / corpus.getNumberOfTransitions();
-            entropyOccurrences[clusterID1][clusterID2] = entropyTerm(clusterProbability);
-            sumRowsEntropyOccurrences[clusterID1] += entropyOccurrences[clusterID1][clusterID2];
-            sumColumnsEntropyOccurrences[clusterID2] += entropyOccurrences[clusterID1][clusterID2];
+            entropyOccurrences[clusterID1][clusterID2] = occurrenceTerm(occurrencesClusters[clusterID1][clusterID2]);
+            rowSum += entropyOccurrences[clusterID1][clusterID2];
+        }
+        sumRowsEntropyOccurrences[clusterID1] = rowSum;
+    }
+    const bool keepTransposed = vectorizedScoring && !corpus.symmetric;
+    if (keepTransposed) {
+        NumaPlacement::fillByColumnBlocks(occurrencesClustersTransposed, numClusters, numClusters, 0u,
+                                          parallelFirstTouch);
+        NumaPlacement::fillByColumnBlocks(entropyOccurrencesTransposed, numClusters, numClusters, 0.0,
+                                          parallelFirstTouch);
+    } else {
+        occurrencesClustersTransposed = FirstTouchMatrix<word_type>();
+        entropyOccurrencesTransposed = FirstTouchMatrix<double>();
+    }
+    diagonalCounts = vector<word_type>(vectorizedScoring ? numClusters : 0, 0);
+    diagonalEntropies = vector<double>(vectorizedScoring ? numClusters : 0, 0);
+    for (word_type clusterID = 0; clusterID < diagonalCounts.size(); ++clusterID) {
+        diagonalCounts[clusterID] = occurrencesClusters[clusterID][clusterID];
+        diagonalEntropies[clusterID] = entropyOccurrences[clusterID][clusterID];
+    }
+//    columns in blocks, so that every row is read contiguously
+    const word_type columnBlock = 64;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (word_type firstColumn = 0; firstColumn < numClusters; firstColumn += columnBlock) {
+        const word_type lastColumn = std::min<word_type>(numClusters, firstColumn + columnBlock);
+        double columnSums[columnBlock] = {};
+        for (word_type clusterID1 = 0; clusterID1 < numClusters; ++clusterID1) {
+            const double *entropyRow = entropyOccurrences[clusterID1];
+            for (word_type clusterID2 = firstColumn; clusterID2 < lastColumn; ++clusterID2) {
+                columnSums[clusterID2 - firstColumn] += entropyRow[clusterID2];
+            }
+            if (keepTransposed) {
+                const word_type *occurrencesRow = occurrencesClusters[clusterID1];
+                for (word_type clusterID2 = firstColumn; clusterID2 < lastColumn; ++clusterID2) {
+                    occurrencesClustersTransposed[clusterID2][clusterID1] = occurrencesRow[clusterID2];
+                    entropyOccurrencesTransposed[clusterID2][clusterID1] = entropyRow[clusterID2];
+                }
+            }
+        }
+        for (word_type clusterID2 = firstColumn; clusterID2 < lastColumn; ++clusterID2) {
+            sumColumnsEntropyOccurrences[clusterID2] = columnSums[clusterID2 - firstColumn];
         }
     }
-    this->initialized = true;
 }
 
-double inline Exchange::entropyTerm(const double argument) {
-    if (argument == 0 || argument == 1) {
-        return 0;
-    } else {
-        return argument * std::log2(argument);
+double Exchange::occurrenceTerm(const word_type count) {
+    if (!countDomain) {
+        return entropyTerm((double) count / corpus.getNumberOfTransitions());
+    }
+    if (count < N_LOG_N_TABLE_SIZE) {
+        return nLogN[count];
     }
+    return count * std::log2((double) count);
 }
 
 void Exchange::prepareClustering(const word_type numClusters, const vector<word_type> &clusterAssignments) {
@@ -355,13 +1366,209 @@ void Exchange::prepareClustering(const word_type numClusters) {
 
 bool Exchange::clusterOneIteration(const double minAMIChange) {
     this->clusterInternal(1, minAMIChange);
-    return changesInPreviousIteration > 0 && AMIIncreasingOverThreshold;
+    if (stopReason != NOT_STOPPED) {
+        return false;
+    }
+//    only a full sweep can tell that the clustering converged
+    return (changesInPreviousIteration > 0 && AMIIncreasingOverThreshold) || !fullSweep;
+}
+
+void Exchange::startSweep() {
+    fullSweep = !activeSetScheduling || completedIterations == 0 || pendingFullSweep
+                || (fullSweepInterval > 0 && completedIterations % fullSweepInterval == 0);
+    pendingFullSweep = false;
+}
+
+void Exchange::markNeighbours(const word_type wordID) {
+    if (!activeSetScheduling) {
+        return;
+    }
+    const word_type currentIteration = completedIterations + 1;
+    markedInIteration[wordID] = currentIteration;
+//    a neighbour is only marked if the moved word accounts for enough of its bigrams on that side
+    const double minimumCount = activeSetThreshold * corpus.getNumberOfTransitions();
+    for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+        if (right.count >= minimumCount * corpus.pr[right.neighbour]) {
+            markedInIteration[right.neighbour] = currentIteration;
+        }
+    }
+    for (const BigramEntry &left : corpus.getOccurrencesTransposed().row(wordID)) {
+        if (left.count >= minimumCount * corpus.pl[left.neighbour]) {
+            markedInIteration[left.neighbour] = currentIteration;
+        }
+    }
+}
+
+void Exchange::setCheckpointing(const string &fileName, const std::chrono::seconds interval) {
+    checkpointFileName = fileName;
+    checkpointInterval = interval;
+    lastCheckpoint = std::chrono::steady_clock::now();
+    wordsSinceClockCheck = 0;
+}
+
+bool Exchange::checkpointDue() {
+    if (checkpointFileName.empty()) {
+        return false;
+    }
+    if (checkpointRequested.exchange(false, std::memory_order_relaxed)) {
+        return true;
+    }
+    if (checkpointInterval == std::chrono::steady_clock::duration::zero()
+        || ++wordsSinceClockCheck < CHECKPOINT_CLOCK_CHECK_WORDS) {
+        return false;
+    }
+    wordsSinceClockCheck = 0;
+    return std::chrono::steady_clock::now() - lastCheckpoint >= checkpointInterval;
+}
+
+void Exchange::writeCheckpoint(const word_type nextWordID) {
+    ExchangeCheckpoint checkpoint;
+    checkpoint.algorithm = getName();
+    checkpoint.vocabularySize = corpus.vocabularySize;
+    checkpoint.numClusters = numClusters;
+    checkpoint.iteration = completedIterations;
+    checkpoint.nextWordID = nextWordID;
+    checkpoint.changesInIteration = changesInPreviousIteration;
+    checkpoint.iterationStartAMI = iterationStartAMI;
+    checkpoint.ami = calculateAMI();
+    checkpoint.randomState = getRandomState();
+    checkpoint.wordsToClusters = wordsToClusters;
+    checkpoint.fullSweep = fullSweep;
+    if (activeSetScheduling) {
+        checkpoint.markedInIteration = markedInIteration;
+    }
+    try {
+        checkpoint.writeToFile(checkpointFileName);
+    } catch (const runtime_error &e) {
+        failBetweenWords(e.what());
+    }
+    lastCheckpoint = std::chrono::steady_clock::now();
+    wordsSinceClockCheck = 0;
+}
+
+void Exchange::startClustering() {
+    stopping = false;
+    stopReason = NOT_STOPPED;
+    writeFailure.clear();
+    keepIfBest(calculateAMI());
+}
+
+bool Exchange::stopDue() {
+    if (cancellation != nullptr && cancellation->isCancelled()) {
+        stopReason = CANCELLED;
+        return true;
+    }
+//    one clock read per word is negligible next to scoring the word
+    if (deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline) {
+        stopReason = DEADLINE;
+        return true;
+    }
+    return false;
+}
+
+void Exchange::stopBetweenWords(const word_type nextWordID) {
+    stopping = true;
+    keepIfBest(calculateAMI());
+    if (!checkpointFileName.empty()) {
+        writeCheckpoint(nextWordID);
+    }
+}
+
+void Exchange::failBetweenWords(const string &message) {
+    stopping = true;
+    if (writeFailure.empty()) {
+        writeFailure = message;
+    }
+}
+
+void Exchange::keepIfBest(const double ami) {
+    if (isAnytime() && ami >= bestAMI) {
+        bestAMI = ami;
+        bestAssignments = wordsToClusters;
+    }
+}
+
+vector_word_type Exchange::clusteringResult() {
+    if (!isAnytime()) {
+        return wordsToClusters;
+    }
+    keepIfBest(calculateAMI());
+    return bestAssignments;
+}
+
+vector_word_type Exchange::getBestClusterAssignments() const {
+    if (bestAssignments.empty()) {
+        return bestAssignments;
+    }
+    return ExchangeAlgorithm::sortClusterAssignments(bestAssignments, numClusters);
+}
+
+void Exchange::resumeClustering(const ExchangeCheckpoint &checkpoint) {
+    if (checkpoint.algorithm != getName()) {
+        throw runtime_error("Checkpoint was written by " + checkpoint.algorithm + ", not by " + getName());
+    }
+    if (checkpoint.vocabularySize != corpus.vocabularySize
+        || checkpoint.wordsToClusters.size() != corpus.vocabularySize) {
+        throw runtime_error("Checkpoint was written for a vocabulary of " + to_string(checkpoint.vocabularySize) +
+                            " words, the corpus has " + to_string(corpus.vocabularySize));
+    }
+    for (const word_type clusterID : checkpoint.wordsToClusters) {
+        if (clusterID >= checkpoint.numClusters) {
+            throw runtime_error("Checkpoint assigns a word to cluster " + to_string(clusterID) + " of " +
+                                to_string(checkpoint.numClusters));
+        }
+    }
+    initializeDataStructures(checkpoint.numClusters, checkpoint.wordsToClusters);
+//    the same assignments on the same corpus give the same AMI, up to the rounding of the incremental updates
+    if (std::abs(calculateAMI() - checkpoint.ami) > 1e-6) {
+        throw runtime_error("AMI of the checkpoint does not match the corpus");
+    }
+    setRandomState(checkpoint.randomState);
+    if (checkpoint.markedInIteration.size() == corpus.vocabularySize) {
+        markedInIteration = checkpoint.markedInIteration;
+    }
+    completedIterations = checkpoint.iteration;
+    resuming = true;
+    resumeWordID = checkpoint.nextWordID;
+    resumeChanges = checkpoint.changesInIteration;
+    resumeIterationStartAMI = checkpoint.iterationStartAMI;
+    resumeFullSweep = checkpoint.fullSweep;
+}
+
+vector<word_type> Exchange::cluster(const ExchangeCheckpoint &checkpoint, const word_type noIterations,
+                                    const double minAMIChange) {
+    resumeClustering(checkpoint);
+    const word_type remainingIterations = noIterations > checkpoint.iteration ? noIterations - checkpoint.iteration
+                                                                              : 0;
+    return ExchangeAlgorithm::sortClusterAssignments(this->clusterInternal(remainingIterations, minAMIChange),
+                                                     numClusters);
 }
 
 vector_word_type Exchange::getClusterAssignments() const {
     return ExchangeAlgorithm::sortClusterAssignments(this->wordsToClusters, this->numClusters);
 }
 
+void Exchange::enableTelemetry(const string &fileName) {
+    if (fileName.empty()) {
+        telemetry.enable();
+    } else {
+        telemetry.enable(fileName);
+    }
+}
+
+void Exchange::startIterationTelemetry() {
+    telemetry.startIteration(omp_get_num_threads(), wordsEvaluated, getCandidatesPruned());
+}
+
+void Exchange::finishIterationTelemetry(const double ami, const double amiSeconds) {
+    try {
+        telemetry.finishIteration(completedIterations, wordsEvaluated, getCandidatesPruned(),
+                                  changesInPreviousIteration, ami, amiSeconds);
+    } catch (const runtime_error &e) {
+        failBetweenWords(e.what());
+    }
+}
+
 uint32_t Exchange::getChangesInPreviousIteration() const {
     return changesInPreviousIteration;
 }
@@ -4,48 +4,935 @@
 
 #include "../../models/Corpus.h"
 #include "../ExchangeAlgorithm.h"
+#include "../WordClusterCounts.h"
+#include "../ExchangeCheckpoint.h"
+#include "../ExchangeTelemetry.h"
+#include "../CancellationToken.h"
+#include "../../NumaPlacement.h"
 #include <set>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+
+/**
+ * Values of the corpus for one word that every thread reads for every word it scores, see Exchange::wordScalars.
+ */
+struct WordScalars {
+    double pl;
+    double pr;
+    word_type occurrencesToItself;
+};
+
+/**
+ * Everything about the word that is currently evaluated that does not depend on the candidate cluster, see
+ * Exchange::prepareWordEvaluation.
+ */
+struct WordEvaluation {
+    word_type wordID = 0;
+    /**
+     * Cluster of the word.
+     */
+    word_type source = 0;
+    /**
+     * Rows of wordToCluster and clusterToWord for the word, copied into arrays of size K so that any cluster can be
+     * looked up directly. Only the entries of the context clusters are nonzero.
+     */
+    vector_word_type wordToCluster;
+    vector_word_type clusterToWord;
+    /**
+     * Distinct clusters of the words following (right) and preceding (left) the word, i.e. the clusters c for which
+     * wordToCluster[c] respectively clusterToWord[c] are nonzero. Only these entries of a candidate's row and column
+     * change when the word moves there; all other entries are taken from the cached row and column sums.
+     */
+    vector_word_type rightContextClusters;
+    vector_word_type leftContextClusters;
+    /**
+     * For every right context cluster j, the occurrence term of [source][j] once the word has left the source
+     * cluster; for every left context cluster j the same for [j][source]. Parallel to the context cluster lists.
+     * Outside of the context clusters these entries do not change.
+     */
+    vector<double> rightSourceTerms;
+    vector<double> leftSourceTerms;
+    /**
+     * Sums of the occurrence terms of the source cluster's row and column once the word has left it, without the
+     * entry [source][source].
+     */
+    double sourceRowTermsSum = 0;
+    double sourceColumnTermsSum = 0;
+    /**
+     * Number of bigrams between the word and words outside the source cluster, in both directions, and the sum of the
+     * squares of the word's counts with its context clusters other than the source cluster. Used by the bounds of
+     * Exchange::scoreCandidatesWithBounds.
+     */
+    uint64_t contextMass = 0;
+    double contextSquares = 0;
+    /**
+     * Candidates of a block that Exchange::scoreCandidatesWithBounds could not prune, sized once to the number of
+     * clusters so that no word allocates.
+     */
+    vector_word_type survivors;
+    /**
+     * The copy of Exchange::wordScalars on the node of the thread that prepares the evaluation.
+     */
+    const WordScalars *wordScalars = nullptr;
+};
+
+/**
+ * What the vectorized scoring kernels look up once per word before running over the candidates: the rows and columns
+ * of the source cluster and of the word, and the parts of the AMI change that do not depend on the candidate. See
+ * Exchange::prepareCandidateScoring and Exchange::scoreCandidates for the terms.
+ */
+struct CandidateScoring {
+    word_type wordID;
+    word_type source;
+    word_type occurrencesToItself;
+    /**
+     * 1 in the count domain, the number of transitions otherwise.
+     */
+    double divisor;
+    const word_type *diagonalCounts;
+    const double *diagonalEntropies;
+    const word_type *sourceRow;
+    const word_type *sourceColumn;
+    const double *sourceRowEntropies;
+    const double *sourceColumnEntropies;
+    const word_type *wordToCluster;
+    const word_type *clusterToWord;
+    word_type fromWordToSource;
+    word_type fromSourceToWord;
+    double sourceConstant;
+    /**
+     * For a symmetric corpus the left context passes equal the right ones, which are counted twice instead.
+     */
+    double sides;
+    size_t leftContextCount;
+    double pl;
+    double pr;
+    double marginalConstant;
+    const double *plC;
+    const double *prC;
+    const double *entropyLeft;
+    const double *entropyRight;
+    double normalization;
+};
+
+/**
+ * Best candidate cluster among a block of candidates, see Exchange::bestInBlock. Aligned to a cache line so that the
+ * threads writing the bests of neighbouring blocks do not share one.
+ */
+struct alignas(64) BlockBest {
+    double amiChange;
+    word_type cluster;
+};
+
+/**
+ * Changes of the row and column sums of the two clusters involved in a move, accumulated while their entries are
+ * refreshed, see Exchange::refreshMovedEntries. Aligned to a cache line since every thread of a team fills its own.
+ */
+struct alignas(64) MoveDiffs {
+    double rowFrom = 0;
+    double rowTo = 0;
+    double columnFrom = 0;
+    double columnTo = 0;
+};
 
 /**
  * Multi-threaded implementation of ExchangeAlgorithm.
  */
 class Exchange : public ExchangeAlgorithm {
+public:
+    /**
+     * Why the last call to cluster, clusterOneIteration or clusterInternal stopped before it was done.
+     */
+    enum StopReason {
+        NOT_STOPPED,
+        /**
+         * The deadline set with setDeadline or setTimeBudget has passed.
+         */
+        DEADLINE,
+        /**
+         * The token set with setCancellationToken was cancelled.
+         */
+        CANCELLED
+    };
+
 protected:
     bool initialized = false;
     uint32_t changesInPreviousIteration = 0;
     bool AMIIncreasingOverThreshold = true;
     word_type iteration;
-    matrix_occurrences occurrencesClusters;
+    /**
+     * The matrices of K x K entries below are read and written by every thread in its block of columns (see
+     * NumaPlacement::columnBlock), and placed page by page on the node of that thread unless setParallelFirstTouch
+     * disables it.
+     */
+    FirstTouchMatrix<word_type> occurrencesClusters;
     vector<double> sumColumnsEntropyOccurrences;
     vector<double> sumRowsEntropyOccurrences;
     vector<double> entropyLeft;
     vector<double> entropyRight;
-    matrix_double entropyOccurrences;
+    /**
+     * entropyOccurrences[i][j] is occurrenceTerm(occurrencesClusters[i][j]).
+     */
+    FirstTouchMatrix<double> entropyOccurrences;
+    /**
+     * Column-major copies of occurrencesClusters and entropyOccurrences (entry [j][i] holds [i][j]), kept only
+     * for the vectorized candidate scoring, which needs the columns contiguous in memory, together with their
+     * diagonals. For a symmetric corpus (see Corpus::symmetric) both matrices are symmetric and their rows serve as
+     * columns, so only the diagonals are kept.
+     */
+    FirstTouchMatrix<word_type> occurrencesClustersTransposed;
+    FirstTouchMatrix<double> entropyOccurrencesTransposed;
+    vector<word_type> diagonalCounts;
+    vector<double> diagonalEntropies;
+    bool vectorizedScoring = true;
+    bool useVectorizedScoring = true;
+    bool parallelFirstTouch = true;
     vector<double> plC;
     vector<double> prC;
-    matrix_occurrences toTheLeftOf;
-    matrix_occurrences toTheRightOf;
     vector<set<word_type>> clusterContent;
-    vector<vector_word_type> clusterToWord;
-    vector<vector_word_type> wordToCluster;
+    /**
+     * Read-only copies of pl, pr and the bigram count of every word with itself, which every thread reads for every
+     * word it scores. There is one copy per NUMA node, indexed by node, made on that node unless
+     * setParallelFirstTouch disables it, so that no thread reads them from the other socket. The bigrams of a word
+     * are only read by the thread that applies its move and are not copied.
+     */
+    vector<aligned_vector<WordScalars>> wordScalars;
+
+    /**
+     * Makes the copies of wordScalars, see NumaPlacement::replicatePerNode.
+     */
+    void placeWordScalars();
+
+    /**
+     * The copy of wordScalars on the node of the calling thread, or another one if that node has none.
+     */
+    const WordScalars *localWordScalars() const;
+    /**
+     * wordToCluster.get(w, c) is the number of times a word of cluster c follows word w, clusterToWord.get(w, c) the
+     * number of times a word of cluster c precedes word w. The two are equal for a symmetric corpus, which only keeps
+     * wordToCluster.
+     */
+    WordClusterCounts wordToCluster;
+    WordClusterCounts clusterToWord;
+    WordClusterCounts::Representation wordClusterCountsRepresentation = WordClusterCounts::AUTOMATIC;
+
+    /**
+     * Fills evaluation with everything about a word that does not depend on the candidate cluster. Only reads the
+     * clustering, so every thread can prepare its own copy without synchronization. Takes time proportional to the
+     * number of context clusters of the word (plus K for dense word-cluster counts).
+     * @param wordID word that is about to be evaluated
+     * @param evaluation output, reused from word to word
+     */
+    void prepareWordEvaluation(word_type wordID, WordEvaluation &evaluation);
 
-    double calculateAMIDiff(word_type wordID, word_type clusterCandidate);
+    /**
+     * Returns the change in AMI caused by moving the word of a prepared evaluation to a candidate cluster.
+     */
+    double calculateAMIDiff(const WordEvaluation &evaluation, word_type clusterCandidate);
+
+    /**
+     * Fills amiChange[c] with the AMI change of moving a word to cluster c, for all clusters (0 for the word's own
+     * cluster). Must be called from all threads of a parallel region (or outside of one), each with an evaluation
+     * prepared for the same word.
+     */
+    void scoreAllCandidates(WordEvaluation &evaluation, vector<double> &amiChange);
+
+    /**
+     * Scores the candidates first, ..., last - 1 with scoreCandidates, or with calculateAMIDiff if vectorized
+     * scoring is disabled.
+     * @param amiChange output, indexed by cluster
+     */
+    void scoreBlock(WordEvaluation &evaluation, word_type first, word_type last, double *amiChange);
+
+    /**
+     * Vectorized equivalent of calculateAMIDiff for the candidates first, ..., last - 1. Instead of evaluating one
+     * candidate at a time, each pass runs over all candidates of the block through contiguous rows of
+     * occurrencesClusters / entropyOccurrences and their transposed copies, so that the compiler can use SIMD
+     * instructions (including for log2). Results agree with calculateAMIDiff up to rounding.
+     * @param amiChange output, indexed by cluster
+     */
+    void scoreCandidates(const WordEvaluation &evaluation, word_type first, word_type last, double *amiChange);
+
+    /**
+     * Whether scoreBlock prunes candidates with scoreCandidatesWithBounds, see setBoundPruning.
+     */
+    bool boundPruning = false;
+    std::atomic<uint64_t> candidatesBounded{0};
+    std::atomic<uint64_t> candidatesPruned{0};
+
+    /**
+     * Scores the candidates first, ..., last - 1 like scoreCandidates, but first computes an upper bound on the AMI
+     * change of every candidate and only evaluates the candidates whose bound can compete with the best change. The
+     * bound keeps the terms of the entries of the candidate's own row and column with itself and the source cluster
+     * and replaces the rest, the sum over the word's other context clusters j of t(occ[c][j] + a_j) - t(occ[c][j]),
+     * by A * t'(sum_j a_j * (occ[c][j] + a_j) / A) with A the sum of the word's counts a_j (rows and columns alike).
+     * This is larger since t is convex and t' concave, and costs an integer dot product per candidate instead of a
+     * logarithm per context cluster. The candidate with the largest bound is evaluated first; candidates whose bound
+     * is more than 2 * CANDIDATE_TIE_TOLERANCE below its change (or below 0, i.e. staying) are set to -infinity, others
+     * are evaluated by scoreCandidateList, so the selected cluster is the same as without pruning. Blocks of which
+     * more than half are context clusters of the word are scored by scoreCandidates without bounds.
+     * @param amiChange output, indexed by cluster
+     */
+    void scoreCandidatesWithBounds(WordEvaluation &evaluation, word_type first, word_type last, double *amiChange);
+
+    /**
+     * Computes the AMI changes of the given candidates, none of them the source cluster, with the same vectorized
+     * kernel as scoreCandidates, but loading the entries of the candidates indirectly.
+     * @param amiChange output, indexed by cluster; entries of other clusters are left unchanged
+     */
+    void scoreCandidateList(const WordEvaluation &evaluation, const word_type *candidates, size_t count,
+                            double *amiChange);
+
+    /**
+     * Looks up what scoreCandidates, scoreCandidatesWithBounds and scoreCandidateList share for a prepared evaluation.
+     */
+    CandidateScoring prepareCandidateScoring(const WordEvaluation &evaluation);
+
+    /**
+     * Returns the cluster a word should move to given the AMI changes of all candidates. Candidates whose change
+     * is within CANDIDATE_TIE_TOLERANCE of the best one are ties: the word then stays where it is if its own cluster
+     * is among them, and moves to the lowest cluster ID otherwise. Without this, exact ties (which are common, e.g.
+     * among clusters a word has no bigrams with) would be decided by rounding, so scalar and vectorized scoring
+     * would take different moves.
+     * @param amiChange AMI change for every cluster, 0 for the word's own cluster
+     * @param clusterToMoveFrom the word's current cluster
+     */
+    static word_type selectCandidate(const vector<double> &amiChange, word_type clusterToMoveFrom);
+
+    /**
+     * Returns the best candidate among the clusters first, ..., last - 1 in the form combineBlocks needs: the
+     * largest AMI change, and the lowest cluster whose change is within CANDIDATE_TIE_TOLERANCE of it. For an empty
+     * block the change is -infinity.
+     */
+    static BlockBest bestInBlock(const double *amiChange, word_type first, word_type last);
+
+    /**
+     * Picks the same cluster as selectCandidate, given the bests of consecutive blocks that together cover all
+     * clusters. Only looks at the entries of amiChange beyond the reported clusters if a tolerance tie spans blocks.
+     * @param amiChange AMI change for every cluster, 0 for the word's own cluster
+     * @param blockBests result of bestInBlock for every block, in the order of the blocks
+     * @param numBlocks number of blocks
+     * @param clusterToMoveFrom the word's current cluster
+     */
+    static word_type combineBlocks(const double *amiChange, const BlockBest *blockBests, word_type numBlocks,
+                                   word_type clusterToMoveFrom);
 
     void performMoveAndReturnAMIChange(word_type wordID, word_type clusterToMoveTo);
 
     /**
-     * Calculates entropy for the given input. Handles input = 0 internally.
-     * In other words, in calculates: input * log2(input).
-     * @param input
-     * @return
+     * First part of a move: updates the cluster of the word, the marginals, occurrencesClusters and the word-cluster
+     * counts. Afterwards the entropies of the rows and columns of both clusters are stale until refreshMovedEntries
+     * and applyMoveDiffs have been run.
+     */
+    void applyMoveCounts(word_type wordID, word_type clusterToMoveTo);
+
+    /**
+     * The part of applyMoveCounts that updates occurrencesClusters and the word-cluster counts, for a symmetric
+     * corpus: one pass over the neighbours of the word updates the row and the column of both clusters.
+     */
+    void applySymmetricMoveCounts(word_type wordID, word_type clusterToMoveFrom, word_type clusterToMoveTo);
+
+    /**
+     * Recomputes the entropy of the entries [from][j], [to][j], [j][from] and [j][to] for j = first, ..., last - 1 in
+     * a single pass, together with their transposed copies. The sums of the rows and columns j are updated directly,
+     * the changes of the sums of from and to are accumulated into diffs. Disjoint ranges can be refreshed by different
+     * threads at the same time.
+     */
+    void refreshMovedEntries(word_type clusterToMoveFrom, word_type clusterToMoveTo, word_type first, word_type last,
+                             MoveDiffs &diffs);
+
+    /**
+     * Adds the accumulated changes of refreshMovedEntries to the row and column sums of both clusters.
+     */
+    void applyMoveDiffs(word_type clusterToMoveFrom, word_type clusterToMoveTo, const MoveDiffs &diffs);
+
+    /**
+     * Recomputes entropyOccurrences[clusterID1][clusterID2] (and its transposed copy) and returns by how much it
+     * changed.
+     */
+    double refreshEntry(word_type clusterID1, word_type clusterID2);
+
+    /**
+     * For a symmetric corpus: copies the refreshed entry [clusterID2][clusterID1] of entropyOccurrences to
+     * [clusterID1][clusterID2] instead of computing the same term again, and returns by how much it changed.
+     */
+    double mirrorEntry(word_type clusterID1, word_type clusterID2);
+
+    /**
+     * Column j of occurrencesClusters respectively entropyOccurrences, contiguous in memory (see
+     * occurrencesClustersTransposed).
+     */
+    const word_type *columnCounts(const word_type j) const {
+        return corpus.symmetric ? occurrencesClusters[j] : occurrencesClustersTransposed[j];
+    }
+
+    const double *columnEntropies(const word_type j) const {
+        return corpus.symmetric ? entropyOccurrences[j] : entropyOccurrencesTransposed[j];
+    }
+
+    /**
+     * Number of words scored concurrently against the same clustering, see setSpeculativeBatchSize.
+     */
+    word_type speculativeBatchSize = 1;
+    uint64_t speculativeMovesCommitted = 0;
+    uint64_t speculativeWordsRescored = 0;
+
+    /**
+     * Scores all candidates for a word against the current clustering and returns the cluster it should move to (its
+     * own cluster if it should stay, or if it is the only word in it).
+     * @param evaluation scratch space of the calling thread
+     * @param amiChange scratch space of the calling thread, size K
+     */
+    word_type bestMove(word_type wordID, WordEvaluation &evaluation, vector<double> &amiChange);
+
+    /**
+     * Variant of clusterInternal for speculativeBatchSize > 1. The words of a batch are scored in parallel against
+     * the clustering at the start of the batch, one word per thread, then the moves are applied in word order by a
+     * single thread. A word whose source or target cluster was touched by an earlier move of the same batch is
+     * scored again, as is a word whose move no longer increases the AMI.
+     */
+    vector<word_type> clusterSpeculatively(word_type noIterations, double minAMIChange);
+
+    /**
+     * Processes the words of one iteration on one thread, from the given word on, and adds the time it spends to
+     * the clock. Every thread of the team runs its own sweep; the sweeps decide how the words are shared among the
+     * threads and which thread applies the moves. That thread calls finishWord after every word (or batch), and all
+     * threads return once stopping is set.
+     */
+    using WordSweep = std::function<void(word_type firstWordID, PhaseClock &clock)>;
+
+    /**
+     * Runs up to noIterations iterations, or continues the iteration of a resumed checkpoint: everything an
+     * iteration does besides processing the words, i.e. deciding convergence (see hasConverged, beginIteration and
+     * endIteration), counting the iterations, keeping the best assignments and recording telemetry. Starts a team
+     * of threads, each of which calls makeSweep once and runs the sweep it returns in every iteration, so the sweep
+     * can keep per-thread state from one iteration to the next.
+     * @return the assignments, see clusteringResult
+     */
+    vector<word_type> runIterations(word_type noIterations, double minAMIChange,
+                                    const std::function<WordSweep()> &makeSweep);
+
+    /**
+     * Whether the clustering converged in the previous iteration, so that runIterations does not start another one.
+     * Only a full sweep without moves or without enough AMI increase counts.
+     */
+    virtual bool hasConverged() const;
+
+    /**
+     * Called by one thread at the start of every iteration, before its changes are reset.
+     * @param resumedIteration whether the iteration continues the one of a resumed checkpoint
+     */
+    virtual void beginIteration(bool resumedIteration);
+
+    /**
+     * Called by one thread at the end of every iteration that was not stopped, before it is counted and while
+     * iterationStartAMI still holds the AMI at its start. Decides whether the clustering converged.
+     * @param ami AMI at the end of the iteration
+     */
+    virtual void endIteration(double ami, double minAMIChange);
+
+    /**
+     * Called by the thread that applies the moves after every word (or batch of words): stops the clustering or
+     * writes a checkpoint if either is due.
+     * @param nextWordID first word of the current iteration that has not been processed yet
+     */
+    void finishWord(word_type nextWordID);
+
+    /**
+     * Whether iterations only evaluate the words whose neighbourhood changed, see setActiveSetScheduling.
+     */
+    bool activeSetScheduling = false;
+    word_type fullSweepInterval = 0;
+    double activeSetThreshold = 0;
+    /**
+     * markedInIteration[w] is the number (counting from 1) of the last iteration in which word w or one of its left
+     * or right neighbours moved, 0 if none of them has moved yet.
+     */
+    vector_word_type markedInIteration;
+    /**
+     * Whether the current (or, between iterations, the last) iteration evaluates all words.
+     */
+    bool fullSweep = true;
+    /**
+     * Set when an iteration that only evaluated marked words made no move, so the next one has to evaluate all
+     * words before the clustering can be considered converged.
+     */
+    bool pendingFullSweep = false;
+    uint64_t wordsEvaluated = 0;
+    /**
+     * Number of words (the ones with the lowest IDs) that may change their cluster, 0 for all, see setMovableWords.
+     */
+    word_type movableWords = 0;
+
+    /**
+     * Decides whether the iteration that is about to start evaluates all words and sets fullSweep accordingly.
+     * Called by one thread, before changesInPreviousIteration is reset.
+     */
+    void startSweep();
+
+    /**
+     * Whether the word has to be evaluated in the current iteration: in a full sweep every word, otherwise only the
+     * words marked in the previous or the current iteration.
+     */
+    bool isActive(const word_type wordID) const {
+        return fullSweep || markedInIteration[wordID] >= completedIterations;
+    }
+
+    /**
+     * Marks a word that has just moved and its left and right neighbours (subject to activeSetThreshold) for
+     * evaluation in the current and the next iteration. Does nothing unless active-set scheduling is enabled.
+     */
+    void markNeighbours(word_type wordID);
+
+    /**
+     * Iterations completed since the data structures were initialized, including the ones before the checkpoint a
+     * run was resumed from.
+     */
+    word_type completedIterations = 0;
+    /**
+     * AMI at the start of the current iteration (between iterations, at the end of the last one), needed to decide
+     * convergence at its end and stored in checkpoints.
+     */
+    double iterationStartAMI = 0;
+    /**
+     * Position within the interrupted iteration at which the next call to clusterInternal starts, see
+     * resumeClustering: the first word that has not been processed yet, the moves made so far and the AMI at the
+     * start of the iteration. Only used if resuming is set.
      */
-    double inline entropyTerm(double input);
+    bool resuming = false;
+    word_type resumeWordID = 0;
+    uint32_t resumeChanges = 0;
+    double resumeIterationStartAMI = 0;
+    bool resumeFullSweep = true;
+
+    /**
+     * Where checkpoints are written, empty if checkpointing is disabled. See setCheckpointing.
+     */
+    string checkpointFileName;
+    std::chrono::steady_clock::duration checkpointInterval = std::chrono::steady_clock::duration::zero();
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    word_type wordsSinceClockCheck = 0;
+    static std::atomic<bool> checkpointRequested;
+
+    /**
+     * Time at which the clustering stops, time_point::max() for none, and the token that stops it once cancelled,
+     * nullptr for none. See setDeadline and setCancellationToken.
+     */
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const CancellationToken *cancellation = nullptr;
+    /**
+     * Set by the thread that applies the moves once the clustering has to stop; the other threads read it after
+     * the word (or batch) in which it was set and leave the iteration with it.
+     */
+    bool stopping = false;
+    StopReason stopReason = NOT_STOPPED;
+    /**
+     * Why a file written during the clustering could not be written, empty if none failed. Set together with
+     * stopping by failBetweenWords; runIterations throws it once the threads have left the iteration.
+     */
+    string writeFailure;
+    /**
+     * The assignments with the highest AMI seen at the end of an iteration or when stopping, kept while a deadline
+     * or a cancellation token is set. Empty before the first clustering.
+     */
+    vector_word_type bestAssignments;
+    double bestAMI = -std::numeric_limits<double>::infinity();
+
+    /**
+     * Whether a deadline or a cancellation token is set, so that the best assignments are kept.
+     */
+    bool isAnytime() const {
+        return deadline != std::chrono::steady_clock::time_point::max() || cancellation != nullptr;
+    }
+
+    /**
+     * Resets the stop state and keeps the assignments if they are the best so far. Called by clusterInternal before
+     * its first iteration.
+     */
+    void startClustering();
+
+    /**
+     * Whether the clustering has to stop now, because the token was cancelled or the deadline has passed. Sets
+     * stopReason. Only called by one thread at a time, between two words.
+     */
+    bool stopDue();
+
+    /**
+     * Stops the clustering between two words: sets stopping, keeps the assignments if they are the best so far and
+     * writes a checkpoint if checkpointing is enabled, so that the run can be resumed.
+     * @param nextWordID first word of the current iteration that has not been processed yet
+     */
+    void stopBetweenWords(word_type nextWordID);
+
+    /**
+     * Stops the clustering between two words because a file could not be written, see writeFailure. Only called by
+     * one thread at a time, between two words.
+     */
+    void failBetweenWords(const string &message);
+
+    /**
+     * Copies the assignments to bestAssignments if their AMI is at least bestAMI. Does nothing unless isAnytime.
+     * Called by one thread, with all moves so far applied.
+     */
+    void keepIfBest(double ami);
+
+    /**
+     * The result of clusterInternal: the best assignments seen if isAnytime, the current ones otherwise.
+     */
+    vector_word_type clusteringResult();
+
+    /**
+     * Records the iterations if enabled, see enableTelemetry.
+     */
+    TelemetryRecorder telemetry;
+
+    /**
+     * Called by one thread at the start of an iteration.
+     */
+    void startIterationTelemetry();
+
+    /**
+     * Called by one thread at the end of an iteration, after every thread stored its PhaseClock in telemetry. A
+     * record that cannot be written stops the clustering like a failed checkpoint, see failBetweenWords.
+     * @param amiSeconds time spent computing the AMI at the end of the iteration
+     */
+    void finishIterationTelemetry(double ami, double amiSeconds);
+
+    /**
+     * Whether a checkpoint should be written now, because one was requested or the interval has passed. Only
+     * called by one thread at a time, between two words.
+     */
+    bool checkpointDue();
+
+    /**
+     * Writes a checkpoint of the current clustering. Must be called between two words, with all moves so far
+     * applied. A checkpoint that cannot be written stops the clustering, which then throws a runtime_error, so
+     * that a run does not go on without the checkpoints it relies on.
+     * @param nextWordID first word of the current iteration that has not been processed yet
+     */
+    void writeCheckpoint(word_type nextWordID);
+
+    /**
+     * State of the random number generator to store in a checkpoint, empty for the deterministic Exchange.
+     */
+    virtual string getRandomState() const { return ""; }
+
+    /**
+     * Restores the random number generator from the state returned by getRandomState.
+     */
+    virtual void setRandomState(const string &/*randomState*/) {}
+
+    /**
+     * Whether the occurrence terms are kept in the count domain, see setCountDomain. Copied from useCountDomain when
+     * the data structures are initialized.
+     */
+    bool countDomain = false;
+    bool useCountDomain = false;
+    /**
+     * Factor that turns a sum of occurrence terms into AMI: 1 / number of transitions in the count domain, 1
+     * otherwise.
+     */
+    double occurrenceNormalization = 1;
+    /**
+     * Sum of all bigram counts of the corpus.
+     */
+    double occurrenceTotal = 0;
+    /**
+     * n * log2(n) for small n.
+     */
+    const double *nLogN = nullptr;
+
+    /**
+     * Returns the contribution of one entry of occurrencesClusters with the given count: count * log2(count) in the
+     * count domain, p * log2(p) with p = count / transitions otherwise.
+     */
+    double occurrenceTerm(word_type count);
+
+    /**
+     * Takes over the settings of setCountDomain and setVectorizedScoring for the scoring of the next clustering.
+     */
+    void applyScoringSettings();
+
+    /**
+     * Computes everything the scoring derives from occurrencesClusters, plC and prC: the entropies of the marginals,
+     * entropyOccurrences with its row and column sums and, for vectorized scoring, the transposed copies.
+     */
+    void computeEntropies();
 
 public:
+    /**
+     * AMI changes closer than this to each other are treated as equal when picking the new cluster of a word, see
+     * selectCandidate. Far below the change of any real move and far above the rounding error of the scoring.
+     */
+    constexpr static double CANDIDATE_TIE_TOLERANCE = 1e-12;
+
+    /**
+     * The threads of a team share the entropy refresh of a move only if each of them gets at least this many
+     * clusters; for fewer, synchronizing costs more than the refresh.
+     */
+    constexpr static word_type MIN_CLUSTERS_PER_THREAD_FOR_SHARED_MOVES = 256;
+
     uint32_t getChangesInPreviousIteration() const;
 
-    Exchange(const Corpus &corpus) : ExchangeAlgorithm(corpus) {
+    /**
+     * Switches the evaluation of the occurrence terms to the count domain. Since p * log2(p) with p = n / T equals
+     * (n * log2(n) - n * log2(T)) / T and moving a word never changes the total count of the entries involved, the
+     * occurrence part of an AMI change can be computed from n * log2(n) alone (looked up in a table for small n)
+     * and normalized once. The marginal terms (pl, pr) stay in the probability domain since they are not
+     * necessarily integer counts. Takes effect the next time the data structures are initialized.
+     */
+    void setCountDomain(const bool enabled) {
+        useCountDomain = enabled;
+    }
+
+    /**
+     * Switches between the vectorized candidate scoring (default) and evaluating candidates one at a time with the
+     * scalar calculateAMIDiff, which is kept as a reference. Takes effect the next time the data structures are
+     * initialized.
+     */
+    void setVectorizedScoring(const bool enabled) {
+        useVectorizedScoring = enabled;
+    }
+
+    /**
+     * With parallel first touch (the default) the K x K matrices are filled by the threads that score their columns
+     * and every node gets its own copy of wordScalars, so on a machine with several NUMA nodes every thread mostly
+     * reads memory of its own node, provided the threads are pinned (see NumaPlacement::pinThreads). Without, the
+     * calling thread fills them and they end up on its node.
+     * Does not change the result. Takes effect the next time the data structures are initialized.
+     */
+    void setParallelFirstTouch(const bool enabled) {
+        parallelFirstTouch = enabled;
+    }
+
+    /**
+     * Enables pruning of the candidate clusters by an upper bound on their AMI change, see
+     * scoreCandidatesWithBounds. The selected moves do not change, but the AMI changes of pruned candidates are
+     * not computed. Only applies to the vectorized scoring; the scalar reference evaluates every candidate. Takes
+     * effect immediately.
+     */
+    void setBoundPruning(const bool enabled) {
+        boundPruning = enabled;
+    }
+
+    /**
+     * Number of candidates whose bound was computed, respectively that were pruned by it, since the data structures
+     * were initialized. See setBoundPruning.
+     */
+    uint64_t getCandidatesBounded() const {
+        return candidatesBounded.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getCandidatesPruned() const {
+        return candidatesPruned.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the number of consecutive words that are scored concurrently. With 1 (the default) the words are processed
+     * one after the other and the threads share the candidates of a word. Larger batches keep more threads busy when
+     * K is small compared to the number of cores, at the price of re-scoring words whose decision was invalidated by
+     * an earlier move of the batch. The result can differ from the one-word-at-a-time result, since words are scored
+     * against a slightly older clustering. Takes effect with the next call to cluster.
+     */
+    void setSpeculativeBatchSize(const word_type batchSize) {
+        speculativeBatchSize = std::max<word_type>(1, batchSize);
+    }
+
+    /**
+     * Number of moves taken as scored in a batch, see setSpeculativeBatchSize. Counted since the data structures
+     * were initialized.
+     */
+    uint64_t getSpeculativeMovesCommitted() const {
+        return speculativeMovesCommitted;
+    }
+
+    /**
+     * Number of words that had to be scored again because an earlier move of their batch invalidated their score.
+     * Counted since the data structures were initialized.
+     */
+    uint64_t getSpeculativeWordsRescored() const {
+        return speculativeWordsRescored;
+    }
+
+    /**
+     * Enables active-set scheduling: after the first iteration, only the words that moved, or one of whose left or
+     * right neighbours moved, in the previous or the current iteration are evaluated. All other words keep their
+     * cluster without being scored. Since a move also changes the marginals of two clusters, which every word depends
+     * on, this can miss moves; an iteration that evaluates all words (a full sweep) is made whenever an iteration
+     * without full sweep made no move, so the clustering is only considered converged after a full sweep. Not used
+     * by StochasticExchange. Takes effect with the next iteration.
+     */
+    void setActiveSetScheduling(const bool enabled) {
+        activeSetScheduling = enabled;
+    }
+
+    /**
+     * With active-set scheduling, additionally makes every interval-th iteration a full sweep, which bounds how long
+     * missed moves stay missed. 0 (the default) only makes full sweeps when the active set runs out of moves.
+     */
+    void setFullSweepInterval(const word_type interval) {
+        fullSweepInterval = interval;
+    }
+
+    /**
+     * With active-set scheduling, only marks a neighbour of a moved word if their bigrams make up at least this
+     * fraction of the neighbour's bigrams on that side, i.e. if the move noticeably changes the neighbour's context.
+     * Frequent words neighbour almost every word, and they are the most expensive ones to evaluate; a small
+     * threshold such as 0.01 keeps them out of the active set unless a word that matters to them moved. 0 (the
+     * default) marks all neighbours.
+     */
+    void setActiveSetThreshold(const double fraction) {
+        activeSetThreshold = fraction;
+    }
+
+    /**
+     * Restricts the clustering to the words with IDs below numWords; all other words keep their cluster and only
+     * contribute their bigrams. On a corpus ordered by frequency (see ReaderFrequency) these are the numWords most
+     * frequent words. 0 (the default) lets all words move. Not used by StochasticExchange. Takes effect with the next
+     * iteration.
+     */
+    void setMovableWords(const word_type numWords) {
+        movableWords = numWords;
+    }
+
+    /**
+     * Number of words that may change their cluster, see setMovableWords.
+     */
+    word_type getNumberOfMovableWords() const {
+        return movableWords == 0 ? corpus.vocabularySize : std::min(movableWords, corpus.vocabularySize);
+    }
+
+    /**
+     * Number of words evaluated since the data structures were initialized. Without active-set scheduling this is
+     * the number of words that are not alone in their cluster, summed over the iterations.
+     */
+    uint64_t getWordsEvaluated() const {
+        return wordsEvaluated;
+    }
+
+    /**
+     * Records what every following iteration did and where its time went, see IterationTelemetry, and appends the
+     * records to fileName as JSON lines unless it is empty. Measuring costs a few clock reads per word and a
+     * barrier per iteration. If a record cannot be written, the clustering stops after that iteration and throws.
+     * @throws runtime_error if the file cannot be opened
+     */
+    void enableTelemetry(const string &fileName = "");
+
+    /**
+     * The iterations recorded since telemetry was enabled.
+     */
+    const vector<IterationTelemetry> &getTelemetry() const {
+        return telemetry.getRecords();
+    }
+
+    /**
+     * Checks at most this many words apart whether the checkpoint interval has passed.
+     */
+    constexpr static word_type CHECKPOINT_CLOCK_CHECK_WORDS = 256;
+
+    /**
+     * Enables checkpoints: between two words, the clustering and the position within the run are written to
+     * fileName whenever interval has passed since the last checkpoint, and whenever one is requested with
+     * requestCheckpoint. An interval of 0 only writes requested checkpoints.
+     */
+    void setCheckpointing(const string &fileName, std::chrono::seconds interval);
+
+    /**
+     * Asks the running clustering to write a checkpoint after the word it is processing. Only sets a lock-free
+     * flag, so it can be called from a signal handler. Has no effect unless checkpointing is enabled.
+     */
+    static void requestCheckpoint() {
+        checkpointRequested.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stops the clustering at the first word boundary after the given time. Once the deadline is set, cluster
+     * returns the assignments with the highest AMI seen so far rather than the last ones, which only differ if
+     * random moves lowered the AMI (see StochasticExchange). Applies to all later calls to cluster and
+     * clusterOneIteration, so a sequence of single iterations can share one deadline.
+     */
+    void setDeadline(std::chrono::steady_clock::time_point deadline) {
+        this->deadline = deadline;
+    }
+
+    /**
+     * Sets the deadline to the given time from now, see setDeadline.
+     */
+    void setTimeBudget(std::chrono::steady_clock::duration budget) {
+        setDeadline(std::chrono::steady_clock::now() + budget);
+    }
+
+    /**
+     * Removes the deadline.
+     */
+    void clearDeadline() {
+        setDeadline(std::chrono::steady_clock::time_point::max());
+    }
+
+    /**
+     * Stops the clustering at the first word boundary after the token was cancelled, and keeps the best
+     * assignments as with setDeadline. The token is only read; it has to outlive the clustering, and nullptr
+     * removes it.
+     */
+    void setCancellationToken(const CancellationToken *token) {
+        cancellation = token;
+    }
+
+    /**
+     * Why the last clustering stopped before it was done, NOT_STOPPED if it was not stopped. A stopped clustering
+     * leaves the current iteration unfinished; it is not counted in getCompletedIterations, and a checkpoint of its
+     * position is written if checkpointing is enabled.
+     */
+    StopReason getStopReason() const {
+        return stopReason;
+    }
+
+    /**
+     * The assignments with the highest AMI seen since the data structures were initialized, with IDs sorted as by
+     * getClusterAssignments, and their AMI. Only kept while a deadline or a cancellation token is set; empty
+     * otherwise.
+     */
+    vector_word_type getBestClusterAssignments() const;
+
+    double getBestAMI() const {
+        return bestAMI;
+    }
+
+    /**
+     * Initializes the data structures from the assignments of a checkpoint and continues the interrupted iteration
+     * with the next call to cluster, clusterOneIteration or clusterInternal.
+     * @throws runtime_error if the checkpoint was written by another algorithm, for another corpus, or if the AMI
+     * of its assignments does not match the one it recorded
+     */
+    void resumeClustering(const ExchangeCheckpoint &checkpoint);
+
+    /**
+     * Resumes from a checkpoint and runs until noIterations iterations have been completed in total, counting the
+     * ones completed before the checkpoint.
+     */
+    vector<word_type>
+    cluster(const ExchangeCheckpoint &checkpoint, word_type noIterations,
+            double minAMIChange = DEFAULT_MIN_AMI_CHANGE);
+
+    /**
+     * Iterations completed since the data structures were initialized, including the ones before a resumed
+     * checkpoint.
+     */
+    word_type getCompletedIterations() const {
+        return completedIterations;
+    }
+
+    /**
+     * Sets how the word-cluster counts are stored. Takes effect the next time the data structures are initialized.
+     * By default the representation is chosen from the vocabulary size, the number of clusters and the number of
+     * bigrams.
+     */
+    void setWordClusterCountsRepresentation(const WordClusterCounts::Representation representation) {
+        wordClusterCountsRepresentation = representation;
+    }
+
+    Exchange(corpus_handle corpus) : ExchangeAlgorithm(std::move(corpus)) {
         this->initialized = false;
     };
 
@@ -75,7 +962,8 @@ public:
      * Runs EXCHANGE for one iteration.
      * @param minAMIChange minimum AMI threshold.
      * @return whether this clustering should be considered converged (either no swaps occurred, or
-     * the minimum AMI change was below the provided threshold)
+     * the minimum AMI change was below the provided threshold). A stopped iteration (see getStopReason) returns
+     * false, so that loops over single iterations end.
      */
     bool clusterOneIteration(double minAMIChange = DEFAULT_MIN_AMI_CHANGE);
 
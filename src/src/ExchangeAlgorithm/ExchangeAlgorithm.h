@@ -7,6 +7,7 @@
 #define EXCHANGE_ALGORITHM_H
 
 
+#include <cmath>
 #include "../models/Corpus.h"
 
 class ExchangeAlgorithm {
@@ -18,9 +19,9 @@ public:
     constexpr static double DEFAULT_MIN_AMI_CHANGE = 0.0001;
 
     /**
-     * Constructs a new instance of an ExchangeAlgorithm with a given corpus.
+     * Constructs a new instance of an ExchangeAlgorithm with a given corpus. The corpus is shared, not copied.
      */
-    ExchangeAlgorithm(const Corpus &corpus) : corpus(corpus) {};
+    ExchangeAlgorithm(corpus_handle corpus) : corpusHandle(std::move(corpus)), corpus(*corpusHandle) {};
 
     /**
      * Destructs the ExchangeAlgorithm solver.
@@ -78,10 +79,14 @@ public:
     }
 
 protected:
+    /**
+     * Keeps the corpus alive for as long as the algorithm exists.
+     */
+    const corpus_handle corpusHandle;
     /**
      * The corpus over which the clustering is to be conducted
      */
-    const Corpus corpus;
+    const Corpus &corpus;
     /**
      * The number of clusters in the clustering
      */
@@ -91,6 +96,17 @@ protected:
      */
     vector_word_type wordsToClusters;
 
+    /**
+     * Calculates entropy for the given input. Handles input = 0 internally.
+     * In other words, it calculates: input * log2(input).
+     */
+    static double entropyTerm(const double input) {
+        if (input == 0 || input == 1) {
+            return 0;
+        }
+        return input * std::log2(input);
+    }
+
 
 
 
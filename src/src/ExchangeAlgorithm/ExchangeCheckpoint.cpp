@@ -0,0 +1,33 @@
+#include "ExchangeCheckpoint.h"
+#include <fstream>
+#include <cstdio>
+
+void ExchangeCheckpoint::writeToFile(const string &fileName) const {
+    const string temporaryFileName = fileName + ".tmp";
+    {
+        std::ofstream ofs(temporaryFileName, std::ios::binary);
+        if (!ofs.is_open()) {
+            throw runtime_error("Checkpoint " + temporaryFileName + " could not be opened for writing");
+        }
+        cereal::PortableBinaryOutputArchive oa(ofs);
+        oa(*this);
+        ofs.close();
+        if (ofs.fail()) {
+            throw runtime_error("Checkpoint " + temporaryFileName + " could not be written");
+        }
+    }
+    if (std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+        throw runtime_error("Checkpoint " + temporaryFileName + " could not be renamed to " + fileName);
+    }
+}
+
+ExchangeCheckpoint ExchangeCheckpoint::readFromFile(const string &fileName) {
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs.is_open()) {
+        throw runtime_error("Checkpoint " + fileName + " could not be opened");
+    }
+    ExchangeCheckpoint checkpoint;
+    cereal::PortableBinaryInputArchive ia(ifs);
+    ia(checkpoint);
+    return checkpoint;
+}
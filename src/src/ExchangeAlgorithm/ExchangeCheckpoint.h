@@ -0,0 +1,80 @@
+#ifndef BROWN_EXCHANGECHECKPOINT_H
+#define BROWN_EXCHANGECHECKPOINT_H
+
+#include "../Utils.h"
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/string.hpp>
+
+/**
+ * Everything needed to continue an interrupted Exchange run: the cluster assignments and the position within the
+ * run. All other data structures are derived from the assignments when the run is resumed.
+ */
+struct ExchangeCheckpoint {
+    /**
+     * Name of the algorithm that wrote the checkpoint, see ExchangeAlgorithm::getName.
+     */
+    string algorithm;
+    /**
+     * Vocabulary size of the corpus the run was started on, to detect resuming on a different corpus.
+     */
+    word_type vocabularySize = 0;
+    word_type numClusters = 0;
+    /**
+     * Number of completed iterations.
+     */
+    word_type iteration = 0;
+    /**
+     * First word of the current iteration that has not been processed yet.
+     */
+    word_type nextWordID = 0;
+    /**
+     * Number of moves made in the current iteration so far.
+     */
+    uint32_t changesInIteration = 0;
+    /**
+     * AMI at the start of the current iteration, needed to decide convergence at its end.
+     */
+    double iterationStartAMI = 0;
+    /**
+     * AMI when the checkpoint was written.
+     */
+    double ami = 0;
+    /**
+     * Textual state of the random number generator, empty for deterministic algorithms.
+     */
+    string randomState;
+    vector_word_type wordsToClusters;
+    /**
+     * State of active-set scheduling: whether the current iteration evaluates all words, and the iteration in which
+     * every word was last marked for evaluation (empty if active-set scheduling was disabled). Since version 1.
+     */
+    bool fullSweep = true;
+    vector_word_type markedInIteration;
+
+    template<class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+        ar(algorithm, vocabularySize, numClusters, iteration, nextWordID, changesInIteration, iterationStartAMI, ami,
+           randomState, wordsToClusters);
+        if (version >= 1) {
+            ar(fullSweep, markedInIteration);
+        }
+    }
+
+    /**
+     * Writes the checkpoint to a file. The file is written under a temporary name first and then renamed, so an
+     * interruption while writing never leaves a damaged checkpoint behind.
+     * @throws runtime_error if the file cannot be written
+     */
+    void writeToFile(const string &fileName) const;
+
+    /**
+     * Reads a checkpoint written by writeToFile.
+     * @throws runtime_error if the file cannot be read
+     */
+    static ExchangeCheckpoint readFromFile(const string &fileName);
+};
+
+CEREAL_CLASS_VERSION(ExchangeCheckpoint, 1);
+
+#endif //BROWN_EXCHANGECHECKPOINT_H
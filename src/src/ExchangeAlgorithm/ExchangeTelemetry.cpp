@@ -0,0 +1,77 @@
+#include "ExchangeTelemetry.h"
+#include <json/json.hpp>
+
+using json = nlohmann::json;
+
+string IterationTelemetry::toJson() const {
+    json json_object;
+    json_object["iteration"] = iteration;
+    json_object["threads"] = threads;
+    json_object["words_evaluated"] = wordsEvaluated;
+    json_object["candidates_scored"] = candidatesScored;
+    json_object["candidates_pruned"] = candidatesPruned;
+    json_object["moves"] = moves;
+    json_object["ami"] = ami;
+    json_object["seconds"] = seconds;
+    json_object["scoring_seconds"] = scoringSeconds;
+    json_object["move_seconds"] = moveSeconds;
+    json_object["waiting_seconds"] = waitingSeconds;
+    json_object["ami_seconds"] = amiSeconds;
+    return json_object.dump();
+}
+
+void TelemetryRecorder::enable() {
+    enabled = true;
+}
+
+void TelemetryRecorder::enable(const string &fileName) {
+    out = std::ofstream(fileName, std::ios::app);
+    if (!out.is_open()) {
+        throw runtime_error("Telemetry file " + fileName + " could not be opened for writing");
+    }
+    this->fileName = fileName;
+    enabled = true;
+}
+
+void TelemetryRecorder::startIteration(const word_type numThreads, const uint64_t wordsEvaluated,
+                                       const uint64_t candidatesPruned) {
+    clocks.assign(numThreads, PhaseClock(false));
+    wordsEvaluatedAtStart = wordsEvaluated;
+    candidatesPrunedAtStart = candidatesPruned;
+    iterationStart = std::chrono::steady_clock::now();
+}
+
+void TelemetryRecorder::store(const word_type threadID, const PhaseClock &clock) {
+    clocks[threadID] = clock;
+}
+
+void TelemetryRecorder::finishIteration(const word_type iteration, const uint64_t wordsEvaluated,
+                                        const uint64_t candidatesPruned, const uint32_t moves, const double ami,
+                                        const double amiSeconds) {
+    IterationTelemetry record;
+    record.iteration = iteration;
+    record.threads = clocks.size();
+    record.wordsEvaluated = wordsEvaluated - wordsEvaluatedAtStart;
+    record.candidatesPruned = candidatesPruned - candidatesPrunedAtStart;
+    record.moves = moves;
+    record.ami = ami;
+    record.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - iterationStart).count();
+    record.amiSeconds = amiSeconds;
+    uint64_t candidates = 0;
+    for (const PhaseClock &clock : clocks) {
+        record.scoringSeconds += clock.scoring;
+        record.moveSeconds += clock.moves;
+        record.waitingSeconds += clock.waiting;
+        candidates += clock.candidates;
+    }
+    record.candidatesScored = candidates - std::min(candidates, record.candidatesPruned);
+    records.push_back(record);
+    if (!fileName.empty()) {
+        out << record.toJson() << '\n';
+        out.flush();
+        if (out.fail()) {
+            out.clear();
+            throw runtime_error("Telemetry could not be written to " + fileName);
+        }
+    }
+}
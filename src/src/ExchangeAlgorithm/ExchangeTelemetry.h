@@ -0,0 +1,158 @@
+#ifndef BROWN_EXCHANGETELEMETRY_H
+#define BROWN_EXCHANGETELEMETRY_H
+
+#include "../Utils.h"
+#include <chrono>
+
+/**
+ * What one iteration of Exchange did and where its time went. The times of the phases are summed over the threads,
+ * so together they are about threads * seconds.
+ */
+struct IterationTelemetry {
+    /**
+     * Number of iterations completed with this one, counting the ones before a resumed checkpoint.
+     */
+    word_type iteration = 0;
+    word_type threads = 0;
+    uint64_t wordsEvaluated = 0;
+    /**
+     * Candidate clusters whose AMI change was computed, and candidates skipped thanks to their bound (see
+     * Exchange::setBoundPruning).
+     */
+    uint64_t candidatesScored = 0;
+    uint64_t candidatesPruned = 0;
+    uint32_t moves = 0;
+    /**
+     * AMI at the end of the iteration.
+     */
+    double ami = 0;
+    /**
+     * Wall-clock time of the iteration.
+     */
+    double seconds = 0;
+    /**
+     * Time spent preparing words and scoring candidates.
+     */
+    double scoringSeconds = 0;
+    /**
+     * Time spent applying moves, including the refresh of the entropies and writing checkpoints.
+     */
+    double moveSeconds = 0;
+    /**
+     * Time spent waiting for other threads, in barriers or for the move of a word.
+     */
+    double waitingSeconds = 0;
+    /**
+     * Wall-clock time of computing the AMI at the end of the iteration, done by one thread while the others wait.
+     */
+    double amiSeconds = 0;
+
+    /**
+     * The record as a JSON object on one line, without line break.
+     */
+    string toJson() const;
+};
+
+/**
+ * Time one thread spends in the phases of an iteration. Every lap adds the time since the previous lap to a phase.
+ * Does not read the clock unless enabled, so that it costs nothing when telemetry is off.
+ */
+class PhaseClock {
+private:
+    bool enabled = false;
+    std::chrono::steady_clock::time_point last;
+
+public:
+    double scoring = 0;
+    double moves = 0;
+    double waiting = 0;
+    /**
+     * Candidates handed to the scoring, pruned ones included.
+     */
+    uint64_t candidates = 0;
+
+    PhaseClock(const bool enabled) : enabled(enabled) {}
+
+    /**
+     * Starts the first lap of an iteration.
+     */
+    void start() {
+        if (enabled) {
+            last = std::chrono::steady_clock::now();
+        }
+    }
+
+    /**
+     * Adds the time since the previous lap to the given phase, one of the members of this clock.
+     */
+    void lap(double &phase) {
+        if (enabled) {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            phase += std::chrono::duration<double>(now - last).count();
+            last = now;
+        }
+    }
+};
+
+/**
+ * Collects the IterationTelemetry of a run and appends every record to a JSONL file as soon as the iteration is over,
+ * so that a run can be followed (or diagnosed after it was killed) without a profiler.
+ */
+class TelemetryRecorder {
+private:
+    bool enabled = false;
+    string fileName;
+    std::ofstream out;
+    vector<IterationTelemetry> records;
+    /**
+     * Phase times of every thread of the current iteration.
+     */
+    vector<PhaseClock> clocks;
+    std::chrono::steady_clock::time_point iterationStart;
+    uint64_t wordsEvaluatedAtStart = 0;
+    uint64_t candidatesPrunedAtStart = 0;
+
+public:
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    /**
+     * Records iterations from now on, in memory only.
+     */
+    void enable();
+
+    /**
+     * Records iterations from now on and appends them to the given file, one JSON object per line.
+     * @throws runtime_error if the file cannot be opened
+     */
+    void enable(const string &fileName);
+
+    /**
+     * Called by one thread at the start of an iteration.
+     */
+    void startIteration(word_type numThreads, uint64_t wordsEvaluated, uint64_t candidatesPruned);
+
+    /**
+     * Hands over the phase times of a thread at the end of an iteration. Threads must store their clocks before
+     * finishIteration is called.
+     */
+    void store(word_type threadID, const PhaseClock &clock);
+
+    /**
+     * Called by one thread at the end of an iteration, after all threads stored their clocks. Writes the record
+     * if a file was given.
+     * @throws runtime_error if the record cannot be written; it is kept in the records all the same
+     */
+    void finishIteration(word_type iteration, uint64_t wordsEvaluated, uint64_t candidatesPruned, uint32_t moves,
+                         double ami, double amiSeconds);
+
+    /**
+     * The records of all iterations since telemetry was enabled.
+     */
+    const vector<IterationTelemetry> &getRecords() const {
+        return records;
+    }
+};
+
+#endif //BROWN_EXCHANGETELEMETRY_H
@@ -0,0 +1,36 @@
+#include "MultilevelExchange.h"
+#include <chrono>
+
+vector<word_type> MultilevelExchange::cluster(const word_type noClusters, const word_type noIterations,
+                                              vector<word_type> clusterAssignments, const double minAMIChange) {
+    if (!(growthFactor > 1)) {
+        throw runtime_error("The growth factor of MultilevelExchange has to be larger than 1, not " +
+                            to_string(growthFactor));
+    }
+    stages.clear();
+    const word_type vocabularySize = corpus.vocabularySize;
+    double stageWords = std::max(initialWords, noClusters);
+    while (true) {
+        const word_type numWords = stageWords >= vocabularySize ? vocabularySize : (word_type) stageWords;
+        const word_type iterations = numWords == vocabularySize ? noIterations
+                                                                : std::min(stageIterations, noIterations);
+        setMovableWords(numWords);
+        const auto start = std::chrono::steady_clock::now();
+        clusterAssignments = Exchange::cluster(noClusters, iterations, clusterAssignments, minAMIChange);
+        const auto end = std::chrono::steady_clock::now();
+        MultilevelStage stage;
+        stage.movableWords = numWords;
+        stage.iterations = getCompletedIterations();
+        stage.wordsEvaluated = getWordsEvaluated();
+        stage.ami = calculateAMI();
+        stage.durationMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        stages.push_back(stage);
+//        a stopped stage ends the run, its clustering is as usable as the one of the last stage
+        if (numWords == vocabularySize || getStopReason() != NOT_STOPPED) {
+            break;
+        }
+        stageWords *= growthFactor;
+    }
+    setMovableWords(0);
+    return clusterAssignments;
+}
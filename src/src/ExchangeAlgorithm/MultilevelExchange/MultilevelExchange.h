@@ -0,0 +1,96 @@
+#ifndef MULTILEVELEXCHANGE_H
+#define MULTILEVELEXCHANGE_H
+
+
+#include "../../models/Corpus.h"
+#include "../Exchange/Exchange.h"
+
+/**
+ * Summary of one stage of MultilevelExchange.
+ */
+struct MultilevelStage {
+    /**
+     * Number of words that could change their cluster in this stage.
+     */
+    word_type movableWords = 0;
+    word_type iterations = 0;
+    uint64_t wordsEvaluated = 0;
+    /**
+     * AMI at the end of the stage.
+     */
+    double ami = 0;
+    uint64_t durationMilliseconds = 0;
+};
+
+/**
+ * Coarse-to-fine Exchange for corpora ordered by frequency (see ReaderFrequency). The first stage only lets the
+ * most frequent words move, all others stay in the cluster they were initially assigned to (with the default
+ * initial clustering all of them share the last cluster). Every following stage lets growthFactor times as many
+ * words move and starts from the clustering of the previous stage, until the last stage clusters the whole
+ * vocabulary like Exchange. Since the frequent words carry most of the bigrams, the early stages find most of the
+ * structure cheaply and the last stage starts close to convergence. The early stages do not have to converge for
+ * that, so they are limited to a few iterations.
+ */
+class MultilevelExchange : public Exchange {
+private:
+    word_type initialWords = DEFAULT_INITIAL_WORDS;
+    double growthFactor = DEFAULT_GROWTH_FACTOR;
+    word_type stageIterations = DEFAULT_STAGE_ITERATIONS;
+    vector<MultilevelStage> stages;
+
+public:
+    constexpr static word_type DEFAULT_INITIAL_WORDS = 2000;
+    constexpr static double DEFAULT_GROWTH_FACTOR = 4;
+    constexpr static word_type DEFAULT_STAGE_ITERATIONS = 2;
+
+    MultilevelExchange(corpus_handle corpus) : Exchange(std::move(corpus)) {};
+
+    ~MultilevelExchange() override = default;
+
+    string getName() override { return "MultilevelExchange"; };
+
+    /**
+     * Runs the stages starting from the given assignments. Every stage runs until it converges according to
+     * minAMIChange, the last one for at most noIterations iterations and all others for at most the stage
+     * iterations (or noIterations, if that is smaller). A stage stopped by the deadline or the cancellation token
+     * (see Exchange::setDeadline) ends the run with the clustering of that stage.
+     * @throws runtime_error if the growth factor is not larger than 1
+     */
+    vector<word_type>
+    cluster(word_type noClusters, word_type noIterations, vector<word_type> clusterAssignments,
+            double minAMIChange = DEFAULT_MIN_AMI_CHANGE) override;
+
+    using Exchange::cluster;
+
+    /**
+     * Sets the number of words that can move in the first stage. It is raised to the number of clusters if it is
+     * smaller.
+     */
+    void setInitialWords(const word_type numWords) {
+        initialWords = numWords;
+    }
+
+    /**
+     * Sets the factor by which the number of words that can move grows from one stage to the next.
+     */
+    void setGrowthFactor(const double factor) {
+        growthFactor = factor;
+    }
+
+    /**
+     * Sets the maximal number of iterations of every stage but the last one.
+     */
+    void setStageIterations(const word_type noIterations) {
+        stageIterations = noIterations;
+    }
+
+    /**
+     * The stages of the last call to cluster, the last one covering the whole vocabulary.
+     */
+    const vector<MultilevelStage> &getStages() const {
+        return stages;
+    }
+};
+
+
+#endif //MULTILEVELEXCHANGE_H
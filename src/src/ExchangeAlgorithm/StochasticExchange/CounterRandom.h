@@ -0,0 +1,42 @@
+#ifndef COUNTERRANDOM_H
+#define COUNTERRANDOM_H
+
+
+#include "../../Utils.h"
+
+/**
+ * Counter-based random numbers: the number at a position of a stream is a hash of the key, the stream and the
+ * position (SplitMix64 finalizer). There is no state to share or to advance, so every thread can draw the number of
+ * any position without synchronization, and a run is reproduced from the key alone, whatever the number of threads.
+ */
+class CounterRandom {
+private:
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31u);
+    }
+
+public:
+    static uint64_t bits(const uint64_t key, const uint64_t stream, const uint64_t position) {
+        return mix(mix(key ^ mix(stream + 0x9E3779B97F4A7C15ull)) + position * 0x9E3779B97F4A7C15ull);
+    }
+
+    /**
+     * Uniformly distributed in [0, 1).
+     */
+    static double uniform(const uint64_t key, const uint64_t stream, const uint64_t position) {
+        return (bits(key, stream, position) >> 11u) * 0x1.0p-53;
+    }
+
+    /**
+     * Uniformly distributed in [0, bound), up to a bias of at most bound / 2^32.
+     */
+    static word_type uniformBelow(const uint64_t key, const uint64_t stream, const uint64_t position,
+                                  const word_type bound) {
+        return (word_type) (((bits(key, stream, position) >> 32u) * bound) >> 32u);
+    }
+};
+
+
+#endif //COUNTERRANDOM_H
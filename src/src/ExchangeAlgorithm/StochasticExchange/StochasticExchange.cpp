@@ -1,81 +1,134 @@
 #include <fstream>
 #include "StochasticExchange.h"
 #include <random>
+#include <sstream>
+#include <omp.h>
 
-vector<word_type> StochasticExchange::clusterInternal(const word_type noIterations, const double minAMIChange) {
-    if (noIterations > 0) {
-//        set up the random device
-        std::random_device rd;
-        std::mt19937 e2(rd());
-        std::uniform_real_distribution<> dist(0, 1);
-        std::uniform_int_distribution<> cluster_dist(0, numClusters - 1);
+vector<word_type> StochasticExchange::cluster(const word_type noClusters, const word_type noIterations,
+                                              const vector<word_type> clusterAssignments,
+                                              const double minAMIChange) {
+    initializeDataStructures(noClusters, clusterAssignments);
+    return ExchangeAlgorithm::sortClusterAssignments(this->clusterInternal(noIterations, minAMIChange), numClusters);
+}
 
-        changesInPreviousIteration = 1;
-        vector<double> amiChange;
-        int destinationCluster;
-#pragma omp parallel
-        for (iteration = 0; iteration < noIterations; ++iteration) {
-            if (changesInPreviousIteration == 0 && !AMIIncreasingOverThreshold) {
-                break;
-            }
-#pragma omp barrier
-#pragma omp single
-            {
-                changesInPreviousIteration = 0;
-            }
-            for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+vector<word_type> StochasticExchange::cluster(const ExchangeCheckpoint &checkpoint, const word_type noIterations,
+                                              const double minAMIChange) {
+    resumeClustering(checkpoint);
+    const word_type remainingIterations = noIterations > checkpoint.iteration ? noIterations - checkpoint.iteration
+                                                                              : 0;
+    return ExchangeAlgorithm::sortClusterAssignments(this->clusterInternal(remainingIterations, minAMIChange),
+                                                     numClusters);
+}
+
+vector<word_type> StochasticExchange::clusterInternal(const word_type noIterations, const double minAMIChange) {
+    if (noIterations > 0 && (completedIterations == 0 || resuming)) {
+        bestIterationAMI = resuming ? resumeIterationStartAMI : calculateAMI();
+        iterationsWithoutImprovement = 0;
+        AMIIncreasingOverThreshold = true;
+    }
+    vector<double> amiChange(numClusters, 0);
+    return runIterations(noIterations, minAMIChange, [&]() -> WordSweep {
+        return [&, evaluation = WordEvaluation()](const word_type firstWordID, PhaseClock &clock) mutable {
+            for (word_type wordID = firstWordID; wordID < corpus.vocabularySize; ++wordID) {
                 const word_type clusterToMoveFrom = wordsToClusters[wordID];
-                if (clusterContent[clusterToMoveFrom].size() > 1) {
+                if (clusterContent[clusterToMoveFrom].size() <= 1) {
+                    continue;
+                }
+//                every thread draws the same number, so all of them take the same branch
+                if (draw(wordID, RANDOM_SWAP) * 100 < randomnessLevel) {
+//                    the threads may still be reading the clusters and the stop flag of the previous word
 #pragma omp barrier
-#pragma omp single
+#pragma omp single nowait
                     {
-                        destinationCluster = -1;
-                        amiChange = vector<double>(numClusters, 0);
-                        double coinFlip = dist(e2) * 100;
-                        if (coinFlip < randomnessLevel) {
-//                            random swap
-                            destinationCluster = cluster_dist(e2);
-                        }
+                        performMoveAndReturnAMIChange(wordID, drawCluster(wordID, RANDOM_SWAP_CLUSTER));
+                        changesInPreviousIteration++;
+                        finishWord(wordID + 1);
+                        clock.lap(clock.moves);
                     }
-                    if (destinationCluster == -1) {
-#pragma omp for
-                        for (word_type clusterCandidate = 0; clusterCandidate < numClusters; ++clusterCandidate) {
-                            if (clusterCandidate == clusterToMoveFrom) {
-                                amiChange[clusterCandidate] = 0;
-                            } else {
-                                const double amiDiff = calculateAMIDiff(wordID, clusterCandidate);
-                                amiChange[clusterCandidate] = amiDiff;
-                            }
-                        }
-#pragma omp single
-                        {
-                            const auto clusterToMoveTo = (word_type) distance(amiChange.begin(),
-                                                                                   max_element(amiChange.begin(),
-                                                                                               amiChange.end()));
-                            if (clusterToMoveTo != wordsToClusters[wordID]) {
-                                performMoveAndReturnAMIChange(wordID, clusterToMoveTo);
-                                changesInPreviousIteration++;
-                            }
-                        }
-                    } else {
-#pragma omp single
-                        {
-                            performMoveAndReturnAMIChange(wordID, destinationCluster);
+                } else {
+                    prepareWordEvaluation(wordID, evaluation);
+                    scoreAllCandidates(evaluation, amiChange);
+                    clock.lap(clock.scoring);
+#pragma omp single nowait
+                    {
+                        const word_type clusterToMoveTo = temperature > 0
+                                                          ? anneal(evaluation, amiChange, temperature)
+                                                          : selectCandidate(amiChange, clusterToMoveFrom);
+                        ++wordsEvaluated;
+                        clock.candidates += numClusters;
+                        if (clusterToMoveTo != clusterToMoveFrom) {
+                            performMoveAndReturnAMIChange(wordID, clusterToMoveTo);
                             changesInPreviousIteration++;
                         }
+                        finishWord(wordID + 1);
+                        clock.lap(clock.moves);
                     }
                 }
+#pragma omp barrier
+                clock.lap(clock.waiting);
+                if (stopping) {
+                    break;
+                }
             }
-#pragma omp single
-            {
-                AMIIncreasingOverThreshold = true;
-            }
-        }
+        };
+    });
+}
+
+bool StochasticExchange::hasConverged() const {
+    return !AMIIncreasingOverThreshold;
+}
+
+void StochasticExchange::beginIteration(const bool /*resumedIteration*/) {
+    temperature = getTemperature();
+}
+
+void StochasticExchange::endIteration(const double ami, const double minAMIChange) {
+    if (ami - bestIterationAMI > minAMIChange) {
+        bestIterationAMI = ami;
+        iterationsWithoutImprovement = 0;
+    } else {
+        bestIterationAMI = std::max(bestIterationAMI, ami);
+        ++iterationsWithoutImprovement;
+    }
+    AMIIncreasingOverThreshold = changesInPreviousIteration > 0 && iterationsWithoutImprovement < patience;
+}
+
+word_type StochasticExchange::anneal(const WordEvaluation &evaluation, const vector<double> &amiChange,
+                                     const double temperature) {
+    const word_type best = selectCandidate(amiChange, evaluation.source);
+    const word_type proposal = drawCluster(evaluation.wordID, PROPOSAL_CLUSTER);
+    if (proposal == best) {
+        return best;
+    }
+//    pruned candidates have no AMI change in amiChange
+    const double proposalChange = proposal == evaluation.source ? 0 : calculateAMIDiff(evaluation, proposal);
+    const double loss = amiChange[best] - proposalChange;
+    return draw(evaluation.wordID, METROPOLIS) < std::exp(-loss / temperature) ? proposal : best;
+}
+
+double StochasticExchange::getTemperature() const {
+    if (coolingSchedule == LINEAR) {
+        return std::max(0.0, initialTemperature * (1 - coolingRate * completedIterations));
     }
-    return wordsToClusters;
+    return initialTemperature * std::pow(coolingRate, completedIterations);
 }
 
 bool StochasticExchange::clusterOneIteration(const double minAMIChange) {
     this->clusterInternal(1, minAMIChange);
-    return AMIIncreasingOverThreshold;
-}
\ No newline at end of file
+    return AMIIncreasingOverThreshold && stopReason == NOT_STOPPED;
+}
+
+string StochasticExchange::getRandomState() const {
+    return to_string(seed);
+}
+
+void StochasticExchange::setRandomState(const string &randomState) {
+    if (randomState.empty()) {
+        return;
+    }
+    std::istringstream state(randomState);
+    state >> seed;
+    if (state.fail() || !state.eof()) {
+        throw runtime_error("Invalid random state in checkpoint");
+    }
+}
@@ -4,37 +4,172 @@
 
 #include "../../models/Corpus.h"
 #include "../Exchange/Exchange.h"
+#include "CounterRandom.h"
 #include <set>
 #include <algorithm>
+#include <random>
 
 /**
  * ExchangeAlgorithm implementation that allows for some randomness.
+ *
+ * Two kinds of randomness can be combined. With a randomness level, a percentage of the words is moved to a random
+ * cluster instead of being evaluated. With simulated annealing, every word is evaluated and, besides its best move,
+ * a random cluster is proposed; the proposal is taken instead of the best move with the Metropolis probability
+ * exp(-(best AMI change - proposal's AMI change) / temperature), and the temperature drops from iteration to
+ * iteration according to the cooling schedule. At temperature 0 and randomness 0 the moves are those of Exchange.
+ *
+ * All random numbers are drawn with CounterRandom from the seed, the number of the iteration and the word, so a run
+ * only depends on the seed and the settings, not on the number of threads.
  */
 class StochasticExchange : public Exchange {
+public:
+    enum CoolingSchedule {
+        /**
+         * The temperature is multiplied by the cooling rate after every iteration.
+         */
+        GEOMETRIC,
+        /**
+         * The temperature drops by the cooling rate times the initial temperature after every iteration, down to 0.
+         */
+        LINEAR
+    };
+
 private:
     double randomnessLevel = 0.0;
+    uint64_t seed = ((uint64_t) std::random_device{}() << 32u) | std::random_device{}();
+    double initialTemperature = 0;
+    CoolingSchedule coolingSchedule = GEOMETRIC;
+    double coolingRate = DEFAULT_COOLING_RATE;
+    word_type patience = DEFAULT_PATIENCE;
+    /**
+     * Highest AMI at the end of an iteration since the data structures were initialized, and the number of
+     * iterations since it last grew by more than the minimum AMI change.
+     */
+    double bestIterationAMI = 0;
+    word_type iterationsWithoutImprovement = 0;
+    /**
+     * Temperature of the current iteration, see getTemperature.
+     */
+    double temperature = 0;
+
+    /**
+     * Positions of the random numbers of a word within the stream of an iteration.
+     */
+    enum Draw {
+        RANDOM_SWAP, RANDOM_SWAP_CLUSTER, PROPOSAL_CLUSTER, METROPOLIS, DRAWS_PER_WORD
+    };
+
+    double draw(const word_type wordID, const Draw position) const {
+        return CounterRandom::uniform(seed, completedIterations, (uint64_t) wordID * DRAWS_PER_WORD + position);
+    }
+
+    word_type drawCluster(const word_type wordID, const Draw position) const {
+        return CounterRandom::uniformBelow(seed, completedIterations, (uint64_t) wordID * DRAWS_PER_WORD + position,
+                                           numClusters);
+    }
+
+    /**
+     * The cluster a word moves to under simulated annealing, given the AMI changes of all candidates.
+     */
+    word_type anneal(const WordEvaluation &evaluation, const vector<double> &amiChange, double temperature);
 
 public:
+    constexpr static double DEFAULT_COOLING_RATE = 0.5;
+    constexpr static word_type DEFAULT_PATIENCE = 3;
+
     /**
      * Sets how often a swap should be made at random.
      * @param randomnessLevel percentage of swaps to be made at random.
      */
     void setRandomness(double percentage) { randomnessLevel = percentage; };
 
-    StochasticExchange(const Corpus &corpus) : Exchange(corpus) { this->initialized = false; };
+    /**
+     * Seeds the random numbers, which are seeded from std::random_device otherwise. Two runs with the same seed,
+     * settings and initial clustering produce the same clustering, whatever the number of threads.
+     */
+    void setSeed(const uint64_t seed) {
+        this->seed = seed;
+    }
+
+    uint64_t getSeed() const {
+        return seed;
+    }
+
+    /**
+     * Enables simulated annealing, see the class description.
+     * @param temperature temperature of the first iteration, in bits of AMI; 0 disables annealing. Useful values are
+     * of the order of the AMI change of a typical move, which shrinks with the size of the corpus.
+     * @param schedule how the temperature drops from one iteration to the next
+     * @param rate factor (GEOMETRIC) or fraction of the initial temperature (LINEAR) applied per iteration
+     */
+    void setAnnealing(const double temperature, const CoolingSchedule schedule, const double rate) {
+        initialTemperature = temperature;
+        coolingSchedule = schedule;
+        coolingRate = rate;
+    }
+
+    /**
+     * Sets after how many iterations without an improvement of the best AMI by more than the minimum AMI change
+     * the clustering is considered converged. Unlike for Exchange, an iteration that lowers the AMI does not end
+     * the run, since random moves can do so on the way to a better clustering.
+     */
+    void setPatience(const word_type noIterations) {
+        patience = noIterations;
+    }
+
+    /**
+     * Temperature of the next iteration.
+     */
+    double getTemperature() const;
+
+    StochasticExchange(corpus_handle corpus) : Exchange(std::move(corpus)) { this->initialized = false; };
 
     ~StochasticExchange() override = default;
 
     string getName() override { return "StochasticExchange"; };
+
+    vector<word_type>
+    cluster(word_type noClusters, word_type noIterations, vector<word_type> clusterAssignments,
+            double minAMIChange = DEFAULT_MIN_AMI_CHANGE) override;
+
+    vector<word_type>
+    cluster(const ExchangeCheckpoint &checkpoint, word_type noIterations,
+            double minAMIChange = DEFAULT_MIN_AMI_CHANGE);
+
+    using Exchange::cluster;
+
     /**
      * Runs EXCHANGE for one iteration.
      * @param minAMIChange minimum AMI threshold.
-     * @return whether this clustering should be considered converged (either no swaps occurred, or
-     * the minimum AMI change was below the provided threshold)
+     * @return false once this clustering should be considered converged: an iteration made no move, or the best
+     * AMI has not grown by more than minAMIChange for the last patience iterations, or the iteration was stopped
+     * (see getStopReason)
      */
     bool clusterOneIteration(double minAMIChange = DEFAULT_MIN_AMI_CHANGE);
 protected:
+    /**
+     * The seed; the position within the streams follows from the position within the run.
+     */
+    string getRandomState() const override;
+
+    void setRandomState(const string &randomState) override;
+
     vector<word_type> clusterInternal(word_type noIterations, double minAMIChange);
+
+    /**
+     * Converged once an iteration made no move or the best AMI stopped growing, see clusterOneIteration.
+     */
+    bool hasConverged() const override;
+
+    /**
+     * Sets the temperature of the iteration.
+     */
+    void beginIteration(bool resumedIteration) override;
+
+    /**
+     * Tracks the best AMI at the end of an iteration and the number of iterations without improvement.
+     */
+    void endIteration(double ami, double minAMIChange) override;
 };
 
 
@@ -0,0 +1,116 @@
+#include "StochasticExchangeEnsemble.h"
+#include <omp.h>
+
+vector<word_type> StochasticExchangeEnsemble::cluster(const word_type numClusters, const word_type noIterations,
+                                                      const double minAMIChange) {
+//    the same initial clustering as Exchange
+    vector<word_type> clusterAssignments = vector_word_type(corpus.vocabularySize, numClusters - 1);
+    for (word_type i = 0; i < numClusters - 1; ++i) {
+        clusterAssignments[i] = i;
+    }
+    return cluster(numClusters, noIterations, clusterAssignments, minAMIChange);
+}
+
+vector<word_type> StochasticExchangeEnsemble::cluster(const word_type numClusters, const word_type noIterations,
+                                                      const vector<word_type> clusterAssignments,
+                                                      const double minAMIChange) {
+    if (numChains == 0) {
+        throw runtime_error("StochasticExchangeEnsemble needs at least one chain");
+    }
+    this->numClusters = numClusters;
+    chains = vector<EnsembleChain>(numChains);
+    vector<std::unique_ptr<StochasticExchange>> exchanges(numChains);
+    vector<vector_word_type> bestClusterings(numChains);
+    vector<char> converged(numChains, false);
+    for (word_type chainID = 0; chainID < numChains; ++chainID) {
+        chains[chainID].seed = seed + chainID;
+        exchanges[chainID].reset(new StochasticExchange(corpusHandle));
+        StochasticExchange &exchange = *exchanges[chainID];
+        exchange.setRandomness(randomnessLevel);
+        exchange.setSeed(chains[chainID].seed);
+        exchange.setAnnealing(initialTemperature, coolingSchedule, coolingRate);
+        exchange.setPatience(patience);
+        exchange.setCountDomain(countDomain);
+        exchange.setVectorizedScoring(vectorizedScoring);
+        exchange.setBoundPruning(boundPruning);
+    }
+
+    const int maxActiveLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(std::max(maxActiveLevels, 2));
+    for (word_type iteration = 0; iteration <= noIterations; ++iteration) {
+        runIteration(exchanges, iteration, clusterAssignments, minAMIChange, converged);
+        double leaderAMI = -std::numeric_limits<double>::infinity();
+        for (word_type chainID = 0; chainID < numChains; ++chainID) {
+            EnsembleChain &chain = chains[chainID];
+            if (exchanges[chainID]) {
+                StochasticExchange &exchange = *exchanges[chainID];
+                const double ami = exchange.calculateAMI();
+                chain.iterations = iteration;
+                chain.amiProgression.push_back(ami);
+                chain.wordsEvaluated = exchange.getWordsEvaluated();
+                if (bestClusterings[chainID].empty() || ami > chain.bestAMI) {
+                    chain.bestAMI = ami;
+                    bestClusterings[chainID] = exchange.getClusterAssignments();
+                }
+                if (converged[chainID]) {
+                    exchanges[chainID].reset();
+                }
+            }
+            if (!chain.abandoned) {
+                leaderAMI = std::max(leaderAMI, chain.bestAMI);
+            }
+        }
+        if (iteration >= graceIterations) {
+            for (word_type chainID = 0; chainID < numChains; ++chainID) {
+                EnsembleChain &chain = chains[chainID];
+                if (!chain.abandoned && chain.bestAMI < leaderAMI - abandonMargin) {
+                    chain.abandoned = true;
+                    exchanges[chainID].reset();
+                    bestClusterings[chainID] = vector_word_type();
+                }
+            }
+        }
+    }
+    omp_set_max_active_levels(maxActiveLevels);
+
+    bestChain = 0;
+    for (word_type chainID = 1; chainID < numChains; ++chainID) {
+        if (!chains[chainID].abandoned && chains[chainID].bestAMI > chains[bestChain].bestAMI) {
+            bestChain = chainID;
+        }
+    }
+    bestAMI = chains[bestChain].bestAMI;
+    wordsToClusters = std::move(bestClusterings[bestChain]);
+    return wordsToClusters;
+}
+
+void StochasticExchangeEnsemble::runIteration(vector<std::unique_ptr<StochasticExchange>> &exchanges,
+                                              const word_type iteration,
+                                              const vector<word_type> &clusterAssignments,
+                                              const double minAMIChange, vector<char> &converged) {
+    vector<word_type> running;
+    for (word_type chainID = 0; chainID < exchanges.size(); ++chainID) {
+        if (exchanges[chainID]) {
+            running.push_back(chainID);
+        }
+    }
+    if (iteration == 0) {
+//        the initialization is parallel by itself, so the chains are prepared one after the other with all threads
+        for (const word_type chainID : running) {
+            exchanges[chainID]->prepareClustering(numClusters, clusterAssignments);
+        }
+        return;
+    }
+    if (running.empty()) {
+        return;
+    }
+    const int numThreads = omp_get_max_threads();
+    const int numTeams = std::min<int>(running.size(), numThreads);
+//    with more chains than threads, every team runs several chains one after the other
+#pragma omp parallel for num_threads(numTeams) schedule(static, 1)
+    for (size_t i = 0; i < running.size(); ++i) {
+        const int team = omp_get_thread_num();
+        omp_set_num_threads(numThreads / numTeams + (team < numThreads % numTeams ? 1 : 0));
+        converged[running[i]] = !exchanges[running[i]]->clusterOneIteration(minAMIChange);
+    }
+}
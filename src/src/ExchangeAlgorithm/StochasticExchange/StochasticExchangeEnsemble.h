@@ -0,0 +1,181 @@
+#ifndef STOCHASTICEXCHANGEENSEMBLE_H
+#define STOCHASTICEXCHANGEENSEMBLE_H
+
+
+#include "../../models/Corpus.h"
+#include "../ExchangeAlgorithm.h"
+#include "StochasticExchange.h"
+#include <memory>
+#include <random>
+
+/**
+ * Summary of one chain of StochasticExchangeEnsemble.
+ */
+struct EnsembleChain {
+    uint64_t seed = 0;
+    /**
+     * Number of iterations the chain ran before it ended, was abandoned or the ensemble stopped.
+     */
+    word_type iterations = 0;
+    /**
+     * AMI of the initial clustering and after every iteration.
+     */
+    vector<double> amiProgression;
+    /**
+     * Highest AMI the chain reached. Since random swaps can lower the AMI, this is not necessarily the last one.
+     */
+    double bestAMI = 0;
+    bool abandoned = false;
+    uint64_t wordsEvaluated = 0;
+};
+
+/**
+ * Runs several StochasticExchange chains from the same initial clustering in one process and returns the best
+ * clustering any of them reached. The chains share the corpus, but each has its own cluster matrices (so memory
+ * grows with the number of chains) and its own random number generator, seeded with seed + chain number. They only
+ * differ through their random swaps, so with randomness 0 all of them produce the clustering of Exchange.
+ *
+ * The chains advance in lock step, one iteration at a time, each on its own share of the threads. After the grace
+ * iterations, a chain whose best AMI trails the best AMI of all chains by more than the abandon margin is abandoned,
+ * and its threads go to the remaining chains from the next iteration on. A chain also ends once it has converged, see
+ * StochasticExchange::clusterOneIteration. With a given seed the result does not depend on the number of threads.
+ */
+class StochasticExchangeEnsemble : public ExchangeAlgorithm {
+private:
+    word_type numChains = DEFAULT_CHAINS;
+    double randomnessLevel = 0.0;
+    double initialTemperature = 0;
+    StochasticExchange::CoolingSchedule coolingSchedule = StochasticExchange::GEOMETRIC;
+    double coolingRate = StochasticExchange::DEFAULT_COOLING_RATE;
+    word_type patience = StochasticExchange::DEFAULT_PATIENCE;
+    uint64_t seed = std::random_device{}();
+    double abandonMargin = DEFAULT_ABANDON_MARGIN;
+    word_type graceIterations = DEFAULT_GRACE_ITERATIONS;
+    bool countDomain = false;
+    bool vectorizedScoring = true;
+    bool boundPruning = false;
+    vector<EnsembleChain> chains;
+    word_type bestChain = 0;
+    double bestAMI = 0;
+
+    /**
+     * Runs prepareClustering (iteration 0) or one iteration of every running chain, with the threads divided among
+     * them.
+     * @param converged output, set for the chains that converged in this iteration
+     */
+    void runIteration(vector<std::unique_ptr<StochasticExchange>> &exchanges, word_type iteration,
+                      const vector<word_type> &clusterAssignments, double minAMIChange, vector<char> &converged);
+
+public:
+    constexpr static word_type DEFAULT_CHAINS = 4;
+    constexpr static double DEFAULT_ABANDON_MARGIN = 0.01;
+    constexpr static word_type DEFAULT_GRACE_ITERATIONS = 2;
+
+    StochasticExchangeEnsemble(corpus_handle corpus) : ExchangeAlgorithm(std::move(corpus)) {};
+
+    ~StochasticExchangeEnsemble() override = default;
+
+    string getName() override { return "StochasticExchangeEnsemble"; };
+
+    /**
+     * Runs every chain for at most noIterations iterations, starting from the default clustering of Exchange.
+     * @param minAMIChange convergence threshold of every chain, see StochasticExchange::clusterOneIteration
+     * @throws runtime_error if there are no chains
+     */
+    vector<word_type>
+    cluster(word_type noClusters, word_type noIterations, double minAMIChange = DEFAULT_MIN_AMI_CHANGE) override;
+
+    /**
+     * Same as the other cluster, starting from the given assignments.
+     */
+    vector<word_type>
+    cluster(word_type noClusters, word_type noIterations, vector<word_type> clusterAssignments,
+            double minAMIChange = DEFAULT_MIN_AMI_CHANGE) override;
+
+    /**
+     * AMI of the returned clustering, the best AMI of all chains.
+     */
+    double calculateAMI() override {
+        return bestAMI;
+    }
+
+    void setChains(const word_type numChains) {
+        this->numChains = numChains;
+    }
+
+    /**
+     * Sets the percentage of swaps every chain makes at random, see StochasticExchange::setRandomness.
+     */
+    void setRandomness(const double percentage) {
+        randomnessLevel = percentage;
+    }
+
+    /**
+     * Enables simulated annealing in every chain, see StochasticExchange::setAnnealing.
+     */
+    void setAnnealing(const double temperature, const StochasticExchange::CoolingSchedule schedule,
+                      const double rate) {
+        initialTemperature = temperature;
+        coolingSchedule = schedule;
+        coolingRate = rate;
+    }
+
+    /**
+     * Sets the convergence patience of every chain, see StochasticExchange::setPatience.
+     */
+    void setPatience(const word_type noIterations) {
+        patience = noIterations;
+    }
+
+    /**
+     * Sets the seed of the first chain; chain c is seeded with seed + c. Without, it is taken from
+     * std::random_device.
+     */
+    void setSeed(const uint64_t seed) {
+        this->seed = seed;
+    }
+
+    /**
+     * Sets by how much the best AMI of a chain may trail the best AMI of all chains before the chain is abandoned.
+     * With infinity no chain is abandoned.
+     */
+    void setAbandonMargin(const double margin) {
+        abandonMargin = margin;
+    }
+
+    /**
+     * Sets the number of iterations all chains run before any of them can be abandoned.
+     */
+    void setGraceIterations(const word_type noIterations) {
+        graceIterations = noIterations;
+    }
+
+    void setCountDomain(const bool enabled) {
+        countDomain = enabled;
+    }
+
+    void setVectorizedScoring(const bool enabled) {
+        vectorizedScoring = enabled;
+    }
+
+    void setBoundPruning(const bool enabled) {
+        boundPruning = enabled;
+    }
+
+    /**
+     * The chains of the last call to cluster.
+     */
+    const vector<EnsembleChain> &getChains() const {
+        return chains;
+    }
+
+    /**
+     * Index of the chain whose clustering the last call to cluster returned.
+     */
+    word_type getBestChain() const {
+        return bestChain;
+    }
+};
+
+
+#endif //STOCHASTICEXCHANGEENSEMBLE_H
@@ -0,0 +1,138 @@
+#include "WordClusterCounts.h"
+#include <algorithm>
+#include <cassert>
+
+WordClusterCounts::WordClusterCounts(const BigramMatrix &contexts, const vector_word_type &wordsToClusters,
+                                     const word_type numClusters, Representation representation,
+                                     const word_type shard, const word_type numShards) {
+    const word_type vocabularySize = wordsToClusters.size();
+    this->numClusters = numClusters;
+    this->shard = shard;
+    this->numShards = numShards;
+    if (numShards > 1) {
+        representation = SPARSE;
+    } else if (representation == AUTOMATIC) {
+        representation = chooseRepresentation(vocabularySize, numClusters, contexts.getNumberOfEntries());
+    }
+    this->sparse = representation == SPARSE;
+
+    if (!sparse) {
+//        every row is zeroed by the thread that fills it, so that the pages are spread over the NUMA nodes of the
+//        threads instead of all being placed on the node of the calling thread
+        dense = first_touch_vector<word_type>();
+        dense.resize((uint64_t) vocabularySize * numClusters);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (word_type wordID = 0; wordID < vocabularySize; ++wordID) {
+            word_type *row = dense.data() + (uint64_t) wordID * numClusters;
+            std::fill(row, row + numClusters, 0);
+            for (const BigramEntry &context : contexts.row(wordID)) {
+                row[wordsToClusters[context.neighbour]] += context.count;
+            }
+        }
+        return;
+    }
+
+    offsets = vector<uint64_t>(vocabularySize + 1, 0);
+    for (word_type wordID = 0; wordID < vocabularySize; ++wordID) {
+        const uint64_t capacity = outsideShard(wordID)
+                                  ? 0 : std::min<uint64_t>(contexts.row(wordID).size(), numClusters);
+        offsets[wordID + 1] = offsets[wordID] + capacity;
+    }
+    lengths = vector_word_type(vocabularySize, 0);
+    entries = first_touch_vector<ClusterCount>();
+    entries.resize(offsets[vocabularySize]);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (word_type wordID = 0; wordID < vocabularySize; ++wordID) {
+        if (outsideShard(wordID)) {
+            continue;
+        }
+        ClusterCount *row = entries.data() + offsets[wordID];
+        std::fill(row, entries.data() + offsets[wordID + 1], ClusterCount{0, 0});
+        vector<ClusterCount> counts;
+        counts.reserve(contexts.row(wordID).size());
+        for (const BigramEntry &context : contexts.row(wordID)) {
+            counts.push_back({wordsToClusters[context.neighbour], context.count});
+        }
+        sort(counts.begin(), counts.end(), [](const ClusterCount &a, const ClusterCount &b) {
+            return a.cluster < b.cluster;
+        });
+        word_type length = 0;
+        for (const ClusterCount &count : counts) {
+            if (length > 0 && row[length - 1].cluster == count.cluster) {
+                row[length - 1].count += count.count;
+            } else {
+                row[length++] = count;
+            }
+        }
+        lengths[wordID] = length;
+    }
+}
+
+WordClusterCounts::Representation
+WordClusterCounts::chooseRepresentation(const uint64_t vocabularySize, const uint64_t numClusters,
+                                        const uint64_t numberOfEntries) {
+    const uint64_t denseBytes = vocabularySize * numClusters * sizeof(word_type);
+    const uint64_t sparseBytes = numberOfEntries * sizeof(ClusterCount)
+                                 + vocabularySize * (sizeof(uint64_t) + sizeof(word_type));
+    return sparseBytes * 4 < denseBytes ? SPARSE : DENSE;
+}
+
+ClusterCount *WordClusterCounts::findInRow(const word_type wordID, const word_type clusterID) {
+    ClusterCount *first = entries.data() + offsets[wordID];
+    ClusterCount *last = first + lengths[wordID];
+    return std::lower_bound(first, last, clusterID, [](const ClusterCount &entry, const word_type cluster) {
+        return entry.cluster < cluster;
+    });
+}
+
+word_type WordClusterCounts::get(const word_type wordID, const word_type clusterID) const {
+    if (!sparse) {
+        return dense[(uint64_t) wordID * numClusters + clusterID];
+    }
+    const ClusterCount *first = entries.data() + offsets[wordID];
+    const ClusterCount *last = first + lengths[wordID];
+    const ClusterCount *entry = std::lower_bound(first, last, clusterID,
+                                                 [](const ClusterCount &entry, const word_type cluster) {
+                                                     return entry.cluster < cluster;
+                                                 });
+    return entry != last && entry->cluster == clusterID ? entry->count : 0;
+}
+
+void WordClusterCounts::add(const word_type wordID, const word_type clusterID, const word_type count) {
+    if (outsideShard(wordID)) {
+        return;
+    }
+    if (!sparse) {
+        dense[(uint64_t) wordID * numClusters + clusterID] += count;
+        return;
+    }
+    ClusterCount *entry = findInRow(wordID, clusterID);
+    ClusterCount *last = entries.data() + offsets[wordID] + lengths[wordID];
+    if (entry != last && entry->cluster == clusterID) {
+        entry->count += count;
+    } else {
+//        a word has at most as many context clusters as it has distinct neighbours
+        assert(offsets[wordID] + lengths[wordID] < offsets[wordID + 1]);
+        std::move_backward(entry, last, last + 1);
+        *entry = {clusterID, count};
+        ++lengths[wordID];
+    }
+}
+
+void WordClusterCounts::subtract(const word_type wordID, const word_type clusterID, const word_type count) {
+    if (outsideShard(wordID)) {
+        return;
+    }
+    if (!sparse) {
+        dense[(uint64_t) wordID * numClusters + clusterID] -= count;
+        return;
+    }
+    ClusterCount *entry = findInRow(wordID, clusterID);
+    ClusterCount *last = entries.data() + offsets[wordID] + lengths[wordID];
+    assert(entry != last && entry->cluster == clusterID && entry->count >= count);
+    entry->count -= count;
+    if (entry->count == 0) {
+        std::move(entry + 1, last, entry);
+        --lengths[wordID];
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef BROWN_WORDCLUSTERCOUNTS_H
+#define BROWN_WORDCLUSTERCOUNTS_H
+
+#include "../Utils.h"
+#include "../models/BigramMatrix.h"
+#include "../NumaPlacement.h"
+#include <cstdint>
+
+/**
+ * One stored entry of a sparse WordClusterCounts row: a cluster ID and the number of bigrams between the word and
+ * words of that cluster.
+ */
+struct ClusterCount {
+    word_type cluster;
+    word_type count;
+};
+
+/**
+ * Number of bigrams between every word and every cluster, i.e. for every word w and cluster c the number of times
+ * a word of cluster c occurs next to w (following or preceding, depending on the context matrix the counts were
+ * built from).
+ *
+ * The counts are either stored densely (V x K) or sparsely. In the sparse representation row w holds the nonzero
+ * (cluster, count) pairs sorted by cluster, in a slot whose capacity is the smaller of K and the number of distinct
+ * neighbours of w. A word can never have nonzero counts for more clusters than that, so rows are never reallocated
+ * and the total size is proportional to the number of bigrams instead of V x K.
+ */
+class WordClusterCounts {
+public:
+    enum Representation {
+        AUTOMATIC,
+        DENSE,
+        SPARSE
+    };
+
+    WordClusterCounts() = default;
+
+    /**
+     * Computes the counts for the given cluster assignments.
+     * @param contexts matrix whose row w lists the neighbours of word w with their bigram counts
+     * @param wordsToClusters cluster of every word
+     * @param numClusters number of clusters
+     * @param representation storage to use; AUTOMATIC picks one via chooseRepresentation
+     * @param shard, numShards only the rows of the words w with w % numShards == shard are stored, all other rows
+     * stay empty and add and subtract ignore them. With more than one shard the counts are always stored sparsely,
+     * so the memory is proportional to the bigrams of the shard.
+     */
+    WordClusterCounts(const BigramMatrix &contexts, const vector_word_type &wordsToClusters, word_type numClusters,
+                      Representation representation = AUTOMATIC, word_type shard = 0, word_type numShards = 1);
+
+    /**
+     * Picks the sparse representation whenever it needs less than a quarter of the memory of the dense one. Dense
+     * lookups are a little cheaper, so it is kept for small or densely filled problems.
+     * @param vocabularySize number of words
+     * @param numClusters number of clusters
+     * @param numberOfEntries number of stored bigrams of the context matrix
+     */
+    static Representation
+    chooseRepresentation(uint64_t vocabularySize, uint64_t numClusters, uint64_t numberOfEntries);
+
+    /**
+     * Returns the count for a word and a cluster.
+     */
+    word_type get(word_type wordID, word_type clusterID) const;
+
+    /**
+     * Adds count to the entry of a word and a cluster. Does nothing for words outside the shard.
+     */
+    void add(word_type wordID, word_type clusterID, word_type count);
+
+    /**
+     * Subtracts count from the entry of a word and a cluster. The entry must hold at least count. Does nothing for
+     * words outside the shard.
+     */
+    void subtract(word_type wordID, word_type clusterID, word_type count);
+
+    /**
+     * Calls f(cluster, count) for every nonzero entry of a word, in increasing order of cluster IDs.
+     */
+    template<typename F>
+    void forEachCluster(const word_type wordID, F f) const {
+        if (sparse) {
+            const ClusterCount *first = entries.data() + offsets[wordID];
+            const ClusterCount *last = first + lengths[wordID];
+            for (const ClusterCount *entry = first; entry != last; ++entry) {
+                f(entry->cluster, entry->count);
+            }
+        } else {
+            const word_type *row = dense.data() + (uint64_t) wordID * numClusters;
+            for (word_type clusterID = 0; clusterID < numClusters; ++clusterID) {
+                if (row[clusterID] != 0) {
+                    f(clusterID, row[clusterID]);
+                }
+            }
+        }
+    }
+
+    bool isSparse() const {
+        return sparse;
+    }
+
+private:
+    bool sparse = false;
+    word_type numClusters = 0;
+    word_type shard = 0;
+    word_type numShards = 1;
+    /**
+     * Dense representation, row-major V x K.
+     */
+    first_touch_vector<word_type> dense;
+    /**
+     * Sparse representation: row w occupies entries[offsets[w]] up to (excluding) entries[offsets[w + 1]], of which
+     * the first lengths[w] are in use.
+     */
+    vector<uint64_t> offsets;
+    vector_word_type lengths;
+    first_touch_vector<ClusterCount> entries;
+
+    /**
+     * Returns the position of a cluster within the used part of a sparse row, or the position it would have to be
+     * inserted at.
+     */
+    ClusterCount *findInRow(word_type wordID, word_type clusterID);
+
+    bool outsideShard(const word_type wordID) const {
+        return numShards > 1 && wordID % numShards != shard;
+    }
+};
+
+#endif //BROWN_WORDCLUSTERCOUNTS_H
@@ -0,0 +1,143 @@
+#include "NumaPlacement.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    const string NODE_DIRECTORY = "/sys/devices/system/node/";
+
+    /**
+     * Parses a CPU list of sysfs such as "0-3,8,10-11".
+     */
+    vector<int> parseCpuList(const string &cpuList) {
+        vector<int> cpus;
+        stringstream stream(cpuList);
+        string range;
+        while (getline(stream, range, ',')) {
+            if (range.empty() || range == "\n") {
+                continue;
+            }
+            const size_t dash = range.find('-');
+            const int first = stoi(range.substr(0, dash));
+            const int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    /**
+     * The CPUs of every NUMA node, ordered by node; empty if sysfs does not describe the nodes.
+     */
+    vector<vector<int>> cpusOfNodes() {
+        vector<pair<int, vector<int>>> nodes;
+        DIR *directory = opendir(NODE_DIRECTORY.c_str());
+        if (directory == nullptr) {
+            return {};
+        }
+        while (const dirent *entry = readdir(directory)) {
+            const string name = entry->d_name;
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+                || name.find_first_not_of("0123456789", 4) != string::npos) {
+                continue;
+            }
+            ifstream cpuList(NODE_DIRECTORY + name + "/cpulist");
+            string line;
+            if (getline(cpuList, line)) {
+                nodes.emplace_back(stoi(name.substr(4)), parseCpuList(line));
+            }
+        }
+        closedir(directory);
+        sort(nodes.begin(), nodes.end());
+        vector<vector<int>> result;
+        for (pair<int, vector<int>> &node : nodes) {
+            result.push_back(std::move(node.second));
+        }
+        return result;
+    }
+
+    cpu_set_t allowedCpus() {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            throw runtime_error(string("Could not read the CPU affinity: ") + std::strerror(errno));
+        }
+        return allowed;
+    }
+}
+
+vector<int> NumaPlacement::cpusByNode() {
+    cpu_set_t allowed = allowedCpus();
+    vector<int> cpus;
+    for (const vector<int> &node : cpusOfNodes()) {
+        for (const int cpu : node) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+                CPU_CLR(cpu, &allowed);
+            }
+        }
+    }
+//    CPUs sysfs does not know about, e.g. in containers without /sys
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+word_type NumaPlacement::numberOfNodes() {
+    const cpu_set_t allowed = allowedCpus();
+    word_type nodes = 0;
+    for (const vector<int> &node : cpusOfNodes()) {
+        nodes += std::any_of(node.begin(), node.end(), [&allowed](const int cpu) {
+            return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+        });
+    }
+    return std::max<word_type>(1, nodes);
+}
+
+uint64_t NumaPlacement::pageSize() {
+    const long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? size : 4096;
+}
+
+word_type NumaPlacement::currentNode() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+word_type NumaPlacement::pinThreads() {
+    const vector<int> cpus = cpusByNode();
+    if (cpus.empty()) {
+        throw runtime_error("No CPU to pin the threads to");
+    }
+    std::atomic<int> error(0);
+    word_type pinned = 0;
+#pragma omp parallel reduction(+:pinned)
+    {
+        cpu_set_t cpu;
+        CPU_ZERO(&cpu);
+        CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &cpu);
+        const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu);
+        if (result != 0) {
+            error = result;
+        } else {
+            ++pinned;
+        }
+    }
+    if (error != 0) {
+        throw runtime_error(string("Could not pin the threads: ") + std::strerror(error));
+    }
+    return pinned;
+}
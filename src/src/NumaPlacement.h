@@ -0,0 +1,231 @@
+#ifndef BROWN_NUMAPLACEMENT_H
+#define BROWN_NUMAPLACEMENT_H
+
+
+#include "Utils.h"
+#include <cstdlib>
+#include <memory>
+#include <omp.h>
+
+/**
+ * Allocator that leaves the elements of a vector uninitialized unless a value is given. Linux places a page on the
+ * NUMA node of the thread that first writes to it, so a vector allocated with it can be filled by the threads that
+ * later work on its parts instead of being zeroed by the allocating thread.
+ */
+template<typename T>
+struct FirstTouchAllocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+        typedef FirstTouchAllocator<U> other;
+    };
+
+    FirstTouchAllocator() = default;
+
+    template<typename U>
+    FirstTouchAllocator(const FirstTouchAllocator<U> &) noexcept {};
+
+    template<typename U>
+    void construct(U *pointer) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new((void *) pointer) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U *pointer, Args &&... args) {
+        ::new((void *) pointer) U(std::forward<Args>(args)...);
+    }
+};
+
+template<typename T>
+using first_touch_vector = vector<T, FirstTouchAllocator<T>>;
+
+/**
+ * Row-major matrix in one uninitialized allocation that starts on a page boundary, so that its pages can be placed
+ * by whoever writes them first, see NumaPlacement::fillByColumnBlocks. Rows are contiguous; matrix[i] points to row i.
+ */
+template<typename T>
+class FirstTouchMatrix {
+private:
+    struct Free {
+        void operator()(T *elements) const {
+            std::free(elements);
+        }
+    };
+
+    std::unique_ptr<T[], Free> elements;
+    uint64_t rows = 0;
+    uint64_t columns = 0;
+
+public:
+    FirstTouchMatrix() = default;
+
+    /**
+     * Allocates rows x columns elements without initializing them.
+     * @param alignment alignment of the first element in bytes, a power of two (usually the page size)
+     */
+    FirstTouchMatrix(const uint64_t rows, const uint64_t columns, const uint64_t alignment)
+            : rows(rows), columns(columns) {
+        const uint64_t bytes = std::max<uint64_t>(1, rows * columns * sizeof(T));
+        elements.reset(static_cast<T *>(std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment
+                                                                      * alignment)));
+        if (elements == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    T *operator[](const uint64_t row) {
+        return elements.get() + row * columns;
+    }
+
+    const T *operator[](const uint64_t row) const {
+        return elements.get() + row * columns;
+    }
+
+    T *data() {
+        return elements.get();
+    }
+
+    const T *data() const {
+        return elements.get();
+    }
+
+    uint64_t getNumberOfRows() const {
+        return rows;
+    }
+
+    uint64_t getNumberOfColumns() const {
+        return columns;
+    }
+
+    bool empty() const {
+        return rows * columns == 0;
+    }
+
+    bool operator==(const FirstTouchMatrix &other) const {
+        return rows == other.rows && columns == other.columns
+               && std::equal(data(), data() + rows * columns, other.data());
+    }
+};
+
+/**
+ * Placement of memory and threads on machines with several NUMA nodes (sockets). Without libnuma: the topology is
+ * read from sysfs and memory is placed by the first-touch policy of Linux.
+ */
+class NumaPlacement {
+public:
+    /**
+     * The columns [first, last) of a matrix with the given number of columns that a thread of a team works on. The
+     * same partition as the candidate blocks of Exchange::clusterInternal.
+     */
+    static pair<uint64_t, uint64_t> columnBlock(const uint64_t columns, const word_type threadID,
+                                                const word_type numThreads) {
+        return {columns * threadID / numThreads, columns * (threadID + 1) / numThreads};
+    }
+
+    /**
+     * The thread whose columnBlock contains the given column.
+     */
+    static word_type columnOwner(const uint64_t columns, const uint64_t column, const word_type numThreads) {
+        return ((column + 1) * numThreads - 1) / columns;
+    }
+
+    /**
+     * Size of a page of memory in bytes, the unit in which Linux places memory on a node.
+     */
+    static uint64_t pageSize();
+
+    /**
+     * Reallocates a matrix with rows x columns elements and fills it with value. A new team of threads writes it
+     * page by page: each page is first touched by the thread whose columnBlock holds the middle of the page, so that
+     * Linux puts it on that thread's node. Once a column block spans several pages, every thread finds nearly all of
+     * the entries it scores on its own node; for narrower blocks the pages end up spread evenly over the nodes of
+     * the team instead of all on one. Must be called outside of a parallel region; placement only pays off if the
+     * threads are pinned, see pinThreads.
+     * @param parallel if false, the calling thread fills the whole matrix
+     */
+    template<typename T>
+    static void fillByColumnBlocks(FirstTouchMatrix<T> &matrix, const uint64_t rows, const uint64_t columns,
+                                   const T value, const bool parallel = true) {
+        const uint64_t page = pageSize();
+        matrix = FirstTouchMatrix<T>(rows, columns, page);
+        const uint64_t size = rows * columns;
+        const uint64_t elementsPerPage = std::max<uint64_t>(1, page / sizeof(T));
+        const uint64_t numPages = (size + elementsPerPage - 1) / elementsPerPage;
+        T *data = matrix.data();
+#pragma omp parallel if(parallel)
+        {
+            const word_type threadID = omp_get_thread_num();
+            const word_type numThreads = omp_get_num_threads();
+            for (uint64_t pageID = 0; pageID < numPages; ++pageID) {
+                const uint64_t first = pageID * elementsPerPage;
+                const uint64_t last = std::min(size, first + elementsPerPage);
+                if (columnOwner(columns, (first + last) / 2 % columns, numThreads) == threadID) {
+                    std::fill(data + first, data + last, value);
+                }
+            }
+        }
+    }
+
+    /**
+     * Makes one copy of some read-only data per NUMA node the threads of a new team run on. The first thread of the
+     * team found on a node calls makeCopy, so the copy's memory is first touched on that node. Without parallel, the
+     * calling thread makes the only copy.
+     * @return the copies indexed by node (see currentNode); nodes without threads get none
+     */
+    template<typename T, typename F>
+    static vector<T> replicatePerNode(const F &makeCopy, const bool parallel = true) {
+        vector<T> replicas;
+        vector<bool> made;
+#pragma omp parallel if(parallel)
+        {
+            const word_type node = currentNode();
+            bool mine = false;
+#pragma omp critical(replicatePerNode)
+            {
+                if (made.size() <= node) {
+                    made.resize(node + 1, false);
+                }
+                mine = !made[node];
+                made[node] = true;
+            }
+            if (mine) {
+                T replica = makeCopy();
+#pragma omp critical(replicatePerNode)
+                {
+                    if (replicas.size() <= node) {
+                        replicas.resize(node + 1);
+                    }
+                    replicas[node] = std::move(replica);
+                }
+            }
+        }
+        return replicas;
+    }
+
+    /**
+     * The CPUs the process may run on, ordered by NUMA node, so that consecutive threads share a node.
+     */
+    static vector<int> cpusByNode();
+
+    /**
+     * Number of NUMA nodes with CPUs the process may run on; 1 if the topology is unknown.
+     */
+    static word_type numberOfNodes();
+
+    /**
+     * NUMA node of the CPU the calling thread currently runs on; 0 if unknown.
+     */
+    static word_type currentNode();
+
+    /**
+     * Pins thread t of a team of omp_get_max_threads() threads to the t-th CPU of cpusByNode (wrapping around if
+     * there are more threads than CPUs). OpenMP keeps reusing these threads for later parallel regions of at most
+     * that size, so thread t stays on the same node and finds the memory it first touched there. Call once, after
+     * the number of threads has been set.
+     * @return number of threads pinned
+     * @throws runtime_error if the affinity of a thread cannot be set
+     */
+    static word_type pinThreads();
+};
+
+
+#endif //BROWN_NUMAPLACEMENT_H
@@ -0,0 +1,134 @@
+#include "BigramMatrix.h"
+#include <algorithm>
+
+BigramMatrix BigramMatrix::Builder::build(const word_type numRows) {
+    vector<bigram_count_type> bigrams;
+    bigrams.reserve(counts.size());
+    for (const auto &item : counts) {
+        const auto first = (word_type) (item.first >> 32u);
+        const auto second = (word_type) (item.first & 0xFFFFFFFFu);
+        bigrams.push_back({{first, second}, item.second});
+    }
+    unordered_map<uint64_t, word_type>().swap(counts);
+    return BigramMatrix::fromBigrams(numRows, std::move(bigrams));
+}
+
+BigramMatrix BigramMatrix::fromBigrams(const word_type numRows, vector<bigram_count_type> bigrams) {
+    word_type rows = numRows;
+    for (const auto &bigram : bigrams) {
+        rows = std::max(rows, bigram.first.first + 1);
+    }
+
+//    counting sort by row: first the row sizes, then the start of every row
+    vector<uint64_t> rowStarts(rows + 1, 0);
+    for (const auto &bigram : bigrams) {
+        ++rowStarts[bigram.first.first + 1];
+    }
+    for (word_type rowID = 0; rowID < rows; ++rowID) {
+        rowStarts[rowID + 1] += rowStarts[rowID];
+    }
+    aligned_vector<BigramEntry> scattered(bigrams.size());
+    vector<uint64_t> nextFree(rowStarts.begin(), rowStarts.end() - 1);
+    for (const auto &bigram : bigrams) {
+        scattered[nextFree[bigram.first.first]++] = {bigram.first.second, bigram.second};
+    }
+    vector<bigram_count_type>().swap(bigrams);
+
+//    sort every row by neighbour and merge duplicate bigrams in place
+    vector<uint64_t> rowSizes(rows, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (word_type rowID = 0; rowID < rows; ++rowID) {
+        BigramEntry *const first = scattered.data() + rowStarts[rowID];
+        BigramEntry *const last = scattered.data() + rowStarts[rowID + 1];
+        std::sort(first, last, [](const BigramEntry &a, const BigramEntry &b) { return a.neighbour < b.neighbour; });
+        BigramEntry *output = first;
+        for (BigramEntry *it = first; it != last; ++it) {
+            if (output != first && (output - 1)->neighbour == it->neighbour) {
+                (output - 1)->count += it->count;
+            } else {
+                *output++ = *it;
+            }
+        }
+        rowSizes[rowID] = output - first;
+    }
+
+    aligned_vector<uint64_t> rowOffsets(rows + 1, 0);
+    for (word_type rowID = 0; rowID < rows; ++rowID) {
+        rowOffsets[rowID + 1] = rowOffsets[rowID] + rowSizes[rowID];
+    }
+    BigramMatrix matrix;
+    if (rowOffsets[rows] == scattered.size()) {
+        matrix.entries = std::move(scattered);
+    } else {
+        aligned_vector<BigramEntry> entries(rowOffsets[rows]);
+        for (word_type rowID = 0; rowID < rows; ++rowID) {
+            std::copy(scattered.begin() + rowStarts[rowID], scattered.begin() + rowStarts[rowID] + rowSizes[rowID],
+                      entries.begin() + rowOffsets[rowID]);
+        }
+        matrix.entries = std::move(entries);
+    }
+    matrix.rowOffsets = std::move(rowOffsets);
+    return matrix;
+}
+
+BigramMatrix BigramMatrix::fromOccurrences(const word_type numRows, const occurrence_type &occurrences) {
+    vector<bigram_count_type> bigrams(occurrences.begin(), occurrences.end());
+    return BigramMatrix::fromBigrams(numRows, std::move(bigrams));
+}
+
+BigramMatrix BigramMatrix::transpose(const word_type numColumns) const {
+    word_type columns = numColumns;
+    for (const BigramEntry &entry : entries) {
+        columns = std::max(columns, entry.neighbour + 1);
+    }
+    aligned_vector<uint64_t> transposedOffsets(columns + 1, 0);
+    for (const BigramEntry &entry : entries) {
+        ++transposedOffsets[entry.neighbour + 1];
+    }
+    for (word_type columnID = 0; columnID < columns; ++columnID) {
+        transposedOffsets[columnID + 1] += transposedOffsets[columnID];
+    }
+//    visiting rows in increasing order keeps every transposed row sorted by neighbour
+    aligned_vector<BigramEntry> transposedEntries(entries.size());
+    vector<uint64_t> nextFree(transposedOffsets.begin(), transposedOffsets.end() - 1);
+    this->forEach([&](const word_type rowID, const word_type neighbour, const word_type count) {
+        transposedEntries[nextFree[neighbour]++] = {rowID, count};
+    });
+    BigramMatrix transposed;
+    transposed.rowOffsets = std::move(transposedOffsets);
+    transposed.entries = std::move(transposedEntries);
+    return transposed;
+}
+
+word_type BigramMatrix::get(const word_type rowID, const word_type neighbour) const {
+    const Row entriesOfRow = row(rowID);
+    const BigramEntry *it = std::lower_bound(entriesOfRow.begin(), entriesOfRow.end(), neighbour,
+                                             [](const BigramEntry &entry, const word_type value) {
+                                                 return entry.neighbour < value;
+                                             });
+    if (it == entriesOfRow.end() || it->neighbour != neighbour) {
+        return 0;
+    } else {
+        return it->count;
+    }
+}
+
+bool BigramMatrix::isSymmetric() const {
+    const word_type numRows = getNumberOfRows();
+    bool symmetric = true;
+#pragma omp parallel for schedule(dynamic, 1024) reduction(&&:symmetric)
+    for (word_type rowID = 0; rowID < numRows; ++rowID) {
+        for (const BigramEntry &entry : row(rowID)) {
+            symmetric = symmetric && get(entry.neighbour, rowID) == entry.count;
+        }
+    }
+    return symmetric;
+}
+
+occurrence_type BigramMatrix::toOccurrences() const {
+    occurrence_type occurrences;
+    this->forEach([&](const word_type rowID, const word_type neighbour, const word_type count) {
+        occurrences.emplace_hint(occurrences.end(), pair_of_word_type(rowID, neighbour), count);
+    });
+    return occurrences;
+}
@@ -0,0 +1,216 @@
+#ifndef BROWN_BIGRAMMATRIX_H
+#define BROWN_BIGRAMMATRIX_H
+
+#include "../Utils.h"
+#include "CorpusArray.h"
+#include <cstdint>
+#include <cereal/cereal.hpp>
+#include <cereal/types/utility.hpp>
+
+/**
+ * One stored entry of a BigramMatrix row: the ID of the neighbouring word and how often the bigram occurs.
+ */
+struct BigramEntry {
+    word_type neighbour;
+    word_type count;
+
+    bool operator==(const BigramEntry &other) const {
+        return neighbour == other.neighbour && count == other.count;
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(neighbour, count);
+    }
+};
+
+/**
+ * A bigram together with its count, as in ((firstWord, secondWord), count).
+ */
+typedef pair<pair_of_word_type, word_type> bigram_count_type;
+
+/**
+ * Compressed sparse row (CSR) storage for bigram counts.
+ * Row i holds the (neighbour, count) pairs of word i contiguously in memory, sorted by neighbour ID. Depending on
+ * how the matrix was built, row i lists the words following i (row-major) or the words preceding i (column-major,
+ * see BigramMatrix::transpose).
+ */
+class BigramMatrix {
+public:
+    /**
+     * Read-only view over the entries of a single row.
+     */
+    class Row {
+    private:
+        const BigramEntry *first;
+        const BigramEntry *last;
+    public:
+        Row(const BigramEntry *first, const BigramEntry *last) : first(first), last(last) {};
+
+        const BigramEntry *begin() const { return first; }
+
+        const BigramEntry *end() const { return last; }
+
+        size_t size() const { return last - first; }
+
+        bool empty() const { return first == last; }
+    };
+
+    /**
+     * Accumulates bigram counts one occurrence at a time and turns them into a BigramMatrix. Meant for readers
+     * that do not know the vocabulary size or the number of distinct bigrams in advance.
+     */
+    class Builder {
+    private:
+        unordered_map<uint64_t, word_type> counts;
+    public:
+        /**
+         * Adds count occurrences of the bigram (first, second).
+         */
+        void add(const word_type first, const word_type second, const word_type count = 1) {
+            counts[((uint64_t) first << 32u) | second] += count;
+        }
+
+        /**
+         * Builds the matrix. The builder is left empty.
+         * @param numRows minimum number of rows (usually the vocabulary size)
+         */
+        BigramMatrix build(word_type numRows);
+    };
+
+    BigramMatrix() : rowOffsets(aligned_vector<uint64_t>(1, 0)) {};
+
+    /**
+     * Builds a matrix from an unordered list of bigrams. Counts of duplicate bigrams are summed.
+     * @param numRows minimum number of rows. The matrix grows if a bigram starts with a larger word ID.
+     * @param bigrams list of ((row, neighbour), count). The list is consumed.
+     */
+    static BigramMatrix fromBigrams(word_type numRows, vector<bigram_count_type> bigrams);
+
+    /**
+     * Builds a matrix from a map of occurrences.
+     * @param numRows minimum number of rows
+     * @param occurrences map of ((row, neighbour), count)
+     */
+    static BigramMatrix fromOccurrences(word_type numRows, const occurrence_type &occurrences);
+
+    /**
+     * Returns the transpose of this matrix, i.e. the column-major representation of the same bigrams.
+     * @param numColumns minimum number of rows of the transposed matrix
+     */
+    BigramMatrix transpose(word_type numColumns) const;
+
+    /**
+     * Returns the entries stored for the given row. Rows past the end of the matrix are empty.
+     */
+    Row row(const word_type rowID) const {
+        if (rowID + 1 >= rowOffsets.size()) {
+            return Row(nullptr, nullptr);
+        }
+        const BigramEntry *data = entries.data();
+        return Row(data + rowOffsets[rowID], data + rowOffsets[rowID + 1]);
+    }
+
+    /**
+     * Returns the count stored for (rowID, neighbour), or 0 if the bigram never occurs.
+     * Runs a binary search over the row.
+     */
+    word_type get(word_type rowID, word_type neighbour) const;
+
+    /**
+     * Returns whether every bigram (i, j) occurs as often as (j, i), i.e. whether the matrix equals its transpose.
+     */
+    bool isSymmetric() const;
+
+    /**
+     * Calls f(row, neighbour, count) for every stored entry in row-major order.
+     */
+    template<typename F>
+    void forEach(F f) const {
+        const word_type numRows = getNumberOfRows();
+        for (word_type rowID = 0; rowID < numRows; ++rowID) {
+            for (const BigramEntry &entry : row(rowID)) {
+                f(rowID, entry.neighbour, entry.count);
+            }
+        }
+    }
+
+    /**
+     * Returns the content of the matrix as a map of occurrences. Mostly useful for tests and debugging.
+     */
+    occurrence_type toOccurrences() const;
+
+    word_type getNumberOfRows() const {
+        return rowOffsets.size() - 1;
+    }
+
+    /**
+     * Returns the number of stored (non-zero) bigrams.
+     */
+    size_t getNumberOfEntries() const {
+        return entries.size();
+    }
+
+    bool operator==(const BigramMatrix &other) const {
+        return rowOffsets == other.rowOffsets && entries == other.entries;
+    }
+
+    /**
+     * Writes the matrix with the same layout cereal uses for an occurrence_type map, so that corpus files stay
+     * readable by older builds.
+     */
+    template<class Archive>
+    void saveAsOccurrences(Archive &ar) const {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(getNumberOfEntries())));
+        this->forEach([&ar](word_type rowID, word_type neighbour, word_type count) {
+            pair_of_word_type key(rowID, neighbour);
+            ar(cereal::make_map_item(key, count));
+        });
+    }
+
+    /**
+     * Reads a matrix written by saveAsOccurrences (or a serialized occurrence_type map). Bigrams are expected in
+     * map order, which lets the rows be filled without sorting.
+     * @param numRows minimum number of rows
+     */
+    template<class Archive>
+    void loadFromOccurrences(Archive &ar, const word_type numRows) {
+        cereal::size_type numberOfEntries;
+        ar(cereal::make_size_tag(numberOfEntries));
+        aligned_vector<uint64_t> offsets(numRows + 1, 0);
+        aligned_vector<BigramEntry> loadedEntries;
+        loadedEntries.reserve(numberOfEntries);
+        pair_of_word_type previous(0, 0);
+        for (cereal::size_type i = 0; i < numberOfEntries; ++i) {
+            pair_of_word_type key;
+            word_type count;
+            ar(cereal::make_map_item(key, count));
+            if (i > 0 && key <= previous) {
+                throw runtime_error("Bigrams are not stored in increasing order");
+            }
+            previous = key;
+            if (key.first + 1 >= offsets.size()) {
+                offsets.resize(key.first + 2, 0);
+            }
+            ++offsets[key.first + 1];
+            loadedEntries.push_back({key.second, count});
+        }
+        for (size_t rowID = 1; rowID < offsets.size(); ++rowID) {
+            offsets[rowID] += offsets[rowID - 1];
+        }
+        rowOffsets = std::move(offsets);
+        entries = std::move(loadedEntries);
+    }
+
+    /**
+     * Start of every row in entries. Has getNumberOfRows() + 1 elements; row i spans
+     * [rowOffsets[i], rowOffsets[i + 1]).
+     */
+    CorpusArray<uint64_t> rowOffsets;
+    /**
+     * Entries of all rows, stored one row after the other.
+     */
+    CorpusArray<BigramEntry> entries;
+};
+
+#endif //BROWN_BIGRAMMATRIX_H
@@ -1,15 +1,19 @@
 #include "Corpus.h"
+#include "MappedCorpusFile.h"
 #include <fstream>
 #include <algorithm>
 
-void Corpus::serializeToFile(const Corpus c, const string fileName) {
+void Corpus::serializeToFile(const Corpus &c, const string &fileName) {
     std::ofstream ofs(fileName, std::ios::binary);
     cereal::PortableBinaryOutputArchive oa(ofs);
     oa(c);
     ofs.close();
 }
 
-Corpus Corpus::deserializeFromFile(const string fileName) {
+Corpus Corpus::deserializeFromFile(const string &fileName) {
+    if (MappedCorpusFile::isMappedCorpusFile(fileName)) {
+        return MappedCorpusFile::read(fileName);
+    }
     Corpus newCorpus;
     std::ifstream ifs(fileName);
     if (!ifs.is_open()) {
@@ -20,6 +24,27 @@ Corpus Corpus::deserializeFromFile(const string fileName) {
     return newCorpus;
 }
 
+corpus_handle Corpus::deserializeSharedFromFile(const string &fileName) {
+    return make_shared<const Corpus>(deserializeFromFile(fileName));
+}
+
+void Corpus::setOccurrences(BigramMatrix rowMajorOccurrences, const bool symmetric) {
+    if (symmetric && !rowMajorOccurrences.isSymmetric()) {
+        throw runtime_error("Bigram counts of a symmetric corpus are not symmetric");
+    }
+    this->occurrences = std::move(rowMajorOccurrences);
+    this->symmetric = symmetric;
+    if (symmetric) {
+        this->occurrencesTransposed = BigramMatrix();
+    } else {
+        this->occurrencesTransposed = this->occurrences.transpose(this->vocabularySize);
+    }
+}
+
+void Corpus::setOccurrences(const occurrence_type &occurrenceMap, const bool symmetric) {
+    setOccurrences(BigramMatrix::fromOccurrences(this->vocabularySize, occurrenceMap), symmetric);
+}
+
 pair<matrix_occurrences, matrix_occurrences>
 Corpus::computeLeftiesAndRighties(const Corpus &corpus) {
     pair<matrix_occurrences, matrix_occurrences> result;
@@ -27,9 +52,14 @@ Corpus::computeLeftiesAndRighties(const Corpus &corpus) {
     result.first = matrix_occurrences(corpus.vocabularySize, vector_word_type());
     result.second = matrix_occurrences(corpus.vocabularySize, vector_word_type());
 
-    for (auto occurrence : corpus.occurrences) {
-        result.first[occurrence.first.second].push_back(occurrence.first.first);
-        result.second[occurrence.first.first].push_back(occurrence.first.second);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
+        for (const BigramEntry &left : corpus.getOccurrencesTransposed().row(wordID)) {
+            result.first[wordID].push_back(left.neighbour);
+        }
+        for (const BigramEntry &right : corpus.occurrences.row(wordID)) {
+            result.second[wordID].push_back(right.neighbour);
+        }
     }
     return result;
 };
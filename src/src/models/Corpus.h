@@ -2,6 +2,8 @@
 #define BROWN_CORPUS_H
 
 #include "../Utils.h"
+#include "BigramMatrix.h"
+#include "Vocabulary.h"
 #include <map>
 #include <cereal/archives/portable_binary.hpp>
 #include <cereal/types/vector.hpp>
@@ -10,6 +12,7 @@
 #include <cereal/types/utility.hpp>
 #include <cereal/types/string.hpp>
 #include <cassert>
+#include <optional>
 
 class Corpus {
 public:
@@ -25,9 +28,11 @@ public:
         equal &= this->corpusLength == Ref.corpusLength;
         equal &= this->pl == Ref.pl;
         equal &= this->pr == Ref.pr;
-        equal &= this->idsToWords == Ref.idsToWords;
+        equal &= this->vocabulary == Ref.vocabulary;
         equal &= this->occurrences == Ref.occurrences;
-        equal &= this->wordCountAsNumbers == Ref.wordCountAsNumbers;
+        equal &= this->symmetric == Ref.symmetric;
+        equal &= this->wordCounts == Ref.wordCounts;
+        equal &= this->firstPositions == Ref.firstPositions;
         return equal;
     }
 
@@ -42,23 +47,48 @@ public:
     /**
      * Probabilities left.
      */
-    vector<double> pl;
+    CorpusArray<double> pl;
     /**
      * Probabilities right.
      */
-    vector<double> pr;
+    CorpusArray<double> pr;
+    /**
+     * Number of times each word occurs in the corpus. Empty for corpora that have no notion of words (e.g. corpora
+     * over clusters).
+     */
+    CorpusArray<word_type> wordCounts;
+    /**
+     * Position in the text of the first occurrence of each word. Empty when unknown.
+     * pl, pr, wordCounts and firstPositions are parallel arrays indexed by word ID.
+     */
+    CorpusArray<word_type> firstPositions;
     /**
      * Mapping between IDs and words.
      */
-    unordered_map<word_type, string> idsToWords;
+    Vocabulary vocabulary;
     /**
-     * Map of occurrences between words.
+     * Bigram counts stored row-major: occurrences.row(i) lists the words following word i together with the
+     * number of times they follow it.
      */
-    occurrence_type occurrences;
+    BigramMatrix occurrences;
     /**
-     * Map of word counts.
+     * The same bigram counts stored column-major: occurrencesTransposed.row(j) lists the words preceding word j.
+     * Kept in sync with occurrences by Corpus::setOccurrences. Empty for symmetric corpora, whose column-major
+     * representation is occurrences itself; read it through getOccurrencesTransposed.
      */
-    unordered_map<word_type, word_type> wordCountAsNumbers;
+    BigramMatrix occurrencesTransposed;
+    /**
+     * Whether every bigram (a, b) occurs as often as (b, a), as in the skip-gram corpora of ReaderNoOrderSkip. Then
+     * pl equals pr, the words preceding a word are the words following it, and only the row-major bigram counts are
+     * stored. Exchange and Brown use it to do the work of both directions once.
+     */
+    bool symmetric = false;
+    /**
+     * Returns the bigram counts stored column-major, see occurrencesTransposed.
+     */
+    const BigramMatrix &getOccurrencesTransposed() const {
+        return symmetric ? this->occurrences : this->occurrencesTransposed;
+    }
     /**
      * Returns the number of transitions in the corpus.
      */
@@ -66,14 +96,43 @@ public:
         return this->corpusLength - 1;
     }
     /**
-     * Returns the string representation of a word ID
+     * Returns the number of times wordID2 follows wordID1 in the corpus.
+     */
+    word_type getOccurrence(const word_type wordID1, const word_type wordID2) const {
+        return this->occurrences.get(wordID1, wordID2);
+    }
+    /**
+     * Returns the word counts of this corpus, indexed by word ID.
+     * @throws runtime_error if the corpus has no word counts
+     */
+    const word_type *getWordCounts() const {
+        if (this->wordCounts.size() < this->vocabularySize) {
+            throw runtime_error("Corpus has no word counts");
+        }
+        return this->wordCounts.data();
+    }
+    /**
+     * Replaces the bigram counts of this corpus. Both the row-major and the column-major representation are
+     * updated, unless the counts are symmetric. Requires vocabularySize to be set.
+     * @param rowMajorOccurrences bigram counts where row i lists the words following word i
+     * @param symmetric whether to store the counts as a symmetric corpus, see Corpus::symmetric
+     * @throws runtime_error if the counts are said to be symmetric but are not
+     */
+    void setOccurrences(BigramMatrix rowMajorOccurrences, bool symmetric = false);
+    /**
+     * Replaces the bigram counts of this corpus with the content of an occurrence map. Requires vocabularySize
+     * to be set.
+     */
+    void setOccurrences(const occurrence_type &occurrenceMap, bool symmetric = false);
+    /**
+     * Returns the string representation of a word ID. The view points into the vocabulary of this corpus.
      * @param wordID
      * @return
      */
-    optional<string> getWord(const word_type wordID) const {
-        optional<string> valueToReturn = std::nullopt;
-        if (wordID >= 0 && wordID < this->vocabularySize) {
-            valueToReturn = this->idsToWords.at(wordID);
+    optional<string_view> getWord(const word_type wordID) const {
+        optional<string_view> valueToReturn = std::nullopt;
+        if (wordID < this->vocabularySize && wordID < this->vocabulary.size()) {
+            valueToReturn = this->vocabulary[wordID];
         }
         return valueToReturn;
     }
@@ -88,6 +147,8 @@ public:
                                     word_type num_clusters) const;
     /**
      * Method for serializing to a file.
+     * Word counts are written as an unordered_map<word_type, word_type> so that older builds can still read the
+     * file. Version 1 appends firstPositions and version 2 the symmetric flag, which older builds ignore.
      */
     template<class Archive>
     void save(Archive & ar, const unsigned int version) const
@@ -96,9 +157,14 @@ public:
         ar(corpusLength);
         ar(pl);
         ar(pr);
-        ar(occurrences);
-        ar(wordCountAsNumbers);
-        ar(idsToWords);
+        occurrences.saveAsOccurrences(ar);
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(wordCounts.size())));
+        for (word_type wordID = 0; wordID < wordCounts.size(); ++wordID) {
+            ar(cereal::make_map_item(wordID, wordCounts[wordID]));
+        }
+        vocabulary.saveAsMap(ar);
+        ar(firstPositions);
+        ar(symmetric);
     }
     /**
      * Method for deserializing from a file.
@@ -110,22 +176,50 @@ public:
         ar(corpusLength);
         ar(pl);
         ar(pr);
-        ar(occurrences);
-        ar(wordCountAsNumbers);
-        ar(idsToWords);
+        BigramMatrix rowMajorOccurrences;
+        rowMajorOccurrences.loadFromOccurrences(ar, vocabularySize);
+        cereal::size_type numberOfWordCounts;
+        ar(cereal::make_size_tag(numberOfWordCounts));
+        aligned_vector<word_type> counts(numberOfWordCounts > 0 ? vocabularySize : 0, 0);
+        for (cereal::size_type i = 0; i < numberOfWordCounts; ++i) {
+            word_type wordID;
+            word_type count;
+            ar(cereal::make_map_item(wordID, count));
+            if (wordID >= counts.size()) {
+                counts.resize(wordID + 1, 0);
+            }
+            counts[wordID] = count;
+        }
+        wordCounts = std::move(counts);
+        vocabulary.loadFromMap(ar);
+        if (version >= 1) {
+            ar(firstPositions);
+        }
+        bool symmetricOccurrences = false;
+        if (version >= 2) {
+            ar(symmetricOccurrences);
+        }
+        setOccurrences(std::move(rowMajorOccurrences), symmetricOccurrences);
     }
     /**
      * Serializes a corpus to a file.
      * @param c corpus to write
      * @param fileName path to file
      */
-    static void serializeToFile(Corpus c, string fileName);
+    static void serializeToFile(const Corpus &c, const string &fileName);
     /**
-     * Deserializes a corpus from a file.
+     * Deserializes a corpus from a file. Both the mapped format (see MappedCorpusFile) and the legacy cereal format
+     * written by Corpus::serializeToFile are accepted; mapped files are used in place without copying their arrays.
      * @param fileName path to corpus file
      * @return instance of contained corpus
      */
-    static Corpus deserializeFromFile(string fileName);
+    static Corpus deserializeFromFile(const string &fileName);
+    /**
+     * Deserializes a corpus from a file into a shared handle, see Corpus::deserializeFromFile.
+     * @param fileName path to corpus file
+     * @return handle to the contained corpus
+     */
+    static shared_ptr<const Corpus> deserializeSharedFromFile(const string &fileName);
     /**
      * Computes for every word in a corpus a list of words following the word and a list of words preceeding the word.
      * @return a pair consisting of the words to the left of a given word (preceeding) and the words to the right of
@@ -135,4 +229,13 @@ public:
 
 };
 
+CEREAL_CLASS_VERSION(Corpus, 2);
+
+/**
+ * Reference-counted handle to an immutable corpus. Algorithms and runners share one corpus through it instead of
+ * holding copies. The corpus is never modified after it has been wrapped, so it can be read from any number of
+ * threads without synchronization.
+ */
+typedef shared_ptr<const Corpus> corpus_handle;
+
 #endif //BROWN_CORPUS_H
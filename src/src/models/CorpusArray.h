@@ -0,0 +1,188 @@
+#ifndef BROWN_CORPUSARRAY_H
+#define BROWN_CORPUSARRAY_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <initializer_list>
+#include <algorithm>
+
+/**
+ * Allocator that places every allocation at a multiple of Alignment bytes, so that arrays start on a cache line
+ * and can be streamed over with aligned vector loads.
+ */
+template<typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(const size_t numberOfElements) {
+        return static_cast<T *>(::operator new(numberOfElements * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *elements, size_t) {
+        ::operator delete(elements, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+/**
+ * std::vector whose elements start at a 64 byte boundary.
+ */
+template<typename T>
+using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * Read-only contiguous array used for the large arrays of a Corpus. The elements either live in an aligned_vector
+ * owned by the array, or in memory that belongs to someone else (e.g. a memory-mapped corpus file). In the second case the
+ * array keeps a reference to the owner so that the memory stays valid for as long as any copy of the array exists,
+ * and copying the array does not copy the elements.
+ * Arrays are filled by assigning an aligned_vector (or a std::vector, which is copied); there is no element-wise
+ * write access.
+ */
+template<typename T>
+class CorpusArray {
+private:
+    aligned_vector<T> owned;
+    const T *elements = nullptr;
+    size_t numberOfElements = 0;
+    std::shared_ptr<const void> externalOwner;
+
+    void pointToOwned() {
+        elements = owned.data();
+        numberOfElements = owned.size();
+    }
+
+public:
+    typedef T value_type;
+    typedef const T *const_iterator;
+
+    CorpusArray() = default;
+
+    CorpusArray(aligned_vector<T> values) : owned(std::move(values)) { pointToOwned(); }
+
+    CorpusArray(const std::vector<T> &values) : owned(values.begin(), values.end()) { pointToOwned(); }
+
+    CorpusArray(std::initializer_list<T> values) : owned(values) { pointToOwned(); }
+
+    /**
+     * Creates an array over memory owned by externalOwner. No elements are copied.
+     * @param elements first element
+     * @param numberOfElements number of elements
+     * @param externalOwner keeps the memory alive, e.g. a handle to a memory-mapped file
+     */
+    CorpusArray(const T *elements, const size_t numberOfElements, std::shared_ptr<const void> externalOwner)
+            : elements(elements), numberOfElements(numberOfElements), externalOwner(std::move(externalOwner)) {}
+
+    CorpusArray(const CorpusArray &other) { *this = other; }
+
+    CorpusArray(CorpusArray &&other) noexcept { *this = std::move(other); }
+
+    CorpusArray &operator=(const CorpusArray &other) {
+        if (this != &other) {
+            owned = other.owned;
+            externalOwner = other.externalOwner;
+            if (externalOwner) {
+                elements = other.elements;
+                numberOfElements = other.numberOfElements;
+            } else {
+                pointToOwned();
+            }
+        }
+        return *this;
+    }
+
+    CorpusArray &operator=(CorpusArray &&other) noexcept {
+        if (this != &other) {
+            owned = std::move(other.owned);
+            externalOwner = std::move(other.externalOwner);
+            if (externalOwner) {
+                elements = other.elements;
+                numberOfElements = other.numberOfElements;
+            } else {
+                pointToOwned();
+            }
+            other.owned.clear();
+            other.externalOwner.reset();
+            other.pointToOwned();
+        }
+        return *this;
+    }
+
+    CorpusArray &operator=(aligned_vector<T> values) {
+        owned = std::move(values);
+        externalOwner.reset();
+        pointToOwned();
+        return *this;
+    }
+
+    CorpusArray &operator=(const std::vector<T> &values) {
+        return *this = aligned_vector<T>(values.begin(), values.end());
+    }
+
+    CorpusArray &operator=(std::initializer_list<T> values) {
+        return *this = aligned_vector<T>(values);
+    }
+
+    const T &operator[](const size_t position) const { return elements[position]; }
+
+    const T *data() const { return elements; }
+
+    size_t size() const { return numberOfElements; }
+
+    bool empty() const { return numberOfElements == 0; }
+
+    const T *begin() const { return elements; }
+
+    const T *end() const { return elements + numberOfElements; }
+
+    const T &back() const { return elements[numberOfElements - 1]; }
+
+    /**
+     * Returns whether the elements live outside of this array (e.g. in a memory-mapped file).
+     */
+    bool isExternal() const { return externalOwner != nullptr; }
+
+    bool operator==(const CorpusArray &other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    bool operator!=(const CorpusArray &other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * Serializes the array in the same format as a std::vector.
+     */
+    template<class Archive>
+    void save(Archive &ar) const {
+        const std::vector<T> values(begin(), end());
+        ar(values);
+    }
+
+    /**
+     * Deserializes an array written as a std::vector.
+     */
+    template<class Archive>
+    void load(Archive &ar) {
+        aligned_vector<T> values;
+        ar(values);
+        *this = std::move(values);
+    }
+};
+
+#endif //BROWN_CORPUSARRAY_H
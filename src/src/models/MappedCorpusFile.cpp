@@ -0,0 +1,206 @@
+#include "MappedCorpusFile.h"
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(BigramEntry) == 2 * sizeof(word_type), "BigramEntry must not contain padding");
+static_assert(std::is_trivially_copyable<BigramEntry>::value, "BigramEntry must be trivially copyable");
+
+namespace {
+    /**
+     * Appends a plain array as a section, padding the file so that the section starts at an aligned offset.
+     */
+    template<typename T>
+    void writeSection(ofstream &output, MappedCorpusFile::MappedCorpusHeader &header,
+                      const MappedCorpusFile::Section section, const T *data, const size_t numberOfElements) {
+        static_assert(std::is_trivially_copyable<T>::value, "Sections can only hold trivially copyable types");
+        const uint64_t position = output.tellp();
+        const uint64_t offset = (position + MappedCorpusFile::alignment - 1) / MappedCorpusFile::alignment *
+                                MappedCorpusFile::alignment;
+        const string padding(offset - position, '\0');
+        output.write(padding.data(), padding.size());
+        const uint64_t size = numberOfElements * sizeof(T);
+        output.write(reinterpret_cast<const char *>(data), size);
+        header.sections[section] = {offset, size};
+    }
+
+    /**
+     * Returns a section of a mapped file as an array that keeps the mapping alive.
+     */
+    template<typename T>
+    CorpusArray<T> mapSection(const shared_ptr<const void> &mapping, const uint64_t fileSize,
+                              const MappedCorpusFile::MappedCorpusHeader &header,
+                              const MappedCorpusFile::Section section, const string &fileName) {
+        const MappedCorpusFile::SectionLocation &location = header.sections[section];
+        if (location.offset % MappedCorpusFile::alignment != 0 || location.size % sizeof(T) != 0 ||
+            location.offset > fileSize || location.size > fileSize - location.offset) {
+            throw runtime_error("File " + fileName + " has a corrupt section " + to_string(section));
+        }
+        const T *first = reinterpret_cast<const T *>(static_cast<const char *>(mapping.get()) + location.offset);
+        return CorpusArray<T>(first, location.size / sizeof(T), mapping);
+    }
+
+    /**
+     * Maps a bigram matrix with one row per word of the vocabulary. Rejects offsets that do not describe rows of the
+     * entries and neighbours outside of the vocabulary, since rows are accessed without bounds checks.
+     */
+    BigramMatrix mapMatrix(const shared_ptr<const void> &mapping, const uint64_t fileSize,
+                           const MappedCorpusFile::MappedCorpusHeader &header,
+                           const MappedCorpusFile::Section rowOffsetsSection,
+                           const MappedCorpusFile::Section entriesSection, const word_type vocabularySize,
+                           const string &fileName) {
+        BigramMatrix matrix;
+        matrix.rowOffsets = mapSection<uint64_t>(mapping, fileSize, header, rowOffsetsSection, fileName);
+        matrix.entries = mapSection<BigramEntry>(mapping, fileSize, header, entriesSection, fileName);
+        const CorpusArray<uint64_t> &rowOffsets = matrix.rowOffsets;
+        if (rowOffsets.size() != (uint64_t) vocabularySize + 1 || rowOffsets[0] != 0 ||
+            rowOffsets.back() != matrix.entries.size() || !std::is_sorted(rowOffsets.begin(), rowOffsets.end())) {
+            throw runtime_error("File " + fileName + " has inconsistent bigram sections");
+        }
+        if (std::any_of(matrix.entries.begin(), matrix.entries.end(), [vocabularySize](const BigramEntry &entry) {
+            return entry.neighbour >= vocabularySize;
+        })) {
+            throw runtime_error("File " + fileName + " has bigrams with words outside of the vocabulary");
+        }
+        return matrix;
+    }
+}
+
+void MappedCorpusFile::write(const Corpus &corpus, const string &fileName) {
+    ofstream output(fileName, std::ios::binary);
+    if (!output.is_open()) {
+        throw runtime_error("File " + fileName + " could not be opened");
+    }
+    MappedCorpusHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = corpus.symmetric ? version : versionWithoutSymmetry;
+    header.endiannessMarker = endiannessMarker;
+    header.vocabularySize = corpus.vocabularySize;
+    header.corpusLength = corpus.corpusLength;
+//    the header is written again once the locations of all sections are known
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    writeSection(output, header, PROBABILITIES_LEFT, corpus.pl.data(), corpus.pl.size());
+    writeSection(output, header, PROBABILITIES_RIGHT, corpus.pr.data(), corpus.pr.size());
+    writeSection(output, header, OCCURRENCES_ROW_OFFSETS, corpus.occurrences.rowOffsets.data(),
+                 corpus.occurrences.rowOffsets.size());
+    writeSection(output, header, OCCURRENCES_ENTRIES, corpus.occurrences.entries.data(),
+                 corpus.occurrences.entries.size());
+    const BigramMatrix &transposed = corpus.occurrencesTransposed;
+    writeSection(output, header, OCCURRENCES_TRANSPOSED_ROW_OFFSETS, transposed.rowOffsets.data(),
+                 corpus.symmetric ? 0 : transposed.rowOffsets.size());
+    writeSection(output, header, OCCURRENCES_TRANSPOSED_ENTRIES, transposed.entries.data(),
+                 corpus.symmetric ? 0 : transposed.entries.size());
+
+    writeSection(output, header, WORD_COUNTS, corpus.wordCounts.data(), corpus.wordCounts.size());
+
+    writeSection(output, header, VOCABULARY_OFFSETS, corpus.vocabulary.offsets.data(),
+                 corpus.vocabulary.offsets.size());
+    writeSection(output, header, VOCABULARY_CHARACTERS, corpus.vocabulary.characters.data(),
+                 corpus.vocabulary.characters.size());
+    writeSection(output, header, FIRST_POSITIONS, corpus.firstPositions.data(), corpus.firstPositions.size());
+
+    output.seekp(0);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.close();
+    if (!output) {
+        throw runtime_error("File " + fileName + " could not be written");
+    }
+}
+
+Corpus MappedCorpusFile::read(const string &fileName) {
+    const int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        throw runtime_error("File " + fileName + " could not be opened");
+    }
+    struct stat fileStatus{};
+    const uint64_t headerSizeVersion1 = offsetof(MappedCorpusHeader, sections) +
+                                        FIRST_POSITIONS * sizeof(SectionLocation);
+    if (fstat(fileDescriptor, &fileStatus) != 0 || (uint64_t) fileStatus.st_size < headerSizeVersion1) {
+        close(fileDescriptor);
+        throw runtime_error("File " + fileName + " is too short to be a mapped corpus");
+    }
+    const uint64_t fileSize = fileStatus.st_size;
+    void *address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+//    the mapping stays valid after the descriptor is closed
+    close(fileDescriptor);
+    if (address == MAP_FAILED) {
+        throw runtime_error("File " + fileName + " could not be mapped into memory");
+    }
+    const shared_ptr<const void> mapping(address, [fileSize](const void *mappedAddress) {
+        munmap(const_cast<void *>(mappedAddress), fileSize);
+    });
+
+//    sections missing from older versions keep an empty location
+    MappedCorpusHeader header{};
+    std::memcpy(&header, mapping.get(), offsetof(MappedCorpusHeader, sections));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw runtime_error("File " + fileName + " is not a mapped corpus");
+    }
+    if (header.endiannessMarker != endiannessMarker) {
+        throw runtime_error("File " + fileName + " was written on a machine with a different byte order");
+    }
+    if (header.version < 1 || header.version > version) {
+        throw runtime_error("File " + fileName + " has unsupported version " + to_string(header.version));
+    }
+    const size_t numberOfSections = header.version == 1 ? FIRST_POSITIONS : NUMBER_OF_SECTIONS;
+    if (fileSize < offsetof(MappedCorpusHeader, sections) + numberOfSections * sizeof(SectionLocation)) {
+        throw runtime_error("File " + fileName + " is too short to be a mapped corpus");
+    }
+    std::memcpy(header.sections, static_cast<const char *>(mapping.get()) + offsetof(MappedCorpusHeader, sections),
+                numberOfSections * sizeof(SectionLocation));
+
+    Corpus corpus;
+    corpus.vocabularySize = header.vocabularySize;
+    corpus.corpusLength = header.corpusLength;
+    corpus.pl = mapSection<double>(mapping, fileSize, header, PROBABILITIES_LEFT, fileName);
+    corpus.pr = mapSection<double>(mapping, fileSize, header, PROBABILITIES_RIGHT, fileName);
+    if (corpus.pl.size() != corpus.vocabularySize || corpus.pr.size() != corpus.vocabularySize) {
+        throw runtime_error("File " + fileName + " has probabilities that do not match the vocabulary size");
+    }
+    corpus.occurrences = mapMatrix(mapping, fileSize, header, OCCURRENCES_ROW_OFFSETS, OCCURRENCES_ENTRIES,
+                                   corpus.vocabularySize, fileName);
+    corpus.symmetric = header.version >= 3 && header.sections[OCCURRENCES_TRANSPOSED_ROW_OFFSETS].size == 0;
+//    the rows of a symmetric corpus are read as its columns, as checked by Corpus::setOccurrences for other files
+    if (corpus.symmetric && !corpus.occurrences.isSymmetric()) {
+        throw runtime_error("File " + fileName + " has bigram counts of a symmetric corpus that are not symmetric");
+    }
+    if (!corpus.symmetric) {
+        corpus.occurrencesTransposed = mapMatrix(mapping, fileSize, header, OCCURRENCES_TRANSPOSED_ROW_OFFSETS,
+                                                 OCCURRENCES_TRANSPOSED_ENTRIES, corpus.vocabularySize, fileName);
+    }
+
+    corpus.wordCounts = mapSection<word_type>(mapping, fileSize, header, WORD_COUNTS, fileName);
+    corpus.firstPositions = mapSection<word_type>(mapping, fileSize, header, FIRST_POSITIONS, fileName);
+    if ((!corpus.wordCounts.empty() && corpus.wordCounts.size() != corpus.vocabularySize) ||
+        (!corpus.firstPositions.empty() && corpus.firstPositions.size() != corpus.vocabularySize)) {
+        throw runtime_error("File " + fileName + " has word statistics that do not match the vocabulary size");
+    }
+
+    const CorpusArray<uint64_t> vocabularyOffsets = mapSection<uint64_t>(mapping, fileSize, header,
+                                                                         VOCABULARY_OFFSETS, fileName);
+    if (!vocabularyOffsets.empty()) {
+        corpus.vocabulary.offsets = vocabularyOffsets;
+        corpus.vocabulary.characters = mapSection<char>(mapping, fileSize, header, VOCABULARY_CHARACTERS, fileName);
+        if (vocabularyOffsets[0] != 0 || vocabularyOffsets.back() != corpus.vocabulary.characters.size() ||
+            !std::is_sorted(vocabularyOffsets.begin(), vocabularyOffsets.end())) {
+            throw runtime_error("File " + fileName + " has an inconsistent vocabulary");
+        }
+    }
+    return corpus;
+}
+
+bool MappedCorpusFile::isMappedCorpusFile(const string &fileName) {
+    ifstream input(fileName, std::ios::binary);
+    char firstBytes[sizeof(magic)];
+    if (!input.read(firstBytes, sizeof(firstBytes))) {
+        return false;
+    }
+    return std::memcmp(firstBytes, magic, sizeof(magic)) == 0;
+}
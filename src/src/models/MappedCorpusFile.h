@@ -0,0 +1,93 @@
+#ifndef BROWN_MAPPEDCORPUSFILE_H
+#define BROWN_MAPPEDCORPUSFILE_H
+
+#include "Corpus.h"
+#include <cstdint>
+
+/**
+ * Reads and writes corpora in the memory-mapped corpus format.
+ *
+ * The file starts with a MappedCorpusHeader followed by a number of sections. Every section is a plain array in
+ * native byte order and starts at a multiple of MappedCorpusFile::alignment bytes, so that a corpus can be mmap-ed
+ * and its arrays used in place without parsing individual elements. See Documentation.md for the exact layout.
+ *
+ * Files written by Corpus::serializeToFile (cereal) are the legacy format; Corpus::deserializeFromFile accepts both.
+ */
+class MappedCorpusFile {
+public:
+    /**
+     * Sections of a mapped corpus file, in the order in which they are stored.
+     */
+    enum Section : uint32_t {
+        PROBABILITIES_LEFT = 0,
+        PROBABILITIES_RIGHT,
+        OCCURRENCES_ROW_OFFSETS,
+        OCCURRENCES_ENTRIES,
+        OCCURRENCES_TRANSPOSED_ROW_OFFSETS,
+        OCCURRENCES_TRANSPOSED_ENTRIES,
+        WORD_COUNTS,
+        VOCABULARY_OFFSETS,
+        VOCABULARY_CHARACTERS,
+        FIRST_POSITIONS,
+        NUMBER_OF_SECTIONS
+    };
+
+    /**
+     * Location of one section, in bytes from the start of the file.
+     */
+    struct SectionLocation {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    /**
+     * Fixed-size header at the start of every mapped corpus file.
+     */
+    struct MappedCorpusHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t endiannessMarker;
+        uint64_t vocabularySize;
+        uint64_t corpusLength;
+        SectionLocation sections[NUMBER_OF_SECTIONS];
+    };
+
+    static constexpr char magic[8] = {'B', 'R', 'O', 'W', 'N', 'C', 'R', 'P'};
+    /**
+     * Version 2 added the FIRST_POSITIONS section. Version 1 files are still read; their header is shorter by one
+     * section location. Version 3 files hold a symmetric corpus (see Corpus::symmetric), whose transposed sections
+     * are left empty; all other corpora are still written as version 2, so that older builds can read them.
+     */
+    static const uint32_t version = 3;
+    static const uint32_t versionWithoutSymmetry = 2;
+    /**
+     * Written in native byte order. Reads back differently on a machine with another endianness.
+     */
+    static const uint32_t endiannessMarker = 0x01020304;
+    /**
+     * Every section starts at a multiple of this many bytes.
+     */
+    static const uint64_t alignment = 64;
+
+    /**
+     * Writes a corpus in the mapped format.
+     * @param corpus corpus to write
+     * @param fileName path to file
+     */
+    static void write(const Corpus &corpus, const string &fileName);
+
+    /**
+     * Maps a corpus file into memory. The arrays of the returned corpus point into the mapping, which stays alive
+     * for as long as any of them (or a copy of them) exists.
+     * @param fileName path to a file written by MappedCorpusFile::write
+     * @return corpus backed by the file
+     */
+    static Corpus read(const string &fileName);
+
+    /**
+     * Returns whether a file starts with the magic bytes of the mapped format.
+     */
+    static bool isMappedCorpusFile(const string &fileName);
+};
+
+#endif //BROWN_MAPPEDCORPUSFILE_H
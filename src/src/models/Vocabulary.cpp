@@ -0,0 +1,18 @@
+#include "Vocabulary.h"
+
+Vocabulary Vocabulary::Builder::build() {
+    Vocabulary vocabulary;
+    vocabulary.offsets = std::move(offsets);
+    vocabulary.characters = std::move(characters);
+    offsets = aligned_vector<uint64_t>(1, 0);
+    characters = aligned_vector<char>();
+    return vocabulary;
+}
+
+Vocabulary::Vocabulary(std::initializer_list<string> words) {
+    Builder builder;
+    for (const string &word : words) {
+        builder.add(word);
+    }
+    *this = builder.build();
+}
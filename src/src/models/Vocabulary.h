@@ -0,0 +1,135 @@
+#ifndef BROWN_VOCABULARY_H
+#define BROWN_VOCABULARY_H
+
+#include "../Utils.h"
+#include "CorpusArray.h"
+#include <cstdint>
+#include <string_view>
+#include <stdexcept>
+#include <cereal/cereal.hpp>
+#include <cereal/types/string.hpp>
+
+/**
+ * Mapping between dense word IDs and their strings.
+ * All words are stored back to back in a single character arena; word i spans [offsets[i], offsets[i + 1]).
+ * Looking up a word is two array reads and returns a string_view into the arena, without hashing or copying.
+ */
+class Vocabulary {
+public:
+    /**
+     * Appends words one at a time and turns them into a Vocabulary. The ID of a word is the order in which it
+     * was added.
+     */
+    class Builder {
+    private:
+        aligned_vector<char> characters;
+        aligned_vector<uint64_t> offsets = aligned_vector<uint64_t>(1, 0);
+    public:
+        /**
+         * Adds a word and returns its ID.
+         */
+        word_type add(const std::string_view word) {
+            characters.insert(characters.end(), word.begin(), word.end());
+            offsets.push_back(characters.size());
+            return offsets.size() - 2;
+        }
+
+        word_type size() const {
+            return offsets.size() - 1;
+        }
+
+        /**
+         * Builds the vocabulary. The builder is left empty.
+         */
+        Vocabulary build();
+    };
+
+    Vocabulary() : offsets(aligned_vector<uint64_t>(1, 0)) {};
+
+    /**
+     * Creates a vocabulary where the word with ID i is words[i].
+     */
+    Vocabulary(std::initializer_list<string> words);
+
+    /**
+     * Number of words.
+     */
+    word_type size() const {
+        return offsets.size() - 1;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Returns the word with the given ID without bounds checking.
+     */
+    std::string_view operator[](const word_type wordID) const {
+        return std::string_view(characters.data() + offsets[wordID], offsets[wordID + 1] - offsets[wordID]);
+    }
+
+    /**
+     * Returns the word with the given ID.
+     * @throws out_of_range if there is no word with that ID
+     */
+    std::string_view at(const word_type wordID) const {
+        if (wordID >= size()) {
+            throw std::out_of_range("Word ID " + to_string(wordID) + " is not in the vocabulary");
+        }
+        return (*this)[wordID];
+    }
+
+    bool operator==(const Vocabulary &other) const {
+        return offsets == other.offsets && characters == other.characters;
+    }
+
+    /**
+     * Writes the vocabulary with the same layout cereal uses for an unordered_map<word_type, string>, so that
+     * corpus files stay readable by older builds.
+     */
+    template<class Archive>
+    void saveAsMap(Archive &ar) const {
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(size())));
+        for (word_type wordID = 0; wordID < size(); ++wordID) {
+            string word((*this)[wordID]);
+            ar(cereal::make_map_item(wordID, word));
+        }
+    }
+
+    /**
+     * Reads a vocabulary written by saveAsMap (or a serialized unordered_map<word_type, string>). The map may list
+     * IDs in any order; IDs missing from the map become empty words.
+     */
+    template<class Archive>
+    void loadFromMap(Archive &ar) {
+        cereal::size_type numberOfWords;
+        ar(cereal::make_size_tag(numberOfWords));
+        vector<string> words(numberOfWords);
+        for (cereal::size_type i = 0; i < numberOfWords; ++i) {
+            word_type wordID;
+            string word;
+            ar(cereal::make_map_item(wordID, word));
+            if (wordID >= words.size()) {
+                words.resize(wordID + 1);
+            }
+            words[wordID] = std::move(word);
+        }
+        Builder builder;
+        for (const string &word : words) {
+            builder.add(word);
+        }
+        *this = builder.build();
+    }
+
+    /**
+     * Start of every word in characters. Has size() + 1 elements.
+     */
+    CorpusArray<uint64_t> offsets;
+    /**
+     * All words, one after the other and without separators.
+     */
+    CorpusArray<char> characters;
+};
+
+#endif //BROWN_VOCABULARY_H
@@ -8,7 +8,7 @@ public:
     /**
      * Reads the corpus and provides a model of the corpus.
      */
-    virtual const Corpus reorderCorpus(Corpus corpus) = 0;
+    virtual Corpus reorderCorpus(const Corpus &corpus) = 0;
 };
 
 #endif //BROWN_ABSTRACTREADER_H
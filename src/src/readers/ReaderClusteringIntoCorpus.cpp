@@ -15,20 +15,16 @@ Corpus ReaderClusteringIntoCorpus::readFile(const std::string &fileNameCorpus, c
     clusteredCorpus.pl = vector<double>(numberOfClusters, 0);
     clusteredCorpus.pr = vector<double>(numberOfClusters, 0);
 
-    for (const auto &elem : corpus.occurrences) {
-                const word_type wordID1 = elem.first.first;
-        const word_type wordID2 = elem.first.second;
-        const word_type occ = elem.second;
+    vector<bigram_count_type> clusterBigrams;
+    clusterBigrams.reserve(corpus.occurrences.getNumberOfEntries());
+    corpus.occurrences.forEach([&](const word_type wordID1, const word_type wordID2, const word_type occ) {
         const word_type clusterID1 = clusterAssignments[wordID1];
         const word_type clusterID2 = clusterAssignments[wordID2];
-        const pair<word_type, word_type> key = make_pair(clusterID1, clusterID2);
-        auto it = clusteredCorpus.occurrences.find(key);
-        if (it == clusteredCorpus.occurrences.end()) {
-            clusteredCorpus.occurrences.insert({key, occ});
-        } else {
-            it->second += occ;
-        }
-    }
+        clusterBigrams.push_back({{clusterID1, clusterID2}, occ});
+    });
+//    fromBigrams sums the counts of bigrams that end up between the same two clusters
+    clusteredCorpus.setOccurrences(BigramMatrix::fromBigrams(numberOfClusters, std::move(clusterBigrams)),
+                                   corpus.symmetric);
     return clusteredCorpus;
 }
 
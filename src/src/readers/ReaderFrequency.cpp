@@ -5,12 +5,15 @@
 
 using namespace std;
 
-const Corpus ReaderFrequency::reorderCorpus(const Corpus corpus) {
+Corpus ReaderFrequency::reorderCorpus(const Corpus &corpus) {
     Corpus orderedCorpus;
     orderedCorpus.corpusLength = corpus.corpusLength;
     orderedCorpus.vocabularySize = corpus.vocabularySize;
-    orderedCorpus.pl = vector<double>(corpus.vocabularySize);
-    orderedCorpus.pr = vector<double>(corpus.vocabularySize);
+    aligned_vector<double> pl(corpus.vocabularySize);
+    aligned_vector<double> pr(corpus.vocabularySize);
+    aligned_vector<word_type> wordCounts(corpus.wordCounts.empty() ? 0 : corpus.vocabularySize);
+    aligned_vector<word_type> firstPositions(corpus.firstPositions.empty() ? 0 : corpus.vocabularySize);
+    Vocabulary::Builder vocabulary;
 
     std::vector<pair<word_type, word_type>> wordsWithOccurrences;
     wordsWithOccurrences.reserve(corpus.vocabularySize);
@@ -26,19 +29,31 @@ const Corpus ReaderFrequency::reorderCorpus(const Corpus corpus) {
         const word_type oldWordIndex = wordsWithOccurrences[i].first;
         const auto wordOptional = corpus.getWord(oldWordIndex);
         if (wordOptional) {
-            const string word = wordOptional.value();
             oldIdsToNewIds.insert({oldWordIndex, i});
-            orderedCorpus.idsToWords.insert({i, word});
-            orderedCorpus.wordCountAsNumbers.insert({i, wordsWithOccurrences[i].second});
-            orderedCorpus.pl[i] = corpus.pl[oldWordIndex];
-            orderedCorpus.pr[i] = corpus.pr[oldWordIndex];
+            vocabulary.add(wordOptional.value());
+            pl[i] = corpus.pl[oldWordIndex];
+            pr[i] = corpus.pr[oldWordIndex];
+            if (!wordCounts.empty()) {
+                wordCounts[i] = corpus.wordCounts[oldWordIndex];
+            }
+            if (!firstPositions.empty()) {
+                firstPositions[i] = corpus.firstPositions[oldWordIndex];
+            }
         }
     }
-    for (const auto &occurrence : corpus.occurrences) {
-        const word_type value = occurrence.second;
-        const word_type newFirst = oldIdsToNewIds.at(occurrence.first.first);
-        const word_type newSecond = oldIdsToNewIds.at(occurrence.first.second);
-        orderedCorpus.occurrences[{newFirst, newSecond}] = value;
-    }
+    orderedCorpus.vocabulary = vocabulary.build();
+    orderedCorpus.pl = std::move(pl);
+    orderedCorpus.pr = std::move(pr);
+    orderedCorpus.wordCounts = std::move(wordCounts);
+    orderedCorpus.firstPositions = std::move(firstPositions);
+    vector<bigram_count_type> reorderedBigrams;
+    reorderedBigrams.reserve(corpus.occurrences.getNumberOfEntries());
+    corpus.occurrences.forEach([&](const word_type first, const word_type second, const word_type value) {
+        const word_type newFirst = oldIdsToNewIds.at(first);
+        const word_type newSecond = oldIdsToNewIds.at(second);
+        reorderedBigrams.push_back({{newFirst, newSecond}, value});
+    });
+    orderedCorpus.setOccurrences(BigramMatrix::fromBigrams(orderedCorpus.vocabularySize, std::move(reorderedBigrams)),
+                                 corpus.symmetric);
     return orderedCorpus;
 }
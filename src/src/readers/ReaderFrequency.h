@@ -10,7 +10,7 @@ public:
     /**
      * Takes in a corpus model and reorders it so that all word are sorted descending based on their frequency.
      */
-    const Corpus reorderCorpus(Corpus corpus) override;
+    Corpus reorderCorpus(const Corpus &corpus) override;
 
 };
 
@@ -17,6 +17,12 @@ Corpus ReaderNoOrder::readFile(const std::string fileName) {
     word_type previousId = 0;
 
     unordered_map<string, word_type> wordsToIds;
+    BigramMatrix::Builder occurrences;
+    aligned_vector<double> pl;
+    aligned_vector<double> pr;
+    aligned_vector<word_type> wordCounts;
+    aligned_vector<word_type> firstPositions;
+    Vocabulary::Builder vocabulary;
 //    count frequency of all words and measure vocabulary and corpus size
     while (file >> word) {
         word_type currentId = 0;
@@ -24,35 +30,37 @@ Corpus ReaderNoOrder::readFile(const std::string fileName) {
         if (iteratorID == wordsToIds.end()) {
             currentId = corpus.vocabularySize;
             wordsToIds.insert({word, currentId});
-            corpus.idsToWords.insert({currentId, word});
+            vocabulary.add(word);
             ++corpus.vocabularySize;
-            corpus.pl.push_back(0);
-            corpus.pr.push_back(0);
-            corpus.wordCountAsNumbers.insert({currentId, 0});
+            pl.push_back(0);
+            pr.push_back(0);
+            wordCounts.push_back(0);
+            firstPositions.push_back(corpus.corpusLength);
         } else {
             currentId = iteratorID->second;
         }
         ++corpus.corpusLength;
         if (previousIdWasSetUp) {
-            ++corpus.pl[previousId];
-            ++corpus.pr[currentId];
-            const occurrence_type::key_type key = {previousId, currentId};
-            if (corpus.occurrences.find(key) != corpus.occurrences.end()) {
-                ++corpus.occurrences[key];
-            } else {
-                corpus.occurrences.emplace(key, 1);
-            }
+            ++pl[previousId];
+            ++pr[currentId];
+            occurrences.add(previousId, currentId);
         } else {
             previousIdWasSetUp = true;
         }
         previousId = currentId;
-        corpus.wordCountAsNumbers[currentId] += 1;
+        ++wordCounts[currentId];
     }
+    corpus.setOccurrences(occurrences.build(corpus.vocabularySize));
     #pragma omp parallel for simd
     for (auto i = 0; i < corpus.vocabularySize; ++i) {
-        corpus.pl[i] = corpus.pl[i] / ( corpus.corpusLength - 1 );
-        corpus.pr[i] = corpus.pr[i] / ( corpus.corpusLength - 1 );
+        pl[i] = pl[i] / ( corpus.corpusLength - 1 );
+        pr[i] = pr[i] / ( corpus.corpusLength - 1 );
     }
+    corpus.vocabulary = vocabulary.build();
+    corpus.pl = std::move(pl);
+    corpus.pr = std::move(pr);
+    corpus.wordCounts = std::move(wordCounts);
+    corpus.firstPositions = std::move(firstPositions);
     file.close();
     return corpus;
 }
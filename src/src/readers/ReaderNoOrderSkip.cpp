@@ -18,6 +18,13 @@ Corpus ReaderNoOrderSkip::readFile(const std::string fileName, const uint32_t ma
     vector<word_type> previousId(maxSkipGramWidth, 0);
 
     unordered_map<string, word_type> wordsToIds;
+    BigramMatrix::Builder occurrences;
+    aligned_vector<double> pl;
+    aligned_vector<double> pr;
+    aligned_vector<word_type> wordCounts;
+    aligned_vector<word_type> firstPositions;
+    Vocabulary::Builder words;
+    word_type position = 0;
 //    count frequency of all words and measure vocabulary and corpus size
     while (file >> word) {
         word_type currentId = 0;
@@ -25,33 +32,26 @@ Corpus ReaderNoOrderSkip::readFile(const std::string fileName, const uint32_t ma
         if (iteratorID == wordsToIds.end()) {
             currentId = corpus.vocabularySize;
             wordsToIds.insert({word, currentId});
-            corpus.idsToWords.insert({currentId, word});
+            words.add(word);
             ++corpus.vocabularySize;
-            corpus.pl.push_back(0);
-            corpus.pr.push_back(0);
+            pl.push_back(0);
+            pr.push_back(0);
+            wordCounts.push_back(0);
+            firstPositions.push_back(position);
         } else {
             currentId = iteratorID->second;
         }
+        ++wordCounts[currentId];
         for (int i = maxSkipGramWidth - 1; i >= 0; --i) {
             if (previousIdWasSetUp[i] == true) {
                 ++corpus.corpusLength;
-                ++corpus.pl[previousId[i]];
-                ++corpus.pr[currentId];
-                const occurrence_type::key_type key = {previousId[i], currentId};
-                if (corpus.occurrences.find(key) != corpus.occurrences.end()) {
-                    ++corpus.occurrences[key];
-                } else {
-                    corpus.occurrences.emplace(key, 1);
-                }
+                ++pl[previousId[i]];
+                ++pr[currentId];
+                occurrences.add(previousId[i], currentId);
                 ++corpus.corpusLength;
-                ++corpus.pl[currentId];
-                ++corpus.pr[previousId[i]];
-                const occurrence_type::key_type key2 = {currentId, previousId[i]};
-                if (corpus.occurrences.find(key2) != corpus.occurrences.end()) {
-                    ++corpus.occurrences[key2];
-                } else {
-                    corpus.occurrences.emplace(key2, 1);
-                }
+                ++pl[currentId];
+                ++pr[previousId[i]];
+                occurrences.add(currentId, previousId[i]);
             } else {
                 break;
             }
@@ -63,9 +63,15 @@ Corpus ReaderNoOrderSkip::readFile(const std::string fileName, const uint32_t ma
         }
         previousId[maxSkipGramWidth - 1] = currentId;
         previousIdWasSetUp[maxSkipGramWidth - 1] = true;
-
+        ++position;
     }
     file.close();
+    corpus.vocabulary = words.build();
+    corpus.pl = std::move(pl);
+    corpus.pr = std::move(pr);
+    corpus.wordCounts = std::move(wordCounts);
+    corpus.firstPositions = std::move(firstPositions);
+    corpus.setOccurrences(occurrences.build(corpus.vocabularySize), true);
     return corpus;
 }
 
@@ -87,6 +93,13 @@ Corpus ReaderNoOrderSkip::readFile(const std::string &fileNameCorpus,
     vector<bool> previousIdIsUsable(maxSkipGramWidth, 0);
 
     unordered_map<string, word_type> wordsToIds;
+    BigramMatrix::Builder occurrences;
+    aligned_vector<double> pl;
+    aligned_vector<double> pr;
+    aligned_vector<word_type> wordCounts;
+    aligned_vector<word_type> firstPositions;
+    Vocabulary::Builder words;
+    word_type position = 0;
 //    count frequency of all words and measure vocabulary and corpus size
     while (file >> word) {
         word_type currentId = 0;
@@ -96,10 +109,12 @@ Corpus ReaderNoOrderSkip::readFile(const std::string &fileNameCorpus,
             if (currentWordIsInVocabulary) {
                 currentId = corpus.vocabularySize;
                 wordsToIds.insert({word, currentId});
-                corpus.idsToWords.insert({currentId, word});
+                words.add(word);
                 ++corpus.vocabularySize;
-                corpus.pl.push_back(0);
-                corpus.pr.push_back(0);
+                pl.push_back(0);
+                pr.push_back(0);
+                wordCounts.push_back(0);
+                firstPositions.push_back(position);
             } else {
 //                at this point currentID will stay 0
             }
@@ -107,29 +122,20 @@ Corpus ReaderNoOrderSkip::readFile(const std::string &fileNameCorpus,
             currentId = iteratorID->second;
         }
         if (currentWordIsInVocabulary) {
+            ++wordCounts[currentId];
 //        add skip-grams
             for (int i = maxSkipGramWidth - 1; i >= 0; --i) {
                 if (previousIdWasSetUp[i] == true) {
                     if (previousIdIsUsable[i]) {
 //                    incoming skip-grams (from a word that has already appeared within the window)
                         ++corpus.corpusLength;
-                        ++corpus.pl[previousId[i]];
-                        ++corpus.pr[currentId];
-                        const occurrence_type::key_type key = {previousId[i], currentId};
-                        if (corpus.occurrences.find(key) != corpus.occurrences.end()) {
-                            ++corpus.occurrences[key];
-                        } else {
-                            corpus.occurrences.emplace(key, 1);
-                        }
+                        ++pl[previousId[i]];
+                        ++pr[currentId];
+                        occurrences.add(previousId[i], currentId);
                         ++corpus.corpusLength;
-                        ++corpus.pl[currentId];
-                        ++corpus.pr[previousId[i]];
-                        const occurrence_type::key_type key2 = {currentId, previousId[i]};
-                        if (corpus.occurrences.find(key2) != corpus.occurrences.end()) {
-                            ++corpus.occurrences[key2];
-                        } else {
-                            corpus.occurrences.emplace(key2, 1);
-                        }
+                        ++pl[currentId];
+                        ++pr[previousId[i]];
+                        occurrences.add(currentId, previousId[i]);
                     }
                 } else {
                     break;
@@ -144,9 +150,15 @@ Corpus ReaderNoOrderSkip::readFile(const std::string &fileNameCorpus,
         previousId[maxSkipGramWidth - 1] = currentId;
         previousIdWasSetUp[maxSkipGramWidth - 1] = true;
         previousIdIsUsable[maxSkipGramWidth - 1] = currentWordIsInVocabulary;
-
+        ++position;
     }
     file.close();
+    corpus.vocabulary = words.build();
+    corpus.pl = std::move(pl);
+    corpus.pr = std::move(pr);
+    corpus.wordCounts = std::move(wordCounts);
+    corpus.firstPositions = std::move(firstPositions);
+    corpus.setOccurrences(occurrences.build(corpus.vocabularySize), true);
     return corpus;
 }
 
@@ -3,62 +3,79 @@
 
 using namespace std;
 
-const Corpus ReaderThreshold::reorderCorpus(const Corpus corpus) {
+Corpus ReaderThreshold::reorderCorpus(const Corpus &corpus) {
     return reorderCorpus(corpus, 10, true);
 }
 
-const Corpus ReaderThreshold::reorderCorpus(const Corpus &corpus, const word_type thresholdVal, const bool strict) {
+Corpus ReaderThreshold::reorderCorpus(const Corpus &corpus, const word_type thresholdVal, const bool strict) {
     Corpus orderedCorpus;
-    unordered_map<word_type, word_type> idMappings;
+//    new ID of every word, or removedWord if the word is filtered out
+    const word_type removedWord = std::numeric_limits<word_type>::max();
+    vector_word_type idMappings(corpus.vocabularySize, removedWord);
     word_type nextID = 0;
+    aligned_vector<double> pl;
+    aligned_vector<double> pr;
+    aligned_vector<word_type> wordCounts;
+    aligned_vector<word_type> firstPositions;
+    Vocabulary::Builder vocabulary;
     float thr = (float) thresholdVal / (float)corpus.corpusLength;
     for (word_type wordID = 0; wordID < corpus.vocabularySize; ++wordID) {
         if (corpus.pl[wordID] >= thr) {
             const word_type idForCurrentWord = nextID;
             nextID++;
-            idMappings.insert({wordID, idForCurrentWord});
+            idMappings[wordID] = idForCurrentWord;
             if (strict) {
-                orderedCorpus.pl.push_back(corpus.pl[wordID]);
-                orderedCorpus.pr.push_back(corpus.pr[wordID]);
+                pl.push_back(corpus.pl[wordID]);
+                pr.push_back(corpus.pr[wordID]);
+            }
+            if (!corpus.wordCounts.empty()) {
+                wordCounts.push_back(corpus.wordCounts[wordID]);
+            }
+            if (!corpus.firstPositions.empty()) {
+                firstPositions.push_back(corpus.firstPositions[wordID]);
             }
             const auto wordOptional = corpus.getWord(wordID);
             if (wordOptional) {
-                const string& word = wordOptional.value();
-                orderedCorpus.idsToWords.insert({idForCurrentWord, word});
+                vocabulary.add(wordOptional.value());
             }
         }
     }
     if (!strict) {
-        orderedCorpus.pl = vector<double>(idMappings.size(), 0);
-        orderedCorpus.pr = vector<double>(idMappings.size(), 0);
+        pl = aligned_vector<double>(nextID, 0);
+        pr = aligned_vector<double>(nextID, 0);
         orderedCorpus.corpusLength = 0;
     } else {
         orderedCorpus.corpusLength = corpus.corpusLength;
     }
 
-    orderedCorpus.vocabularySize = idMappings.size();
+    orderedCorpus.vocabularySize = nextID;
 
-    for (const auto elem : corpus.occurrences) {
-        const word_type &id1 = elem.first.first;
-        const word_type &id2 = elem.first.second;
-        const word_type &value = elem.second;
-        if (idMappings.find(id1) != idMappings.end() && idMappings.find(id2) != idMappings.end()) {
+    vector<bigram_count_type> filteredBigrams;
+    corpus.occurrences.forEach([&](const word_type id1, const word_type id2, const word_type value) {
+        if (idMappings[id1] != removedWord && idMappings[id2] != removedWord) {
             const word_type id1Mapped = idMappings[id1];
             const word_type id2Mapped = idMappings[id2];
-            orderedCorpus.occurrences.insert({{id1Mapped, id2Mapped}, value});
+            filteredBigrams.push_back({{id1Mapped, id2Mapped}, value});
             if (!strict) {
-                orderedCorpus.pl[id1Mapped] += value;
-                orderedCorpus.pr[id2Mapped] += value;
+                pl[id1Mapped] += value;
+                pr[id2Mapped] += value;
                 orderedCorpus.corpusLength += value;
             }
         }
-    }
+    });
+    orderedCorpus.setOccurrences(BigramMatrix::fromBigrams(orderedCorpus.vocabularySize, std::move(filteredBigrams)),
+                                 corpus.symmetric);
 //    Update pl and pr in case if not strict
     if (!strict) {
         for (word_type wordID = 0; wordID < orderedCorpus.vocabularySize; ++wordID) {
-            orderedCorpus.pl[wordID] /= orderedCorpus.corpusLength;
-            orderedCorpus.pr[wordID] /= orderedCorpus.corpusLength;
+            pl[wordID] /= orderedCorpus.corpusLength;
+            pr[wordID] /= orderedCorpus.corpusLength;
         }
     }
+    orderedCorpus.vocabulary = vocabulary.build();
+    orderedCorpus.pl = std::move(pl);
+    orderedCorpus.pr = std::move(pr);
+    orderedCorpus.wordCounts = std::move(wordCounts);
+    orderedCorpus.firstPositions = std::move(firstPositions);
     return orderedCorpus;
 }
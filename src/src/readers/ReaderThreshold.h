@@ -10,7 +10,7 @@ public:
     /**
      * Takes in a corpus model and removes all words that appear less than 10 times.
      */
-    const Corpus reorderCorpus(const Corpus corpus);
+    Corpus reorderCorpus(const Corpus &corpus) override;
 
     /**
      * Takes in a corpus model and removes all words that appear less than the threshold.
@@ -21,7 +21,7 @@ public:
      *      the new corpus length will be the same as the old corpus length. If not selected, the
      *      new corpus length will be the sum of all bi-grams that meet the threshold.
      */
-    const Corpus
+    Corpus
     reorderCorpus(const Corpus &corpus, const word_type thresholdVal, const bool strict);
 };
 
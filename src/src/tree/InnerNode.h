@@ -57,8 +57,8 @@ public:
         const word_type leftWordLabel = leftChild->getWordLabel();
         const word_type rightWordLabel = rightChild->getWordLabel();
 
-        stream << std::setprecision(10) << corpus.idsToWords.at(leftWordLabel) << "\t"
-               << corpus.idsToWords.at(rightWordLabel)
+        stream << std::setprecision(10) << corpus.vocabulary.at(leftWordLabel) << "\t"
+               << corpus.vocabulary.at(rightWordLabel)
                << "\t" << this->mergeID << "\t" << this->amiLoss << "\t" << this->amiAfterLoss << endl;
         this->leftChild->printMerges(stream, corpus);
         this->rightChild->printMerges(stream, corpus);
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <models/BigramMatrix.h>
+
+TEST(BigramMatrixTest, testFromBigramsSortsAndMergesDuplicates) {
+    vector<bigram_count_type> bigrams = {
+            {{2, 1}, 1},
+            {{0, 3}, 2},
+            {{0, 1}, 1},
+            {{2, 1}, 4},
+            {{0, 0}, 5},
+    };
+    const BigramMatrix matrix = BigramMatrix::fromBigrams(4, bigrams);
+
+    EXPECT_EQ(matrix.getNumberOfRows(), 4);
+    EXPECT_EQ(matrix.getNumberOfEntries(), 4);
+    const vector<uint64_t> expectedRowOffsets = {0, 3, 3, 4, 4};
+    EXPECT_THAT(vector<uint64_t>(matrix.rowOffsets.begin(), matrix.rowOffsets.end()),
+                ::testing::ContainerEq(expectedRowOffsets));
+    const vector<BigramEntry> expectedEntries = {{0, 5}, {1, 1}, {3, 2}, {1, 5}};
+    EXPECT_TRUE(vector<BigramEntry>(matrix.entries.begin(), matrix.entries.end()) == expectedEntries);
+}
+
+TEST(BigramMatrixTest, testGet) {
+    const BigramMatrix matrix = BigramMatrix::fromOccurrences(3, {{{0, 0}, 1},
+                                                                  {{0, 2}, 3},
+                                                                  {{2, 1}, 7}});
+    EXPECT_EQ(matrix.get(0, 0), 1);
+    EXPECT_EQ(matrix.get(0, 1), 0);
+    EXPECT_EQ(matrix.get(0, 2), 3);
+    EXPECT_EQ(matrix.get(1, 0), 0);
+    EXPECT_EQ(matrix.get(2, 1), 7);
+    EXPECT_EQ(matrix.get(666, 1), 0);
+    EXPECT_TRUE(matrix.row(666).empty());
+}
+
+TEST(BigramMatrixTest, testTranspose) {
+    const occurrence_type occurrences = {{{0, 0}, 1},
+                                         {{0, 2}, 3},
+                                         {{1, 2}, 4},
+                                         {{2, 1}, 7}};
+    const BigramMatrix transposed = BigramMatrix::fromOccurrences(3, occurrences).transpose(3);
+    const occurrence_type expectedTransposed = {{{0, 0}, 1},
+                                                {{2, 0}, 3},
+                                                {{2, 1}, 4},
+                                                {{1, 2}, 7}};
+    EXPECT_THAT(transposed.toOccurrences(), ::testing::ContainerEq(expectedTransposed));
+    const vector<BigramEntry> expectedColumn2 = {{0, 3}, {1, 4}};
+    const BigramMatrix::Row column2 = transposed.row(2);
+    EXPECT_TRUE(vector<BigramEntry>(column2.begin(), column2.end()) == expectedColumn2);
+}
+
+TEST(BigramMatrixTest, testBuilder) {
+    BigramMatrix::Builder builder;
+    builder.add(1, 0);
+    builder.add(0, 1);
+    builder.add(1, 0);
+    builder.add(0, 1, 3);
+    const BigramMatrix matrix = builder.build(3);
+    const occurrence_type expected = {{{0, 1}, 4},
+                                      {{1, 0}, 2}};
+    EXPECT_EQ(matrix.getNumberOfRows(), 3);
+    EXPECT_THAT(matrix.toOccurrences(), ::testing::ContainerEq(expected));
+}
@@ -2,6 +2,7 @@
 #include <gmock/gmock-matchers.h>
 #include "Utils.h"
 #include "BrownClusteringAlgorithm/BrownClusteringAlgorithm.h"
+#include "TestExchangeCorpus.h"
 #include <gmock/gmock.h>
 
 TEST(BrownClusteringAlgorithmTest, testSwapForVector) {
@@ -33,4 +34,11 @@ TEST(BrownClusteringAlgorithmTest, testComputeSk) {
     const vector<double> expectedSk = {69, 93, 117, 141, 165};
     BrownClusteringAlgorithm::computeSk(actualSk, q, 5);
     EXPECT_THAT(actualSk, ::testing::ContainerEq(expectedSk));
-}
\ No newline at end of file
+}
+
+TEST(BrownClusteringAlgorithmTest, testSymmetricCorpusGivesTheSameClustering) {
+    const pair<corpus_handle, corpus_handle> corpora = readSymmetricAndPlainCorpus();
+    BrownClusteringAlgorithm symmetricBrown(corpora.first);
+    BrownClusteringAlgorithm plainBrown(corpora.second);
+    EXPECT_EQ(plainBrown.cluster(10, 20), symmetricBrown.cluster(10, 20));
+}
@@ -1,20 +1,24 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <models/Corpus.h>
+#include <models/MappedCorpusFile.h>
 #include <Utils.h>
 #include <gmock/gmock.h>
+#include <fstream>
+#include <cstddef>
 
 TEST(CorpusTest, testrightiesandlefties) {
     Corpus testCorpus;
     const word_type vocabularySize = 3;
     testCorpus.vocabularySize = vocabularySize;
-//    testCorpus.occurrences = matrix_occurrences(5);
-    testCorpus.occurrences[{0, 0}] = 1;
-    testCorpus.occurrences[{0, 1}] = 1;
-    testCorpus.occurrences[{0, 2}] = 1;
+    occurrence_type occurrences;
+    occurrences[{0, 0}] = 1;
+    occurrences[{0, 1}] = 1;
+    occurrences[{0, 2}] = 1;
 
-    testCorpus.occurrences[{2, 0}] = 1;
-    testCorpus.occurrences[{2, 2}] = 1;
+    occurrences[{2, 0}] = 1;
+    occurrences[{2, 2}] = 1;
+    testCorpus.setOccurrences(occurrences);
 
     matrix_occurrences expectedToTheLeftOfWord = matrix_occurrences(3);
     expectedToTheLeftOfWord[0] = {0, 2};
@@ -45,19 +49,14 @@ Corpus createSimpleCorpus2() {
     abcdCorpus.corpusLength = 6;
     abcdCorpus.pl = {2.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0};
     abcdCorpus.pr = {1.0 / 5.0, 1.0 / 5.0, 2.0 / 5.0, 1.0 / 5.0};
-    abcdCorpus.idsToWords.insert({0, "a"});
-    abcdCorpus.idsToWords.insert({1, "b"});
-    abcdCorpus.idsToWords.insert({2, "c"});
-    abcdCorpus.idsToWords.insert({3, "d"});
-    abcdCorpus.occurrences.insert({{0, 0}, 1});
-    abcdCorpus.occurrences.insert({{0, 1}, 1});
-    abcdCorpus.occurrences.insert({{1, 2}, 1});
-    abcdCorpus.occurrences.insert({{2, 3}, 1});
-    abcdCorpus.occurrences.insert({{3, 2}, 1});
-    abcdCorpus.wordCountAsNumbers.insert({0, 2});
-    abcdCorpus.wordCountAsNumbers.insert({1, 1});
-    abcdCorpus.wordCountAsNumbers.insert({2, 2});
-    abcdCorpus.wordCountAsNumbers.insert({3, 1});
+    abcdCorpus.vocabulary = {"a", "b", "c", "d"};
+    abcdCorpus.setOccurrences(occurrence_type({{{0, 0}, 1},
+                                               {{0, 1}, 1},
+                                               {{1, 2}, 1},
+                                               {{2, 3}, 1},
+                                               {{3, 2}, 1}}));
+    abcdCorpus.wordCounts = {2, 1, 2, 1};
+    abcdCorpus.firstPositions = {0, 2, 3, 4};
 
     return abcdCorpus;
 }
@@ -72,6 +71,101 @@ TEST(CorpusTest, testWriteAndLoadCorpus) {
     EXPECT_TRUE(testCorpus == newCorpus);
 }
 
+TEST(CorpusTest, testWriteAndLoadMappedCorpus) {
+    Corpus testCorpus = createSimpleCorpus2();
+
+    const string pathForCorpus = "/tmp/corpus.mapped.test";
+
+    MappedCorpusFile::write(testCorpus, pathForCorpus);
+    EXPECT_TRUE(MappedCorpusFile::isMappedCorpusFile(pathForCorpus));
+    Corpus newCorpus = Corpus::deserializeFromFile(pathForCorpus);
+    EXPECT_TRUE(testCorpus == newCorpus);
+    EXPECT_TRUE(testCorpus.occurrencesTransposed == newCorpus.occurrencesTransposed);
+    EXPECT_TRUE(newCorpus.pl.isExternal());
+    EXPECT_TRUE(newCorpus.occurrences.entries.isExternal());
+    EXPECT_EQ(newCorpus.getOccurrence(2, 3), 1);
+
+//    converting back to the legacy format yields the same corpus
+    const string pathForLegacyCorpus = "/tmp/corpus.legacy.test";
+    Corpus::serializeToFile(newCorpus, pathForLegacyCorpus);
+    EXPECT_FALSE(MappedCorpusFile::isMappedCorpusFile(pathForLegacyCorpus));
+    EXPECT_TRUE(testCorpus == Corpus::deserializeFromFile(pathForLegacyCorpus));
+}
+
+/**
+ * Overwrites a value at the given position of a file.
+ */
+template<typename T>
+void patchFile(const string &fileName, const uint64_t position, const T value) {
+    std::fstream file(fileName, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(position);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+TEST(CorpusTest, testCorruptMappedCorpus) {
+    const Corpus testCorpus = createSimpleCorpus2();
+    const string pathForCorpus = "/tmp/corpus.corrupt.mapped.test";
+    MappedCorpusFile::MappedCorpusHeader header{};
+    const auto writeAndReadHeader = [&] {
+        MappedCorpusFile::write(testCorpus, pathForCorpus);
+        std::ifstream(pathForCorpus, std::ios::binary).read(reinterpret_cast<char *>(&header), sizeof(header));
+    };
+
+//    a neighbour outside of the vocabulary
+    writeAndReadHeader();
+    patchFile(pathForCorpus, header.sections[MappedCorpusFile::OCCURRENCES_ENTRIES].offset,
+              (word_type) testCorpus.vocabularySize);
+    EXPECT_THROW(MappedCorpusFile::read(pathForCorpus), runtime_error);
+
+//    offsets that are not monotonic
+    writeAndReadHeader();
+    patchFile(pathForCorpus, header.sections[MappedCorpusFile::OCCURRENCES_ROW_OFFSETS].offset + sizeof(uint64_t),
+              (uint64_t) testCorpus.occurrences.getNumberOfEntries() + 1);
+    EXPECT_THROW(MappedCorpusFile::read(pathForCorpus), runtime_error);
+
+//    fewer rows than words
+    writeAndReadHeader();
+    const uint64_t sizePosition = offsetof(MappedCorpusFile::MappedCorpusHeader, sections) +
+                                  MappedCorpusFile::OCCURRENCES_TRANSPOSED_ROW_OFFSETS *
+                                  sizeof(MappedCorpusFile::SectionLocation) +
+                                  offsetof(MappedCorpusFile::SectionLocation, size);
+    patchFile(pathForCorpus, sizePosition,
+              header.sections[MappedCorpusFile::OCCURRENCES_TRANSPOSED_ROW_OFFSETS].size - sizeof(uint64_t));
+    EXPECT_THROW(MappedCorpusFile::read(pathForCorpus), runtime_error);
+
+//    counts that are not symmetric in a file marked as holding a symmetric corpus
+    writeAndReadHeader();
+    patchFile(pathForCorpus, offsetof(MappedCorpusFile::MappedCorpusHeader, version), MappedCorpusFile::version);
+    patchFile(pathForCorpus, sizePosition, (uint64_t) 0);
+    EXPECT_THROW(MappedCorpusFile::read(pathForCorpus), runtime_error);
+
+    writeAndReadHeader();
+    EXPECT_TRUE(testCorpus == MappedCorpusFile::read(pathForCorpus));
+}
+
+TEST(CorpusTest, testSymmetricCorpus) {
+    Corpus testCorpus = createSimpleCorpus2();
+//    a b a c with a skip-gram width of 1: every bigram in both directions
+    testCorpus.setOccurrences(occurrence_type({{{0, 1}, 2},
+                                               {{1, 0}, 2},
+                                               {{0, 2}, 1},
+                                               {{2, 0}, 1},
+                                               {{3, 3}, 1}}), true);
+    EXPECT_TRUE(testCorpus.symmetric);
+    EXPECT_TRUE(testCorpus.occurrencesTransposed.getNumberOfEntries() == 0);
+    EXPECT_TRUE(testCorpus.getOccurrencesTransposed() == testCorpus.occurrences);
+    EXPECT_EQ(testCorpus.getOccurrencesTransposed().get(1, 0), 2);
+
+    Corpus::serializeToFile(testCorpus, "/tmp/corpus.symmetric.test");
+    EXPECT_TRUE(testCorpus == Corpus::deserializeFromFile("/tmp/corpus.symmetric.test"));
+    MappedCorpusFile::write(testCorpus, "/tmp/corpus.symmetric.mapped.test");
+    const Corpus mappedCorpus = Corpus::deserializeFromFile("/tmp/corpus.symmetric.mapped.test");
+    EXPECT_TRUE(testCorpus == mappedCorpus);
+    EXPECT_EQ(mappedCorpus.getOccurrencesTransposed().get(2, 0), 1);
+
+    EXPECT_THROW(testCorpus.setOccurrences(occurrence_type({{{0, 1}, 1}}), true), runtime_error);
+}
+
 TEST(CorpusTest, testGetWordOutOfRange) {
     Corpus testCorpus = createSimpleCorpus2();
 
@@ -7,11 +7,7 @@
 TEST(CorpusUtilsTest, testCalculateClusterFrequency) {
     Corpus corpus;
     corpus.vocabularySize = 5;
-    corpus.wordCountAsNumbers.insert({0, 1});
-    corpus.wordCountAsNumbers.insert({1, 2});
-    corpus.wordCountAsNumbers.insert({2, 3});
-    corpus.wordCountAsNumbers.insert({3, 4});
-    corpus.wordCountAsNumbers.insert({4, 5});
+    corpus.wordCounts = {1, 2, 3, 4, 5};
 
     const vector_word_type clusterAssignments = {0, 1, 2, 0, 1};
     const vector_word_type expectedFrequencies = {5, 7, 3};
@@ -22,7 +18,7 @@ TEST(CorpusUtilsTest, testCalculateClusterFrequency) {
 TEST(CorpusUtilsTest, testReadClusterAssignmentsFromFile) {
     Corpus corpus;
     corpus.vocabularySize = 5;
-    corpus.idsToWords = {{0, "a"}, {1, "b"}, {2, "c"}, {3, "d"}, {4, "e"}};
+    corpus.vocabulary = {"a", "b", "c", "d", "e"};
     const vector_word_type expectedClusterAssignments = {0, 1, 2, 0, 1};
     const vector_word_type actualClusterAssignments =
             CorpusUtils::readClusterAssignmentsFromFile("tests/test_data/cluster_assignments.test", corpus);
@@ -33,11 +29,7 @@ TEST(CorpusUtilsTest, testReadClusterAssignmentsFromFile) {
 TEST(CorpusUtilsTest, testReadClusterAssignmentsFromFileWhenNoFile) {
     Corpus corpus;
     corpus.vocabularySize = 5;
-    corpus.idsToWords.insert({0, "a"});
-    corpus.idsToWords.insert({1, "b"});
-    corpus.idsToWords.insert({2, "c"});
-    corpus.idsToWords.insert({3, "d"});
-    corpus.idsToWords.insert({4, "e"});
+    corpus.vocabulary = {"a", "b", "c", "d", "e"};
     EXPECT_THROW(CorpusUtils::readClusterAssignmentsFromFile("/tmp/non/nonexistent_file", corpus),
                  runtime_error);
 }
@@ -49,24 +41,11 @@ TEST(CorpusUtilsTest, testReadVocabularyFromFileWhenNoFile) {
 TEST(CorpusUtilsTest, testWriteClustersToFile) {
     Corpus corpus;
     corpus.vocabularySize = 5;
-    corpus.idsToWords.insert({0, "a"});
-    corpus.idsToWords.insert({1, "b"});
-    corpus.idsToWords.insert({2, "c"});
-    corpus.idsToWords.insert({3, "d"});
-    corpus.idsToWords.insert({4, "e"});
-
-    corpus.wordCountAsNumbers.insert({0, 1});
-    corpus.wordCountAsNumbers.insert({1, 2});
-    corpus.wordCountAsNumbers.insert({2, 3});
-    corpus.wordCountAsNumbers.insert({3, 4});
-    corpus.wordCountAsNumbers.insert({4, 5});
-
-    corpus.pl.push_back(1);
-    corpus.pl.push_back(2);
-    corpus.pl.push_back(3);
-    corpus.pl.push_back(4);
-    corpus.pl.push_back(5);
-    corpus.pl.push_back(6);
+    corpus.vocabulary = {"a", "b", "c", "d", "e"};
+
+    corpus.wordCounts = {1, 2, 3, 4, 5};
+
+    corpus.pl = {1, 2, 3, 4, 5, 6};
 
     const vector_word_type clusterAssignments = {0, 1, 2, 0, 1};
     std::string tmpFileName = "/tmp/unit_test_corpus_util_write_clusters_to_file";
@@ -83,17 +62,9 @@ TEST(CorpusUtilsTest, testWriteClustersToFile) {
 TEST(CorpusUtilsTest, testWriteTreeToLiangFile) {
     Corpus corpus;
     corpus.vocabularySize = 5;
-    corpus.idsToWords.insert({0, "a"});
-    corpus.idsToWords.insert({1, "b"});
-    corpus.idsToWords.insert({2, "c"});
-    corpus.idsToWords.insert({3, "d"});
-    corpus.idsToWords.insert({4, "e"});
-
-    corpus.wordCountAsNumbers.insert({0, 1});
-    corpus.wordCountAsNumbers.insert({1, 2});
-    corpus.wordCountAsNumbers.insert({2, 3});
-    corpus.wordCountAsNumbers.insert({3, 4});
-    corpus.wordCountAsNumbers.insert({4, 5});
+    corpus.vocabulary = {"a", "b", "c", "d", "e"};
+
+    corpus.wordCounts = {1, 2, 3, 4, 5};
 
     const vector<pair<string, word_type>> treeContents = {
         {"0", 0},
@@ -121,17 +92,9 @@ TEST(CorpusUtilsTest, testWriteTreeToLiangFile) {
 TEST(CorpusUtilsTest, testCannotWriteTreeToFileWhenNoFile) {
     Corpus corpus;
     corpus.vocabularySize = 5;
-    corpus.idsToWords.insert({0, "a"});
-    corpus.idsToWords.insert({1, "b"});
-    corpus.idsToWords.insert({2, "c"});
-    corpus.idsToWords.insert({3, "d"});
-    corpus.idsToWords.insert({4, "e"});
-
-    corpus.wordCountAsNumbers.insert({0, 1});
-    corpus.wordCountAsNumbers.insert({1, 2});
-    corpus.wordCountAsNumbers.insert({2, 3});
-    corpus.wordCountAsNumbers.insert({3, 4});
-    corpus.wordCountAsNumbers.insert({4, 5});
+    corpus.vocabulary = {"a", "b", "c", "d", "e"};
+
+    corpus.wordCounts = {1, 2, 3, 4, 5};
 
     const vector<pair<string, word_type>> treeContents = {
             {"0", 0},
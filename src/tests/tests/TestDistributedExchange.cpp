@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "ExchangeAlgorithm/DistributedExchange/DistributedExchange.h"
+#include "ExchangeAlgorithm/DistributedExchange/ExchangeShard.h"
+#include "TestExchangeCorpus.h"
+#include <thread>
+
+TEST(DistributedExchangeTest, testMessageChannel) {
+    auto channels = MessageChannel::createPair();
+    ShardReply reply;
+    reply.entries = {3, 7};
+    reply.deltas = {-2, 5};
+    reply.wordsEvaluated = 42;
+    channels.first.send(reply);
+    const ShardReply received = channels.second.receive<ShardReply>();
+    EXPECT_EQ(reply.entries, received.entries);
+    EXPECT_EQ(reply.deltas, received.deltas);
+    EXPECT_EQ(42u, received.wordsEvaluated);
+    EXPECT_EQ(channels.first.getBytesTransferred(), channels.second.getBytesTransferred());
+
+    channels.first = MessageChannel(-1);
+    EXPECT_TRUE(channels.second.atEnd());
+    EXPECT_THROW(channels.second.receive<ShardReply>(), runtime_error);
+}
+
+TEST(DistributedExchangeTest, testDistributedExchange) {
+    const corpus_handle corpus = readAliceCorpus();
+    const word_type noClusters = 20;
+    Exchange exchange(corpus);
+    exchange.prepareClustering(noClusters);
+    const double initialAMI = exchange.calculateAMI();
+    const vector_word_type expected = exchange.cluster(noClusters, 4, 0.0);
+
+    for (const word_type numWorkers : {1, 3}) {
+//        the workers run in threads of this process, connected through Unix sockets like worker processes
+        vector<MessageChannel> channels;
+        vector<std::thread> workers;
+        for (word_type worker = 0; worker < numWorkers; ++worker) {
+            auto pair = MessageChannel::createPair();
+            channels.push_back(std::move(pair.first));
+            workers.emplace_back([corpus](MessageChannel channel) {
+                ExchangeShard shard(corpus);
+                shard.serve(channel);
+            }, std::move(pair.second));
+        }
+        {
+            DistributedExchange distributed(corpus, std::move(channels));
+            distributed.setRoundsPerIteration(numWorkers == 1 ? 1 : 4);
+            const vector_word_type assignments = distributed.cluster(noClusters, 4, 0.0);
+            EXPECT_GT(distributed.calculateAMI(), initialAMI);
+            EXPECT_EQ(4u, distributed.getIterations());
+            EXPECT_GT(distributed.getWordsEvaluated(), 0u);
+            EXPECT_GT(distributed.getBytesTransferred(), 0u);
+            if (numWorkers == 1) {
+//                a single worker processing all words in one round is Exchange
+                EXPECT_EQ(expected, assignments);
+            }
+
+            Exchange recomputed(corpus);
+            recomputed.prepareClustering(noClusters, assignments);
+            EXPECT_NEAR(recomputed.calculateAMI(), distributed.calculateAMI(), 1e-9);
+            vector_word_type clusterSizes(noClusters, 0);
+            for (const word_type clusterID : assignments) {
+                ++clusterSizes[clusterID];
+            }
+            EXPECT_EQ(0, std::count(clusterSizes.begin(), clusterSizes.end(), 0u));
+        }
+//        closing the connections ends the workers
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    EXPECT_THROW(DistributedExchange(corpus, vector<MessageChannel>()), runtime_error);
+}
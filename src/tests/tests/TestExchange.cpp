@@ -3,9 +3,13 @@
 #include <models/Corpus.h>
 #include "ExchangeAlgorithm/Exchange/Exchange.h"
 #include "ExchangeAlgorithm/StochasticExchange/StochasticExchange.h"
+#include "ExchangeAlgorithm/StochasticExchange/CounterRandom.h"
 #include "ExchangeAlgorithm/ExchangeAlgorithm.h"
 #include "readers/ReaderNoOrder.h"
 #include "readers/ReaderFrequency.h"
+#include "TestExchangeCorpus.h"
+#include <omp.h>
+#include <random>
 
 Corpus createSimpleCorpus() {
     //    the corpus here is a a b c d c
@@ -14,26 +18,20 @@ Corpus createSimpleCorpus() {
     abcdCorpus.corpusLength = 6;
     abcdCorpus.pl = {2.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0, 1.0 / 5.0};
     abcdCorpus.pr = {1.0 / 5.0, 1.0 / 5.0, 2.0 / 5.0, 1.0 / 5.0};
-    abcdCorpus.idsToWords.insert({0, "a"});
-    abcdCorpus.idsToWords.insert({1, "b"});
-    abcdCorpus.idsToWords.insert({2, "c"});
-    abcdCorpus.idsToWords.insert({3, "d"});
-    abcdCorpus.occurrences.insert({{0, 0}, 1});
-    abcdCorpus.occurrences.insert({{0, 1}, 1});
-    abcdCorpus.occurrences.insert({{1, 2}, 1});
-    abcdCorpus.occurrences.insert({{2, 3}, 1});
-    abcdCorpus.occurrences.insert({{3, 2}, 1});
-    abcdCorpus.wordCountAsNumbers.insert({0, 2});
-    abcdCorpus.wordCountAsNumbers.insert({1, 1});
-    abcdCorpus.wordCountAsNumbers.insert({2, 2});
-    abcdCorpus.wordCountAsNumbers.insert({3, 1});
+    abcdCorpus.vocabulary = {"a", "b", "c", "d"};
+    abcdCorpus.setOccurrences(occurrence_type({{{0, 0}, 1},
+                                               {{0, 1}, 1},
+                                               {{1, 2}, 1},
+                                               {{2, 3}, 1},
+                                               {{3, 2}, 1}}));
+    abcdCorpus.wordCounts = {2, 1, 2, 1};
 
     return abcdCorpus;
 }
 
 TEST(ExchangeTest, testAMIExchangeAlgorithms) {
 //    the corpus here is a b a c d
-    const Corpus abcdCorpus = createSimpleCorpus();
+    const corpus_handle abcdCorpus = make_shared<const Corpus>(createSimpleCorpus());
     const vector<vector<word_type>> clusterAssignments = {
             {0, 1, 1, 2},
             {0, 1, 2, 2},
@@ -65,7 +63,7 @@ TEST(ExchangeTest, testAMIExchangeAlgorithms) {
 
 TEST(ExchangeTest, testCalculateAMI) {
 //    the corpus here is a b a c d
-    const Corpus abcdCorpus = createSimpleCorpus();
+    const corpus_handle abcdCorpus = make_shared<const Corpus>(createSimpleCorpus());
 
     const vector_word_type initialClusterAssignments = {0, 1, 1, 2};
 
@@ -79,7 +77,7 @@ TEST(ExchangeTest, testCalculateAMI) {
 
 TEST(ExchangeTest, test2ExchangeAlgorithms) {
 //    the corpus here is a b a c d
-    const Corpus abcdCorpus = createSimpleCorpus();
+    const corpus_handle abcdCorpus = make_shared<const Corpus>(createSimpleCorpus());
 
     const vector_word_type initialClusterAssignments = {0, 1, 1, 2};
     const vector_word_type expectedClusterAssignments = {0, 1, 2, 1};
@@ -118,7 +116,7 @@ TEST(ExchangeTest, testFileCorpora) {
         const string fileName = pair.first;
         const word_type noClusters = pair.second;
         const Corpus corpusNoOrder = readerNoOrder.readFile(path + fileName);
-        const Corpus corpus = readerFrequency.reorderCorpus(corpusNoOrder);
+        const corpus_handle corpus = make_shared<const Corpus>(readerFrequency.reorderCorpus(corpusNoOrder));
         Exchange omp(corpus);
         const vector<Exchange *> algorithms = {&omp};
 
@@ -168,4 +166,605 @@ TEST(ExchangeTest, testFileCorpora) {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(ExchangeTest, testSharesCorpus) {
+    const corpus_handle abcdCorpus = make_shared<const Corpus>(createSimpleCorpus());
+    {
+        Exchange omp(abcdCorpus);
+        StochasticExchange stochasticExchange(abcdCorpus);
+        EXPECT_EQ(3, abcdCorpus.use_count());
+    }
+    EXPECT_EQ(1, abcdCorpus.use_count());
+}
+
+/**
+ * Exposes the move evaluation of Exchange so it can be compared against recomputing the AMI from scratch.
+ */
+class ExchangeUnderTest : public Exchange {
+public:
+    using Exchange::Exchange;
+    using Exchange::prepareWordEvaluation;
+    using Exchange::calculateAMIDiff;
+    using Exchange::occurrenceTerm;
+    using Exchange::scoreCandidates;
+    using Exchange::scoreCandidatesWithBounds;
+    using Exchange::wordsToClusters;
+    using Exchange::selectCandidate;
+    using Exchange::bestInBlock;
+    using Exchange::combineBlocks;
+    using Exchange::occurrencesClusters;
+    using Exchange::sumRowsEntropyOccurrences;
+    using Exchange::sumColumnsEntropyOccurrences;
+    using Exchange::entropyOccurrencesTransposed;
+    using Exchange::plC;
+    using Exchange::clusterContent;
+};
+
+TEST(ExchangeTest, testAMIDiffMatchesRecomputedAMI) {
+    ReaderNoOrder readerNoOrder;
+    ReaderFrequency readerFrequency;
+    const corpus_handle corpus = make_shared<const Corpus>(
+            readerFrequency.reorderCorpus(readerNoOrder.readFile("tests/test_data/debug_dog.txt")));
+    const word_type noClusters = 3;
+    vector_word_type clusterAssignments(corpus->vocabularySize);
+    for (word_type wordID = 0; wordID < corpus->vocabularySize; ++wordID) {
+        clusterAssignments[wordID] = wordID % noClusters;
+    }
+    for (const auto representation : {WordClusterCounts::DENSE, WordClusterCounts::SPARSE}) {
+        ExchangeUnderTest exchange(corpus);
+        exchange.setWordClusterCountsRepresentation(representation);
+        exchange.prepareClustering(noClusters, clusterAssignments);
+        const double amiBefore = exchange.calculateAMI();
+        for (word_type wordID = 0; wordID < corpus->vocabularySize; ++wordID) {
+            WordEvaluation evaluation;
+            exchange.prepareWordEvaluation(wordID, evaluation);
+            for (word_type clusterCandidate = 0; clusterCandidate < noClusters; ++clusterCandidate) {
+                if (clusterCandidate == clusterAssignments[wordID]) {
+                    continue;
+                }
+                vector_word_type movedAssignments = clusterAssignments;
+                movedAssignments[wordID] = clusterCandidate;
+                Exchange moved(corpus);
+                moved.prepareClustering(noClusters, movedAssignments);
+                EXPECT_NEAR(moved.calculateAMI() - amiBefore, exchange.calculateAMIDiff(evaluation, clusterCandidate),
+                            1e-9) << "Wrong AMI change for moving word " << wordID << " to cluster "
+                                  << clusterCandidate << " with representation " << representation;
+            }
+        }
+    }
+}
+
+TEST(ExchangeTest, testDenseAndSparseWordClusterCountsAgree) {
+    const corpus_handle corpus = readAliceCorpus();
+    Exchange dense(corpus);
+    dense.setWordClusterCountsRepresentation(WordClusterCounts::DENSE);
+    Exchange sparse(corpus);
+    sparse.setWordClusterCountsRepresentation(WordClusterCounts::SPARSE);
+    EXPECT_THAT(sparse.cluster(10, 2), ::testing::ContainerEq(dense.cluster(10, 2)));
+    EXPECT_DOUBLE_EQ(sparse.calculateAMI(), dense.calculateAMI());
+}
+
+TEST(ExchangeTest, testCountDomainMatchesProbabilityDomain) {
+    const corpus_handle corpus = readAliceCorpus();
+    const word_type noClusters = 10;
+    ExchangeUnderTest probabilities(corpus);
+    ExchangeUnderTest counts(corpus);
+    counts.setCountDomain(true);
+    probabilities.prepareClustering(noClusters);
+    counts.prepareClustering(noClusters);
+    EXPECT_NEAR(probabilities.calculateAMI(), counts.calculateAMI(), 1e-12);
+    for (word_type wordID = 0; wordID < corpus->vocabularySize; wordID += 7) {
+        WordEvaluation probabilitiesEvaluation;
+        WordEvaluation countsEvaluation;
+        probabilities.prepareWordEvaluation(wordID, probabilitiesEvaluation);
+        counts.prepareWordEvaluation(wordID, countsEvaluation);
+        for (word_type clusterCandidate = 0; clusterCandidate < noClusters; ++clusterCandidate) {
+            if (clusterCandidate == probabilities.wordsToClusters[wordID]) {
+                continue;
+            }
+            EXPECT_NEAR(probabilities.calculateAMIDiff(probabilitiesEvaluation, clusterCandidate),
+                        counts.calculateAMIDiff(countsEvaluation, clusterCandidate), 1e-12)
+                                << "Domains disagree for word " << wordID << " and cluster " << clusterCandidate;
+        }
+    }
+
+//    counts beyond the lookup table are computed directly
+    EXPECT_DOUBLE_EQ(counts.occurrenceTerm(1000), 1000 * std::log2(1000.0));
+    EXPECT_DOUBLE_EQ(counts.occurrenceTerm(1000000), 1000000 * std::log2(1000000.0));
+    EXPECT_EQ(counts.occurrenceTerm(0), 0);
+    EXPECT_EQ(counts.occurrenceTerm(1), 0);
+
+//    after moves the incrementally maintained count-domain AMI still matches a fresh computation
+    counts.clusterOneIteration();
+    Exchange recomputed(corpus);
+    recomputed.prepareClustering(noClusters, counts.getClusterAssignments());
+    EXPECT_NEAR(recomputed.calculateAMI(), counts.calculateAMI(), 1e-12);
+}
+
+TEST(ExchangeTest, testVectorizedScoringMatchesScalar) {
+    const corpus_handle corpus = readAliceCorpus();
+    const word_type noClusters = 37;
+    for (const bool countDomain : {false, true}) {
+        ExchangeUnderTest exchange(corpus);
+        exchange.setCountDomain(countDomain);
+        exchange.prepareClustering(noClusters);
+        exchange.clusterOneIteration();
+        vector<double> amiChange(noClusters);
+        WordEvaluation evaluation;
+        for (word_type wordID = 0; wordID < corpus->vocabularySize; wordID += 3) {
+            exchange.prepareWordEvaluation(wordID, evaluation);
+//            uneven blocks to cover the corrections at block boundaries
+            exchange.scoreCandidates(evaluation, 0, 10, amiChange.data());
+            exchange.scoreCandidates(evaluation, 10, noClusters, amiChange.data());
+            for (word_type clusterCandidate = 0; clusterCandidate < noClusters; ++clusterCandidate) {
+                if (clusterCandidate == exchange.wordsToClusters[wordID]) {
+                    EXPECT_EQ(amiChange[clusterCandidate], 0);
+                    continue;
+                }
+                EXPECT_NEAR(exchange.calculateAMIDiff(evaluation, clusterCandidate), amiChange[clusterCandidate],
+                            1e-12)
+                                    << "Scoring differs for word " << wordID << " and cluster " << clusterCandidate
+                                    << (countDomain ? " in the count domain" : "");
+            }
+        }
+    }
+}
+
+TEST(ExchangeTest, testSelectCandidateBreaksTiesDeterministically) {
+    const double tie = Exchange::CANDIDATE_TIE_TOLERANCE / 10;
+//    the word stays if its own cluster is as good as the best one
+    EXPECT_EQ(ExchangeUnderTest::selectCandidate({tie, 0, -1}, 1), 1u);
+//    otherwise the lowest of the tied clusters wins, independent of rounding
+    EXPECT_EQ(ExchangeUnderTest::selectCandidate({-1, 0, 0.5, 0.5 + tie}, 1), 2u);
+    EXPECT_EQ(ExchangeUnderTest::selectCandidate({-1, 0, 0.5 + tie, 0.5}, 1), 2u);
+    EXPECT_EQ(ExchangeUnderTest::selectCandidate({0.25, 0, 0.5}, 1), 2u);
+}
+
+TEST(ExchangeTest, testVectorizedAndScalarScoringTakeTheSameMoves) {
+    const corpus_handle corpus = readAliceCorpus();
+    Exchange scalar(corpus);
+    scalar.setVectorizedScoring(false);
+    Exchange vectorized(corpus);
+    EXPECT_EQ(scalar.cluster(20, 5), vectorized.cluster(20, 5));
+}
+
+TEST(ExchangeTest, testSymmetricScoringMatchesScalar) {
+    const corpus_handle corpus = readSymmetricAndPlainCorpus().first;
+    ASSERT_TRUE(corpus->symmetric);
+    const word_type noClusters = 37;
+    ExchangeUnderTest exchange(corpus);
+    exchange.prepareClustering(noClusters);
+    exchange.clusterOneIteration();
+//    only the rows are kept, they serve as columns
+    EXPECT_TRUE(exchange.entropyOccurrencesTransposed.empty());
+    vector<double> amiChange(noClusters);
+    WordEvaluation evaluation;
+    for (word_type wordID = 0; wordID < corpus->vocabularySize; wordID += 3) {
+        exchange.prepareWordEvaluation(wordID, evaluation);
+        exchange.scoreCandidates(evaluation, 0, 10, amiChange.data());
+        exchange.scoreCandidates(evaluation, 10, noClusters, amiChange.data());
+        for (word_type clusterCandidate = 0; clusterCandidate < noClusters; ++clusterCandidate) {
+//            the skip-gram reader keeps counts in pl and pr, whose entropy terms are large and cancel out
+            if (clusterCandidate != exchange.wordsToClusters[wordID]) {
+                EXPECT_NEAR(exchange.calculateAMIDiff(evaluation, clusterCandidate), amiChange[clusterCandidate],
+                            1e-9)
+                                    << "Scoring differs for word " << wordID << " and cluster " << clusterCandidate;
+            }
+        }
+    }
+}
+
+TEST(ExchangeTest, testSymmetricCorpusTakesTheSameMoves) {
+    const pair<corpus_handle, corpus_handle> corpora = readSymmetricAndPlainCorpus();
+    for (const bool boundPruning : {false, true}) {
+        Exchange symmetric(corpora.first);
+        symmetric.setBoundPruning(boundPruning);
+        Exchange plain(corpora.second);
+        plain.setBoundPruning(boundPruning);
+        EXPECT_EQ(plain.cluster(20, 3), symmetric.cluster(20, 3)) << (boundPruning ? "with bound pruning" : "");
+        EXPECT_NEAR(plain.calculateAMI(), symmetric.calculateAMI(), 1e-9);
+    }
+    Exchange scalar(corpora.first);
+    scalar.setVectorizedScoring(false);
+    Exchange vectorized(corpora.first);
+    EXPECT_EQ(scalar.cluster(20, 3), vectorized.cluster(20, 3));
+}
+
+TEST(ExchangeTest, testCombinedBlocksSelectTheSameCandidate) {
+    std::mt19937 generator(42);
+//    few distinct values, some of them within the tie tolerance of each other
+    std::uniform_int_distribution<int> level(0, 3);
+    std::uniform_int_distribution<int> jitter(-1, 1);
+    const word_type numClusters = 23;
+    for (int round = 0; round < 1000; ++round) {
+        vector<double> amiChange(numClusters);
+        for (double &change : amiChange) {
+            change = level(generator) * 1e-3 + jitter(generator) * Exchange::CANDIDATE_TIE_TOLERANCE * 0.6;
+        }
+        const word_type source = round % numClusters;
+        amiChange[source] = 0;
+        for (const word_type numBlocks : {1u, 2u, 5u, 23u, 30u}) {
+            vector<BlockBest> blockBests(numBlocks);
+            for (word_type block = 0; block < numBlocks; ++block) {
+                blockBests[block] = ExchangeUnderTest::bestInBlock(amiChange.data(), numClusters * block / numBlocks,
+                                                                   numClusters * (block + 1) / numBlocks);
+            }
+            EXPECT_EQ(ExchangeUnderTest::combineBlocks(amiChange.data(), blockBests.data(), numBlocks, source),
+                      ExchangeUnderTest::selectCandidate(amiChange, source)) << "Round " << round << " with "
+                                                                            << numBlocks << " blocks";
+        }
+    }
+}
+
+TEST(ExchangeTest, testClusteringIndependentOfNumberOfThreads) {
+    const corpus_handle corpus = readAliceCorpus();
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    Exchange singleThreaded(corpus);
+    const vector_word_type expected = singleThreaded.cluster(20, 3);
+    omp_set_num_threads(4);
+    Exchange multiThreaded(corpus);
+    const vector_word_type actual = multiThreaded.cluster(20, 3);
+    omp_set_num_threads(maxThreads);
+    EXPECT_EQ(expected, actual);
+    EXPECT_EQ(singleThreaded.getIterations(), multiThreaded.getIterations());
+}
+
+TEST(ExchangeTest, testPlacementDoesNotChangeClustering) {
+    const corpus_handle corpus = readAliceCorpus();
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    Exchange firstTouch(corpus);
+    const vector_word_type expected = firstTouch.cluster(20, 3);
+    Exchange serialPlacement(corpus);
+    serialPlacement.setParallelFirstTouch(false);
+    const vector_word_type actual = serialPlacement.cluster(20, 3);
+    omp_set_num_threads(maxThreads);
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(ExchangeTest, testSpeculativeBatches) {
+    const corpus_handle corpus = readAliceCorpus();
+    Exchange sequential(corpus);
+    sequential.cluster(20, 3);
+    Exchange batchOfOne(corpus);
+    batchOfOne.setSpeculativeBatchSize(1);
+    batchOfOne.cluster(20, 3);
+    EXPECT_EQ(sequential.getClusterAssignments(), batchOfOne.getClusterAssignments());
+
+    const int maxThreads = omp_get_max_threads();
+    vector<vector_word_type> results;
+    for (const int numThreads : {1, 3}) {
+        omp_set_num_threads(numThreads);
+        Exchange speculative(corpus);
+        speculative.setSpeculativeBatchSize(16);
+        speculative.prepareClustering(20);
+        const double initialAMI = speculative.calculateAMI();
+        speculative.clusterOneIteration();
+        EXPECT_GT(speculative.getSpeculativeMovesCommitted(), 0u);
+        EXPECT_GT(speculative.getSpeculativeWordsRescored(), 0u);
+//        every committed move is a change, re-scored words may or may not move
+        EXPECT_GE(speculative.getChangesInPreviousIteration(), speculative.getSpeculativeMovesCommitted());
+        EXPECT_LE(speculative.getChangesInPreviousIteration(),
+                  speculative.getSpeculativeMovesCommitted() + speculative.getSpeculativeWordsRescored());
+//        every applied move increases the AMI, and the incremental AMI matches a fresh computation
+        EXPECT_GT(speculative.calculateAMI(), initialAMI);
+        Exchange recomputed(corpus);
+        recomputed.prepareClustering(20, speculative.getClusterAssignments());
+        EXPECT_NEAR(recomputed.calculateAMI(), speculative.calculateAMI(), 1e-9);
+        results.push_back(speculative.getClusterAssignments());
+    }
+    omp_set_num_threads(maxThreads);
+//    moves are applied in word order, so the number of threads does not matter
+    EXPECT_EQ(results[0], results[1]);
+}
+
+TEST(ExchangeTest, testMovesSharedByTheTeam) {
+    const corpus_handle corpus = readAliceCorpus();
+//    enough clusters for two threads to share the entropy refresh of every move
+    const word_type noClusters = 2 * Exchange::MIN_CLUSTERS_PER_THREAD_FOR_SHARED_MOVES;
+    ASSERT_LE(noClusters, corpus->vocabularySize);
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    Exchange singleThreaded(corpus);
+    singleThreaded.cluster(noClusters, 2);
+    omp_set_num_threads(2);
+    Exchange shared(corpus);
+    shared.cluster(noClusters, 2);
+    omp_set_num_threads(maxThreads);
+    EXPECT_EQ(singleThreaded.getClusterAssignments(), shared.getClusterAssignments());
+    Exchange recomputed(corpus);
+    recomputed.prepareClustering(noClusters, shared.getClusterAssignments());
+    EXPECT_NEAR(recomputed.calculateAMI(), shared.calculateAMI(), 1e-9);
+}
+
+TEST(ExchangeTest, testDeadlineStopsBetweenWords) {
+    const corpus_handle corpus = readAliceCorpus();
+    for (const word_type batchSize : {1u, 8u}) {
+//        a deadline that has passed stops the run after the first word (or batch)
+        Exchange expired(corpus);
+        expired.setSpeculativeBatchSize(batchSize);
+        expired.setDeadline(std::chrono::steady_clock::now());
+        const vector_word_type stopped = expired.cluster(20, 3);
+        EXPECT_EQ(Exchange::DEADLINE, expired.getStopReason());
+        EXPECT_EQ(0u, expired.getCompletedIterations());
+        EXPECT_LE(expired.getWordsEvaluated(), batchSize);
+//        the AMI of Exchange never decreases, so the best clustering is the last one
+        EXPECT_EQ(expired.getClusterAssignments(), stopped);
+        EXPECT_EQ(stopped, expired.getBestClusterAssignments());
+        EXPECT_NEAR(amiOfAssignments(corpus, 20, stopped), expired.getBestAMI(), 1e-9);
+        EXPECT_FALSE(expired.clusterOneIteration());
+
+        Exchange unlimited(corpus);
+        unlimited.setSpeculativeBatchSize(batchSize);
+        const vector_word_type expected = unlimited.cluster(20, 3);
+        expired.setTimeBudget(std::chrono::hours(1));
+        EXPECT_EQ(expected, expired.cluster(20, 3));
+        EXPECT_EQ(Exchange::NOT_STOPPED, expired.getStopReason());
+        expired.clearDeadline();
+        EXPECT_EQ(expected, expired.cluster(20, 3));
+        EXPECT_TRUE(expired.getBestClusterAssignments().empty());
+    }
+}
+
+TEST(ExchangeTest, testCancellationToken) {
+    const corpus_handle corpus = readAliceCorpus();
+    const string path = "/tmp/exchange_cancelled_checkpoint.test";
+    Exchange uninterrupted(corpus);
+    const vector_word_type expected = uninterrupted.cluster(20, 3);
+
+//    a cancelled run writes a checkpoint at the word where it stopped, from which it can be resumed
+    CancellationToken token;
+    Exchange cancelled(corpus);
+    cancelled.setCheckpointing(path, std::chrono::seconds(0));
+    cancelled.setCancellationToken(&token);
+    cancelled.prepareClustering(20);
+    EXPECT_TRUE(cancelled.clusterOneIteration());
+    token.cancel();
+    EXPECT_FALSE(cancelled.clusterOneIteration());
+    EXPECT_EQ(Exchange::CANCELLED, cancelled.getStopReason());
+    EXPECT_EQ(1u, cancelled.getCompletedIterations());
+    const ExchangeCheckpoint checkpoint = ExchangeCheckpoint::readFromFile(path);
+    EXPECT_EQ(1u, checkpoint.iteration);
+    EXPECT_GT(checkpoint.nextWordID, 0u);
+    EXPECT_LT(checkpoint.nextWordID, corpus->vocabularySize);
+    Exchange resumed(corpus);
+    EXPECT_EQ(expected, resumed.cluster(checkpoint, 3));
+
+    token.reset();
+    EXPECT_EQ(expected, cancelled.cluster(20, 3));
+    EXPECT_EQ(Exchange::NOT_STOPPED, cancelled.getStopReason());
+
+//    random swaps can lower the AMI; with a token set the best clustering seen is the result
+    const word_type numIterations = 4;
+    StochasticExchange random(corpus);
+    random.setRandomness(30);
+    random.setSeed(5);
+    const vector_word_type last = random.cluster(20, numIterations, 0.0);
+    EXPECT_TRUE(random.getBestClusterAssignments().empty());
+    StochasticExchange anytime(corpus);
+    anytime.setRandomness(30);
+    anytime.setSeed(5);
+    anytime.setCancellationToken(&token);
+    const vector_word_type best = anytime.cluster(20, numIterations, 0.0);
+    EXPECT_EQ(Exchange::NOT_STOPPED, anytime.getStopReason());
+    EXPECT_EQ(last, anytime.getClusterAssignments());
+    EXPECT_NEAR(amiOfAssignments(corpus, 20, best), anytime.getBestAMI(), 1e-9);
+    EXPECT_GE(anytime.getBestAMI(), anytime.calculateAMI());
+    EXPECT_GE(anytime.getBestAMI(), amiOfAssignments(corpus, 20, last));
+}
+
+TEST(ExchangeTest, testInitializationIndependentOfNumberOfThreads) {
+    const corpus_handle corpus = readAliceCorpus();
+    const word_type noClusters = 100;
+//    the default clustering puts most words into the last cluster, whose row is then split among the threads
+    std::mt19937 randomEngine(7);
+    std::uniform_int_distribution<word_type> clusterDistribution(0, noClusters - 1);
+    vector_word_type randomAssignments(corpus->vocabularySize);
+    for (word_type &clusterID : randomAssignments) {
+        clusterID = clusterDistribution(randomEngine);
+    }
+    const int maxThreads = omp_get_max_threads();
+    for (bool defaultClustering : {true, false}) {
+        omp_set_num_threads(1);
+        ExchangeUnderTest singleThreaded(corpus);
+        omp_set_num_threads(4);
+        ExchangeUnderTest multiThreaded(corpus);
+        if (defaultClustering) {
+            omp_set_num_threads(1);
+            singleThreaded.prepareClustering(noClusters);
+            omp_set_num_threads(4);
+            multiThreaded.prepareClustering(noClusters);
+        } else {
+            omp_set_num_threads(1);
+            singleThreaded.prepareClustering(noClusters, randomAssignments);
+            omp_set_num_threads(4);
+            multiThreaded.prepareClustering(noClusters, randomAssignments);
+        }
+        EXPECT_EQ(singleThreaded.occurrencesClusters, multiThreaded.occurrencesClusters);
+        EXPECT_EQ(singleThreaded.sumRowsEntropyOccurrences, multiThreaded.sumRowsEntropyOccurrences);
+        EXPECT_EQ(singleThreaded.sumColumnsEntropyOccurrences, multiThreaded.sumColumnsEntropyOccurrences);
+        EXPECT_EQ(singleThreaded.entropyOccurrencesTransposed, multiThreaded.entropyOccurrencesTransposed);
+        EXPECT_EQ(singleThreaded.plC, multiThreaded.plC);
+        EXPECT_EQ(singleThreaded.clusterContent, multiThreaded.clusterContent);
+        EXPECT_EQ(singleThreaded.calculateAMI(), multiThreaded.calculateAMI());
+//        every bigram is counted exactly once
+        uint64_t total = 0;
+        const word_type *counts = multiThreaded.occurrencesClusters.data();
+        for (uint64_t entry = 0; entry < (uint64_t) noClusters * noClusters; ++entry) {
+            total += counts[entry];
+        }
+        uint64_t expectedTotal = 0;
+        corpus->occurrences.forEach([&expectedTotal](const word_type, const word_type, const word_type count) {
+            expectedTotal += count;
+        });
+        EXPECT_EQ(expectedTotal, total);
+    }
+    omp_set_num_threads(maxThreads);
+}
+
+TEST(ExchangeTest, testActiveSetScheduling) {
+    const corpus_handle corpus = readAliceCorpus();
+    Exchange fullSweeps(corpus);
+    const vector_word_type expected = fullSweeps.cluster(20, 3);
+//    with a full sweep in every iteration nothing is skipped
+    Exchange everyIterationFull(corpus);
+    everyIterationFull.setActiveSetScheduling(true);
+    everyIterationFull.setFullSweepInterval(1);
+    EXPECT_EQ(expected, everyIterationFull.cluster(20, 3));
+    EXPECT_EQ(fullSweeps.getWordsEvaluated(), everyIterationFull.getWordsEvaluated());
+
+    for (const word_type batchSize : {1, 16}) {
+        for (const double threshold : {0.0, 0.05}) {
+            Exchange activeSet(corpus);
+            activeSet.setSpeculativeBatchSize(batchSize);
+            activeSet.setActiveSetScheduling(true);
+            activeSet.setActiveSetThreshold(threshold);
+            const word_type maxIterations = 200;
+            activeSet.cluster(20, maxIterations);
+            ASSERT_LT(activeSet.getIterations(), maxIterations);
+            EXPECT_LT(activeSet.getWordsEvaluated(), (uint64_t) activeSet.getIterations() * corpus->vocabularySize);
+//            the run only ends after a full sweep without moves, so a full iteration finds nothing to move either
+            Exchange check(corpus);
+            check.setSpeculativeBatchSize(batchSize);
+            check.prepareClustering(20, activeSet.getClusterAssignments());
+            check.clusterOneIteration();
+            EXPECT_EQ(0u, check.getChangesInPreviousIteration());
+            EXPECT_NEAR(check.calculateAMI(), activeSet.calculateAMI(), 1e-9);
+        }
+    }
+}
+
+TEST(ExchangeTest, testBoundPruning) {
+    const corpus_handle corpus = readAliceCorpus();
+    const word_type noClusters = 37;
+    for (const bool countDomain : {false, true}) {
+        ExchangeUnderTest exchange(corpus);
+        exchange.setCountDomain(countDomain);
+        exchange.prepareClustering(noClusters);
+        exchange.clusterOneIteration();
+        vector<double> amiChange(noClusters);
+        WordEvaluation evaluation;
+        for (word_type wordID = 0; wordID < corpus->vocabularySize; ++wordID) {
+            exchange.prepareWordEvaluation(wordID, evaluation);
+            exchange.scoreCandidatesWithBounds(evaluation, 0, 10, amiChange.data());
+            exchange.scoreCandidatesWithBounds(evaluation, 10, noClusters, amiChange.data());
+            const double best = *max_element(amiChange.begin(), amiChange.end());
+            for (word_type clusterCandidate = 0; clusterCandidate < noClusters; ++clusterCandidate) {
+                if (clusterCandidate == exchange.wordsToClusters[wordID]) {
+                    EXPECT_EQ(amiChange[clusterCandidate], 0);
+                    continue;
+                }
+                const double expected = exchange.calculateAMIDiff(evaluation, clusterCandidate);
+//                pruned candidates can not compete with the best one, all others are exact
+                if (amiChange[clusterCandidate] == -std::numeric_limits<double>::infinity()) {
+                    EXPECT_LT(expected, best - Exchange::CANDIDATE_TIE_TOLERANCE)
+                                        << "Word " << wordID << " wrongly pruned cluster " << clusterCandidate;
+                } else {
+                    EXPECT_NEAR(expected, amiChange[clusterCandidate], 1e-12)
+                                        << "Scoring differs for word " << wordID << " and cluster "
+                                        << clusterCandidate;
+                }
+            }
+        }
+        EXPECT_GT(exchange.getCandidatesPruned(), 0u);
+        EXPECT_LE(exchange.getCandidatesPruned(), exchange.getCandidatesBounded());
+    }
+
+    for (const word_type batchSize : {1, 16}) {
+        Exchange exact(corpus);
+        exact.setSpeculativeBatchSize(batchSize);
+        Exchange pruned(corpus);
+        pruned.setSpeculativeBatchSize(batchSize);
+        pruned.setBoundPruning(true);
+        EXPECT_EQ(exact.cluster(20, 5), pruned.cluster(20, 5));
+        EXPECT_GT(pruned.getCandidatesPruned(), 0u);
+        EXPECT_EQ(0u, exact.getCandidatesBounded());
+    }
+}
+
+TEST(ExchangeTest, testMovableWords) {
+    const corpus_handle corpus = readAliceCorpus();
+    const word_type numWords = 100;
+    for (const word_type batchSize : {1, 16}) {
+        Exchange exchange(corpus);
+        exchange.setSpeculativeBatchSize(batchSize);
+        exchange.setMovableWords(numWords);
+        EXPECT_EQ(numWords, exchange.getNumberOfMovableWords());
+        exchange.prepareClustering(20);
+        const vector_word_type initial = exchange.getClusterAssignments();
+        exchange.clusterOneIteration();
+        const vector_word_type &assignments = exchange.getClusterAssignments();
+        EXPECT_GT(exchange.getChangesInPreviousIteration(), 0u);
+        for (word_type wordID = numWords; wordID < corpus->vocabularySize; ++wordID) {
+            ASSERT_EQ(initial[wordID], assignments[wordID]) << "Word " << wordID << " moved";
+        }
+    }
+}
+
+TEST(ExchangeTest, testCounterRandom) {
+    EXPECT_EQ(CounterRandom::bits(1, 2, 3), CounterRandom::bits(1, 2, 3));
+    EXPECT_NE(CounterRandom::bits(1, 2, 3), CounterRandom::bits(2, 2, 3));
+    EXPECT_NE(CounterRandom::bits(1, 2, 3), CounterRandom::bits(1, 3, 3));
+    EXPECT_NE(CounterRandom::bits(1, 2, 3), CounterRandom::bits(1, 2, 4));
+    double sum = 0;
+    vector_word_type histogram(10, 0);
+    const word_type draws = 100000;
+    for (word_type position = 0; position < draws; ++position) {
+        const double value = CounterRandom::uniform(42, 0, position);
+        ASSERT_GE(value, 0);
+        ASSERT_LT(value, 1);
+        sum += value;
+        const word_type bucket = CounterRandom::uniformBelow(42, 1, position, 10);
+        ASSERT_LT(bucket, 10u);
+        ++histogram[bucket];
+    }
+    EXPECT_NEAR(0.5, sum / draws, 0.01);
+    for (const word_type count : histogram) {
+        EXPECT_NEAR(draws / 10, count, draws / 100);
+    }
+}
+
+TEST(ExchangeTest, testStochasticExchangeAnnealing) {
+    const corpus_handle corpus = readAliceCorpus();
+
+//    without randomness the moves are those of Exchange, and the run ends once it converged
+    Exchange exchange(corpus);
+    const vector_word_type expected = exchange.cluster(20, 200, 0.0);
+    StochasticExchange greedy(corpus);
+    greedy.setPatience(1);
+    EXPECT_EQ(expected, greedy.cluster(20, 200, 0.0));
+    EXPECT_LT(greedy.getCompletedIterations(), 200u);
+    EXPECT_FALSE(greedy.clusterOneIteration(0.0));
+
+    StochasticExchange schedule(corpus);
+    schedule.setAnnealing(0.01, StochasticExchange::GEOMETRIC, 0.5);
+    schedule.prepareClustering(20);
+    EXPECT_DOUBLE_EQ(0.01, schedule.getTemperature());
+    schedule.clusterOneIteration();
+    schedule.clusterOneIteration();
+    EXPECT_DOUBLE_EQ(0.0025, schedule.getTemperature());
+    schedule.setAnnealing(0.01, StochasticExchange::LINEAR, 0.75);
+    EXPECT_DOUBLE_EQ(0, schedule.getTemperature());
+
+//    annealing takes other moves than Exchange, but the same ones whatever the number of threads
+    const int maxThreads = omp_get_max_threads();
+    vector<vector_word_type> results;
+    for (const int numThreads : {1, 4}) {
+        omp_set_num_threads(numThreads);
+        StochasticExchange annealing(corpus);
+        annealing.setAnnealing(0.001, StochasticExchange::GEOMETRIC, 0.5);
+        annealing.setSeed(3);
+        results.push_back(annealing.cluster(20, 4, 0.0));
+    }
+    omp_set_num_threads(maxThreads);
+    EXPECT_EQ(results[0], results[1]);
+    Exchange fourIterations(corpus);
+    EXPECT_NE(fourIterations.cluster(20, 4, 0.0), results[0]);
+
+    StochasticExchange otherSeed(corpus);
+    otherSeed.setAnnealing(0.001, StochasticExchange::GEOMETRIC, 0.5);
+    otherSeed.setSeed(4);
+    EXPECT_NE(otherSeed.cluster(20, 4, 0.0), results[0]);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "ExchangeAlgorithm/StochasticExchange/StochasticExchange.h"
+#include "TestExchangeCorpus.h"
+
+TEST(ExchangeCheckpointTest, testCheckpointRoundTrip) {
+    ExchangeCheckpoint checkpoint;
+    checkpoint.algorithm = "Exchange";
+    checkpoint.vocabularySize = 4;
+    checkpoint.numClusters = 2;
+    checkpoint.iteration = 3;
+    checkpoint.nextWordID = 1;
+    checkpoint.changesInIteration = 5;
+    checkpoint.iterationStartAMI = 0.25;
+    checkpoint.ami = 0.5;
+    checkpoint.randomState = "1 2 3";
+    checkpoint.wordsToClusters = {0, 1, 1, 0};
+    const string path = "/tmp/exchange_checkpoint.test";
+    checkpoint.writeToFile(path);
+    const ExchangeCheckpoint read = ExchangeCheckpoint::readFromFile(path);
+    EXPECT_EQ(checkpoint.algorithm, read.algorithm);
+    EXPECT_EQ(checkpoint.vocabularySize, read.vocabularySize);
+    EXPECT_EQ(checkpoint.numClusters, read.numClusters);
+    EXPECT_EQ(checkpoint.iteration, read.iteration);
+    EXPECT_EQ(checkpoint.nextWordID, read.nextWordID);
+    EXPECT_EQ(checkpoint.changesInIteration, read.changesInIteration);
+    EXPECT_EQ(checkpoint.iterationStartAMI, read.iterationStartAMI);
+    EXPECT_EQ(checkpoint.ami, read.ami);
+    EXPECT_EQ(checkpoint.randomState, read.randomState);
+    EXPECT_EQ(checkpoint.wordsToClusters, read.wordsToClusters);
+    EXPECT_THROW(ExchangeCheckpoint::readFromFile("/tmp/non/nonexistent_file"), runtime_error);
+    EXPECT_THROW(checkpoint.writeToFile("/tmp/non/nonexistent_file"), runtime_error);
+}
+
+TEST(ExchangeCheckpointTest, testResumeFromCheckpoint) {
+    const corpus_handle corpus = readAliceCorpus();
+    const string path = "/tmp/exchange_resume_checkpoint.test";
+    for (const auto &configuration : vector<pair<word_type, bool>>{{1, false}, {16, false}, {1, true}}) {
+        const word_type batchSize = configuration.first;
+        const bool activeSet = configuration.second;
+        Exchange uninterrupted(corpus);
+        uninterrupted.setSpeculativeBatchSize(batchSize);
+        uninterrupted.setActiveSetScheduling(activeSet);
+        const vector_word_type expected = uninterrupted.cluster(20, 3);
+
+//        checkpoint after the first batch of the second iteration, then abandon the run
+        Exchange interrupted(corpus);
+        interrupted.setSpeculativeBatchSize(batchSize);
+        interrupted.setActiveSetScheduling(activeSet);
+        interrupted.setCheckpointing(path, std::chrono::seconds(0));
+        interrupted.prepareClustering(20);
+        interrupted.clusterOneIteration();
+        Exchange::requestCheckpoint();
+        interrupted.clusterOneIteration();
+        const ExchangeCheckpoint checkpoint = ExchangeCheckpoint::readFromFile(path);
+        EXPECT_EQ(1u, checkpoint.iteration);
+        EXPECT_GT(checkpoint.nextWordID, 0u);
+        EXPECT_LT(checkpoint.nextWordID, corpus->vocabularySize);
+
+        Exchange resumed(corpus);
+        resumed.setSpeculativeBatchSize(batchSize);
+        resumed.setActiveSetScheduling(activeSet);
+        EXPECT_EQ(expected, resumed.cluster(checkpoint, 3));
+        EXPECT_EQ(3u, resumed.getCompletedIterations());
+        EXPECT_NEAR(uninterrupted.calculateAMI(), resumed.calculateAMI(), 1e-9);
+    }
+
+    StochasticExchange stochastic(corpus);
+    EXPECT_THROW(stochastic.resumeClustering(ExchangeCheckpoint::readFromFile(path)), runtime_error);
+}
+
+TEST(ExchangeCheckpointTest, testResumeStochasticExchange) {
+    const corpus_handle corpus = readAliceCorpus();
+    const string path = "/tmp/stochastic_exchange_checkpoint.test";
+    StochasticExchange interrupted(corpus);
+    interrupted.setRandomness(20);
+    interrupted.setCheckpointing(path, std::chrono::seconds(0));
+    interrupted.prepareClustering(20);
+    Exchange::requestCheckpoint();
+    interrupted.clusterOneIteration();
+    interrupted.clusterOneIteration();
+
+//    the random generator continues where the checkpoint left it, so the resumed run makes the same random swaps
+    StochasticExchange resumed(corpus);
+    resumed.setRandomness(20);
+    resumed.resumeClustering(ExchangeCheckpoint::readFromFile(path));
+    resumed.clusterOneIteration();
+    resumed.clusterOneIteration();
+    EXPECT_EQ(interrupted.getClusterAssignments(), resumed.getClusterAssignments());
+    EXPECT_EQ(2u, resumed.getCompletedIterations());
+}
+
+TEST(ExchangeCheckpointTest, testFailedCheckpointEndsTheRun) {
+    const corpus_handle corpus = readAliceCorpus();
+    for (const word_type batchSize : {1u, 8u}) {
+        Exchange exchange(corpus);
+        exchange.setSpeculativeBatchSize(batchSize);
+        exchange.setCheckpointing("/tmp/non/nonexistent_file", std::chrono::seconds(0));
+        exchange.prepareClustering(20);
+        Exchange::requestCheckpoint();
+        EXPECT_THROW(exchange.clusterOneIteration(), runtime_error);
+        EXPECT_EQ(0u, exchange.getCompletedIterations());
+    }
+    StochasticExchange stochasticExchange(corpus);
+    stochasticExchange.setRandomness(20);
+    stochasticExchange.setCheckpointing("/tmp/non/nonexistent_file", std::chrono::seconds(0));
+    stochasticExchange.prepareClustering(20);
+    Exchange::requestCheckpoint();
+    EXPECT_THROW(stochasticExchange.clusterOneIteration(), runtime_error);
+    EXPECT_EQ(0u, stochasticExchange.getCompletedIterations());
+}
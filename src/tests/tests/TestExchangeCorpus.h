@@ -0,0 +1,42 @@
+#ifndef BROWN_TESTEXCHANGECORPUS_H
+#define BROWN_TESTEXCHANGECORPUS_H
+
+#include "ExchangeAlgorithm/Exchange/Exchange.h"
+#include "readers/ReaderNoOrder.h"
+#include "readers/ReaderNoOrderSkip.h"
+#include "readers/ReaderFrequency.h"
+
+/**
+ * The Alice corpus of the test data, its words ordered by frequency, on which the Exchange variants are compared.
+ */
+inline corpus_handle readAliceCorpus() {
+    ReaderNoOrder readerNoOrder;
+    ReaderFrequency readerFrequency;
+    return make_shared<const Corpus>(
+            readerFrequency.reorderCorpus(readerNoOrder.readFile("tests/test_data/alice_long_tokenized.txt")));
+}
+
+/**
+ * The same skip-gram corpus twice: stored as a symmetric corpus, and with the counts of both directions.
+ */
+inline pair<corpus_handle, corpus_handle> readSymmetricAndPlainCorpus() {
+    ReaderNoOrderSkip readerNoOrderSkip;
+    ReaderFrequency readerFrequency;
+    Corpus symmetric = readerFrequency.reorderCorpus(
+            readerNoOrderSkip.readFile("tests/test_data/alice_long_tokenized.txt", 2));
+    Corpus plain = symmetric;
+    plain.setOccurrences(symmetric.occurrences, false);
+    return {make_shared<const Corpus>(std::move(symmetric)), make_shared<const Corpus>(std::move(plain))};
+}
+
+/**
+ * AMI of a clustering of the corpus, computed from scratch.
+ */
+inline double amiOfAssignments(const corpus_handle &corpus, const word_type numClusters,
+                               const vector_word_type &assignments) {
+    Exchange exchange(corpus);
+    exchange.prepareClustering(numClusters, assignments);
+    return exchange.calculateAMI();
+}
+
+#endif //BROWN_TESTEXCHANGECORPUS_H
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include "ExchangeAlgorithm/StochasticExchange/StochasticExchange.h"
+#include "TestExchangeCorpus.h"
+#include <json/json.hpp>
+#include <omp.h>
+
+TEST(ExchangeTelemetryTest, testTelemetry) {
+    const corpus_handle corpus = readAliceCorpus();
+    Exchange reference(corpus);
+    const vector_word_type expected = reference.cluster(20, 3);
+
+    const string path = "/tmp/exchange_telemetry.test";
+    std::remove(path.c_str());
+    const int maxThreads = omp_get_max_threads();
+    for (const int numThreads : {1, 3}) {
+        omp_set_num_threads(numThreads);
+        Exchange exchange(corpus);
+        exchange.setBoundPruning(true);
+        exchange.enableTelemetry(path);
+        EXPECT_EQ(expected, exchange.cluster(20, 3));
+        const vector<IterationTelemetry> &records = exchange.getTelemetry();
+        ASSERT_EQ(exchange.getCompletedIterations(), records.size());
+        uint64_t wordsEvaluated = 0;
+        uint64_t candidatesPruned = 0;
+        for (size_t i = 0; i < records.size(); ++i) {
+            EXPECT_EQ(i + 1, records[i].iteration);
+            EXPECT_EQ((word_type) numThreads, records[i].threads);
+            EXPECT_GT(records[i].scoringSeconds, 0);
+            EXPECT_GE(records[i].waitingSeconds, 0);
+            EXPECT_LE(records[i].candidatesScored + records[i].candidatesPruned,
+                      records[i].wordsEvaluated * 20);
+            wordsEvaluated += records[i].wordsEvaluated;
+            candidatesPruned += records[i].candidatesPruned;
+        }
+        EXPECT_GT(records.front().moves, 0u);
+        EXPECT_EQ(exchange.getWordsEvaluated(), wordsEvaluated);
+        EXPECT_EQ(exchange.getCandidatesPruned(), candidatesPruned);
+        EXPECT_NEAR(exchange.calculateAMI(), records.back().ami, 1e-12);
+    }
+
+//    speculative batches and StochasticExchange record their iterations as well
+    Exchange speculative(corpus);
+    speculative.setSpeculativeBatchSize(8);
+    speculative.enableTelemetry();
+    speculative.cluster(20, 2, -std::numeric_limits<double>::infinity());
+    ASSERT_EQ(2u, speculative.getTelemetry().size());
+    EXPECT_EQ(speculative.getWordsEvaluated(),
+              speculative.getTelemetry()[0].wordsEvaluated + speculative.getTelemetry()[1].wordsEvaluated);
+    StochasticExchange stochastic(corpus);
+    stochastic.setRandomness(10);
+    stochastic.enableTelemetry(path);
+    stochastic.prepareClustering(20);
+    stochastic.clusterOneIteration();
+    ASSERT_EQ(1u, stochastic.getTelemetry().size());
+    EXPECT_EQ(stochastic.getChangesInPreviousIteration(), stochastic.getTelemetry()[0].moves);
+    omp_set_num_threads(maxThreads);
+
+//    the file is appended to, one record per line
+    std::ifstream file(path);
+    string line;
+    word_type lines = 0;
+    while (getline(file, line)) {
+        const nlohmann::json record = nlohmann::json::parse(line);
+        EXPECT_GE(record["iteration"].get<word_type>(), 1u);
+        EXPECT_EQ(12u, record.size());
+        ++lines;
+    }
+    EXPECT_EQ(7u, lines);
+    EXPECT_THROW(speculative.enableTelemetry("/nonexistent/telemetry.jsonl"), runtime_error);
+
+//    a record that cannot be written ends the clustering after its iteration
+    Exchange full(corpus);
+    full.enableTelemetry("/dev/full");
+    EXPECT_THROW(full.cluster(20, 3), runtime_error);
+    EXPECT_EQ(1u, full.getTelemetry().size());
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+#include "ExchangeAlgorithm/MultilevelExchange/MultilevelExchange.h"
+#include "TestExchangeCorpus.h"
+
+TEST(MultilevelExchangeTest, testMultilevelExchange) {
+    const corpus_handle corpus = readAliceCorpus();
+    MultilevelExchange multilevel(corpus);
+    multilevel.setInitialWords(50);
+    multilevel.setGrowthFactor(3);
+    multilevel.setStageIterations(4);
+    const word_type maxIterations = 200;
+    const vector_word_type assignments = multilevel.cluster(20, maxIterations, 0.0);
+    const vector<MultilevelStage> &stages = multilevel.getStages();
+    ASSERT_GT(stages.size(), 1u);
+    EXPECT_EQ(50u, stages.front().movableWords);
+    for (size_t stage = 1; stage < stages.size(); ++stage) {
+        EXPECT_EQ(std::min<word_type>(stages[stage - 1].movableWords * 3, corpus->vocabularySize),
+                  stages[stage].movableWords);
+    }
+    for (size_t stage = 0; stage + 1 < stages.size(); ++stage) {
+        EXPECT_LE(stages[stage].iterations, 4u);
+    }
+    EXPECT_LT(stages.back().iterations, maxIterations);
+    EXPECT_EQ(corpus->vocabularySize, stages.back().movableWords);
+    EXPECT_EQ(corpus->vocabularySize, multilevel.getNumberOfMovableWords());
+    EXPECT_NEAR(stages.back().ami, multilevel.calculateAMI(), 1e-12);
+
+//    the last stage clusters the whole vocabulary to convergence
+    Exchange check(corpus);
+    check.prepareClustering(20, assignments);
+    EXPECT_NEAR(check.calculateAMI(), multilevel.calculateAMI(), 1e-9);
+    check.clusterOneIteration();
+    EXPECT_EQ(0u, check.getChangesInPreviousIteration());
+
+    multilevel.setGrowthFactor(1);
+    EXPECT_THROW(multilevel.cluster(20, maxIterations), runtime_error);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "NumaPlacement.h"
+
+TEST(NumaPlacementTest, testColumnBlocksCoverAllColumns) {
+    for (const word_type numThreads : {1u, 3u, 4u, 7u}) {
+        uint64_t next = 0;
+        for (word_type threadID = 0; threadID < numThreads; ++threadID) {
+            const pair<uint64_t, uint64_t> block = NumaPlacement::columnBlock(10, threadID, numThreads);
+            EXPECT_EQ(next, block.first);
+            EXPECT_LE(block.first, block.second);
+            next = block.second;
+        }
+        EXPECT_EQ(10u, next);
+    }
+}
+
+TEST(NumaPlacementTest, testColumnOwnerMatchesColumnBlocks) {
+    for (const uint64_t columns : {1u, 2u, 10u, 1000u}) {
+        for (const word_type numThreads : {1u, 3u, 4u, 7u}) {
+            for (word_type threadID = 0; threadID < numThreads; ++threadID) {
+                const pair<uint64_t, uint64_t> block = NumaPlacement::columnBlock(columns, threadID, numThreads);
+                for (uint64_t column = block.first; column < block.second; ++column) {
+                    EXPECT_EQ(threadID, NumaPlacement::columnOwner(columns, column, numThreads));
+                }
+            }
+        }
+    }
+}
+
+TEST(NumaPlacementTest, testFillByColumnBlocks) {
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(3);
+    for (const bool parallel : {true, false}) {
+//        several pages, so that every thread fills some of them
+        for (const uint64_t rows : {5u, 1000u}) {
+            FirstTouchMatrix<double> matrix(2, 2, 8);
+            NumaPlacement::fillByColumnBlocks(matrix, rows, 7, 1.5, parallel);
+            ASSERT_EQ(rows, matrix.getNumberOfRows());
+            ASSERT_EQ(7u, matrix.getNumberOfColumns());
+            EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(matrix.data()) % NumaPlacement::pageSize());
+            for (uint64_t row = 0; row < rows; ++row) {
+                EXPECT_EQ(vector<double>(7, 1.5), vector<double>(matrix[row], matrix[row] + 7));
+            }
+        }
+        FirstTouchMatrix<word_type> empty;
+        NumaPlacement::fillByColumnBlocks(empty, 0, 0, 2u, parallel);
+        EXPECT_TRUE(empty.empty());
+    }
+    omp_set_num_threads(maxThreads);
+}
+
+TEST(NumaPlacementTest, testReplicatePerNode) {
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    for (const bool parallel : {true, false}) {
+        const vector<vector<int>> replicas = NumaPlacement::replicatePerNode<vector<int>>([] {
+            return vector<int>{1, 2, 3};
+        }, parallel);
+        ASSERT_FALSE(replicas.empty());
+        EXPECT_EQ(vector<int>({1, 2, 3}), replicas[NumaPlacement::currentNode()]);
+        for (const vector<int> &replica : replicas) {
+            EXPECT_TRUE(replica.empty() || replica == vector<int>({1, 2, 3}));
+        }
+    }
+    omp_set_num_threads(maxThreads);
+}
+
+TEST(NumaPlacementTest, testTopology) {
+    const vector<int> cpus = NumaPlacement::cpusByNode();
+    EXPECT_FALSE(cpus.empty());
+    EXPECT_EQ(cpus.size(), set<int>(cpus.begin(), cpus.end()).size());
+    EXPECT_GE(NumaPlacement::numberOfNodes(), 1u);
+    EXPECT_LE(NumaPlacement::numberOfNodes(), cpus.size());
+}
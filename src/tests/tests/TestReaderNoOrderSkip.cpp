@@ -8,9 +8,10 @@ TEST(ReaderNoOrderSkipTest, testReadSimpleFile) {
 
     EXPECT_EQ(c.vocabularySize, 4);
     EXPECT_EQ(c.corpusLength, 14);
+    EXPECT_TRUE(c.symmetric);
     const word_type wordIDThe = 0;
     const word_type wordIDCat = 3;
-    const word_type occ1 = c.occurrences.at({wordIDThe, wordIDCat});
+    const word_type occ1 = c.getOccurrence(wordIDThe, wordIDCat);
     EXPECT_EQ(occ1, 1);
 }
 
@@ -22,10 +23,22 @@ TEST(ReaderNoOrderSkipTest, testReadSimpleFileNoSkip) {
     EXPECT_EQ(c.corpusLength, 8);
     const word_type wordIDThe = 0;
     const word_type wordIDCat = 3;
-    const word_type occ1 = c.occurrences.at({wordIDThe, wordIDCat});
+    const word_type occ1 = c.getOccurrence(wordIDThe, wordIDCat);
     EXPECT_EQ(occ1, 1);
 }
 
+TEST(ReaderNoOrderSkipTest, testWordStatistics) {
+    ReaderNoOrderSkip reader;
+    const Corpus c = reader.readFile("tests/test_data/skip_gram_1.txt", 2);
+
+    const vector_word_type expectedWordCounts = {2, 1, 1, 1};
+    const vector_word_type expectedFirstPositions = {0, 1, 2, 4};
+    EXPECT_THAT(vector_word_type(c.wordCounts.begin(), c.wordCounts.end()),
+                ::testing::ContainerEq(expectedWordCounts));
+    EXPECT_THAT(vector_word_type(c.firstPositions.begin(), c.firstPositions.end()),
+                ::testing::ContainerEq(expectedFirstPositions));
+}
+
 TEST(ReaderNoOrderSkipTest, testReadSimpleFileWithVocabulary) {
     ReaderNoOrderSkip reader;
     const Corpus c = reader.readFile("tests/test_data/skip_gram_1.txt",
@@ -36,7 +49,7 @@ TEST(ReaderNoOrderSkipTest, testReadSimpleFileWithVocabulary) {
     EXPECT_EQ(c.corpusLength, 10);
     const word_type wordIDThe = 0;
     const word_type wordIDdog = 1;
-    const word_type occ1 = c.occurrences.at({wordIDThe, wordIDdog});
+    const word_type occ1 = c.getOccurrence(wordIDThe, wordIDdog);
     EXPECT_EQ(occ1, 2);
 }
 
@@ -50,6 +63,6 @@ TEST(ReaderNoOrderSkipTest, testReadSimpleFileWithVocabularyNoSkip) {
     EXPECT_EQ(c.corpusLength, 6);
     const word_type wordIDThe = 0;
     const word_type wordIDdog = 1;
-    const word_type occ1 = c.occurrences.at({wordIDThe, wordIDdog});
+    const word_type occ1 = c.getOccurrence(wordIDThe, wordIDdog);
     EXPECT_EQ(occ1, 1);
 }
\ No newline at end of file
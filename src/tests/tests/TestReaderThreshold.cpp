@@ -34,7 +34,7 @@ TEST(ReaderThresholdTest, testReaderThresholdSimpleCorpusStrict) {
     occurrence_type expectedOccurrences = {{{0, 0}, 2},
                                            {{1, 0}, 1}
     };
-    EXPECT_THAT(filteredCorpus.occurrences, ::testing::ContainerEq(expectedOccurrences));
+    EXPECT_THAT(filteredCorpus.occurrences.toOccurrences(), ::testing::ContainerEq(expectedOccurrences));
 }
 
 TEST(ReaderThresholdTest, testReaderThresholdSimpleCorpusNotStrict) {
@@ -67,5 +67,5 @@ TEST(ReaderThresholdTest, testReaderThresholdSimpleCorpusNotStrict) {
     occurrence_type expectedOccurrences = {{{0, 0}, 2},
                                            {{1, 0}, 1}
     };
-    EXPECT_THAT(filteredCorpus.occurrences, ::testing::ContainerEq(expectedOccurrences));
+    EXPECT_THAT(filteredCorpus.occurrences.toOccurrences(), ::testing::ContainerEq(expectedOccurrences));
 }
\ No newline at end of file
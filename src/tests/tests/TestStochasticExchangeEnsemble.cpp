@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "ExchangeAlgorithm/StochasticExchange/StochasticExchange.h"
+#include "ExchangeAlgorithm/StochasticExchange/StochasticExchangeEnsemble.h"
+#include "TestExchangeCorpus.h"
+#include <omp.h>
+
+TEST(StochasticExchangeEnsembleTest, testStochasticExchangeEnsemble) {
+    const corpus_handle corpus = readAliceCorpus();
+
+//    without random swaps all chains are Exchange
+    Exchange exchange(corpus);
+    const vector_word_type expected = exchange.cluster(20, 3, -std::numeric_limits<double>::infinity());
+    StochasticExchangeEnsemble deterministic(corpus);
+    deterministic.setChains(3);
+    deterministic.setSeed(7);
+    EXPECT_EQ(expected, deterministic.cluster(20, 3));
+    EXPECT_NEAR(exchange.calculateAMI(), deterministic.calculateAMI(), 1e-9);
+
+//    a single chain is a StochasticExchange with the same seed, up to keeping its best clustering
+    StochasticExchange stochastic(corpus);
+    stochastic.setRandomness(10);
+    stochastic.setSeed(11);
+    stochastic.prepareClustering(20);
+    stochastic.clusterOneIteration();
+    StochasticExchangeEnsemble single(corpus);
+    single.setChains(1);
+    single.setRandomness(10);
+    single.setSeed(11);
+    const vector_word_type assignments = single.cluster(20, 1);
+    ASSERT_GT(stochastic.calculateAMI(), single.getChains()[0].amiProgression[0]);
+    EXPECT_EQ(stochastic.getClusterAssignments(), assignments);
+    EXPECT_EQ(11u, single.getChains()[0].seed);
+
+//    the result only depends on the seed, not on how the threads are divided among the chains
+    const int maxThreads = omp_get_max_threads();
+    vector<vector_word_type> results;
+    for (const int numThreads : {1, 3, 4}) {
+        omp_set_num_threads(numThreads);
+        StochasticExchangeEnsemble ensemble(corpus);
+        ensemble.setChains(3);
+        ensemble.setRandomness(10);
+        ensemble.setSeed(5);
+        ensemble.setAbandonMargin(std::numeric_limits<double>::infinity());
+        results.push_back(ensemble.cluster(20, 3));
+        for (const EnsembleChain &chain : ensemble.getChains()) {
+            EXPECT_FALSE(chain.abandoned);
+            EXPECT_EQ(3u, chain.iterations);
+            EXPECT_EQ(4u, chain.amiProgression.size());
+            EXPECT_LE(chain.bestAMI, ensemble.calculateAMI());
+        }
+        EXPECT_EQ(ensemble.calculateAMI(), ensemble.getChains()[ensemble.getBestChain()].bestAMI);
+    }
+    omp_set_num_threads(maxThreads);
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_EQ(results[0], results[2]);
+
+//    without margin only the leader survives the grace iterations
+    StochasticExchangeEnsemble pruned(corpus);
+    pruned.setChains(4);
+    pruned.setRandomness(10);
+    pruned.setSeed(5);
+    pruned.setAbandonMargin(0);
+    pruned.setGraceIterations(1);
+    const vector_word_type best = pruned.cluster(20, 3);
+    word_type survivors = 0;
+    for (const EnsembleChain &chain : pruned.getChains()) {
+        if (chain.abandoned) {
+            EXPECT_EQ(1u, chain.iterations);
+            EXPECT_LT(chain.bestAMI, pruned.calculateAMI());
+        } else {
+            ++survivors;
+        }
+    }
+    EXPECT_EQ(1u, survivors);
+    EXPECT_FALSE(pruned.getChains()[pruned.getBestChain()].abandoned);
+    Exchange check(corpus);
+    check.prepareClustering(20, best);
+    EXPECT_NEAR(check.calculateAMI(), pruned.calculateAMI(), 1e-9);
+
+    pruned.setChains(0);
+    EXPECT_THROW(pruned.cluster(20, 1), runtime_error);
+}
@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <models/Vocabulary.h>
+
+TEST(VocabularyTest, testBuilderAssignsIDsInOrder) {
+    Vocabulary::Builder builder;
+    EXPECT_EQ(builder.add("alice"), 0);
+    EXPECT_EQ(builder.add(""), 1);
+    EXPECT_EQ(builder.add("rabbit"), 2);
+    const Vocabulary vocabulary = builder.build();
+
+    EXPECT_EQ(vocabulary.size(), 3);
+    EXPECT_EQ(vocabulary[0], "alice");
+    EXPECT_EQ(vocabulary[1], "");
+    EXPECT_EQ(vocabulary.at(2), "rabbit");
+    EXPECT_EQ(vocabulary.characters.size(), 11);
+    EXPECT_TRUE(vocabulary == Vocabulary({"alice", "", "rabbit"}));
+    EXPECT_EQ(builder.size(), 0);
+}
+
+TEST(VocabularyTest, testAtOutOfRange) {
+    const Vocabulary vocabulary = {"a", "b"};
+    EXPECT_THROW(vocabulary.at(2), std::out_of_range);
+    EXPECT_TRUE(Vocabulary().empty());
+}
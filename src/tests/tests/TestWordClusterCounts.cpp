@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <ExchangeAlgorithm/WordClusterCounts.h>
+
+namespace {
+    BigramMatrix createContexts() {
+//        word 0 is followed by words 1, 2 and 3, word 1 by itself and word 3 by word 0
+        return BigramMatrix::fromBigrams(4, {{{0, 1}, 2},
+                                             {{0, 2}, 1},
+                                             {{0, 3}, 4},
+                                             {{1, 1}, 3},
+                                             {{3, 0}, 1}});
+    }
+
+    vector<pair_of_word_type> toVector(const WordClusterCounts &counts, const word_type wordID) {
+        vector<pair_of_word_type> result;
+        counts.forEachCluster(wordID, [&](const word_type clusterID, const word_type count) {
+            result.emplace_back(clusterID, count);
+        });
+        return result;
+    }
+}
+
+TEST(WordClusterCountsTest, testDenseAndSparseAgree) {
+    const BigramMatrix contexts = createContexts();
+    const vector_word_type wordsToClusters = {2, 0, 2, 0};
+    const WordClusterCounts dense(contexts, wordsToClusters, 3, WordClusterCounts::DENSE);
+    const WordClusterCounts sparse(contexts, wordsToClusters, 3, WordClusterCounts::SPARSE);
+    EXPECT_FALSE(dense.isSparse());
+    EXPECT_TRUE(sparse.isSparse());
+
+    const vector<pair_of_word_type> expected = {{0, 6}, {2, 1}};
+    EXPECT_THAT(toVector(dense, 0), ::testing::ContainerEq(expected));
+    EXPECT_THAT(toVector(sparse, 0), ::testing::ContainerEq(expected));
+    for (word_type wordID = 0; wordID < 4; ++wordID) {
+        for (word_type clusterID = 0; clusterID < 3; ++clusterID) {
+            EXPECT_EQ(dense.get(wordID, clusterID), sparse.get(wordID, clusterID))
+                                << "Disagreement for word " << wordID << " and cluster " << clusterID;
+        }
+    }
+    EXPECT_EQ(sparse.get(2, 0), 0);
+    EXPECT_EQ(sparse.get(3, 2), 1);
+}
+
+TEST(WordClusterCountsTest, testSparseUpdates) {
+    const BigramMatrix contexts = createContexts();
+    WordClusterCounts counts(contexts, {2, 0, 2, 0}, 3, WordClusterCounts::SPARSE);
+//    move word 3 (4 occurrences after word 0) from cluster 0 to cluster 1
+    counts.subtract(0, 0, 4);
+    counts.add(0, 1, 4);
+    EXPECT_THAT(toVector(counts, 0), ::testing::ContainerEq(vector<pair_of_word_type>({{0, 2}, {1, 4}, {2, 1}})));
+//    move word 1 to cluster 1 as well, which empties cluster 0
+    counts.subtract(0, 0, 2);
+    counts.add(0, 1, 2);
+    EXPECT_THAT(toVector(counts, 0), ::testing::ContainerEq(vector<pair_of_word_type>({{1, 6}, {2, 1}})));
+    EXPECT_EQ(counts.get(0, 0), 0);
+}
+
+TEST(WordClusterCountsTest, testChooseRepresentation) {
+    EXPECT_EQ(WordClusterCounts::chooseRepresentation(1000000, 1000, 50000000), WordClusterCounts::SPARSE);
+    EXPECT_EQ(WordClusterCounts::chooseRepresentation(100, 4, 1000), WordClusterCounts::DENSE);
+}
+
+TEST(WordClusterCountsTest, testShards) {
+    const BigramMatrix contexts = createContexts();
+    const vector_word_type wordsToClusters = {2, 0, 2, 0};
+    const WordClusterCounts all(contexts, wordsToClusters, 3, WordClusterCounts::DENSE);
+    for (word_type shard = 0; shard < 2; ++shard) {
+        WordClusterCounts counts(contexts, wordsToClusters, 3, WordClusterCounts::DENSE, shard, 2);
+        EXPECT_TRUE(counts.isSparse());
+        for (word_type wordID = 0; wordID < 4; ++wordID) {
+            if (wordID % 2 == shard) {
+                EXPECT_THAT(toVector(counts, wordID), ::testing::ContainerEq(toVector(all, wordID)));
+            } else {
+                EXPECT_TRUE(toVector(counts, wordID).empty()) << "Word " << wordID << " is not in shard " << shard;
+            }
+        }
+//        updates of rows outside the shard are ignored
+        counts.subtract(0, 0, 4);
+        counts.add(0, 1, 4);
+        counts.add(1, 0, 2);
+        EXPECT_EQ(shard == 0 ? 4u : 0u, counts.get(0, 1));
+        EXPECT_EQ(shard == 1 ? 5u : 0u, counts.get(1, 0));
+    }
+}